@@ -0,0 +1,163 @@
+/****************************************************************************************************************************
+  AsyncHTTPDispatcher_ESP.ino - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+
+  AsyncHTTPRequest_Generic is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  Version: 1.0.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+//************************************************************************************************************
+//
+// The AsyncHTTPRequest_ESP example with the dispatcher in place of the single request object.
+//
+// There sendRequest() has to check readyState() before reusing its request, and a request that
+// is still running when the Ticker fires is simply skipped.  Here sendRequest() only submits
+// the URLs: the dispatcher queues them, runs up to setMaxConcurrent() of them at once over
+// reused request objects and connections, and calls requestCB() as each one completes.
+//
+// The callback runs at Done and gets the request: read the response there, the request object
+// goes to the next queued job as soon as the callback returns.
+//
+//*************************************************************************************************************
+
+#if !( defined(ESP8266) ||  defined(ESP32) )
+  #error This code is intended to run on the ESP8266 or ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+// Level from 0-4
+#define ASYNC_HTTP_DEBUG_PORT     Serial
+#define _ASYNC_HTTP_LOGLEVEL_     1
+
+// 300s = 5 minutes to not flooding
+#define HTTP_REQUEST_INTERVAL     300
+
+// 10s
+#define HEARTBEAT_INTERVAL        10
+
+int status;     // the Wifi radio's status
+
+const char* ssid        = "your_ssid";
+const char* password    = "your_pass";
+
+const char* zones[] = { "America/Toronto", "Europe/London", "Asia/Tokyo", "Australia/Sydney" };
+
+#if (ESP8266)
+  #include <ESP8266WiFi.h>
+#elif (ESP32)
+  #include <WiFi.h>
+#endif
+
+#include <AsyncHTTPDispatcher.h>
+#include <Ticker.h>
+
+AsyncHTTPDispatcher dispatcher;
+Ticker ticker;
+Ticker heartbeat;
+
+void heartBeatPrint(void)
+{
+  static int num = 1;
+
+  if (WiFi.status() == WL_CONNECTED)
+    Serial.print(F("H"));        // H means connected to WiFi
+  else
+    Serial.print(F("F"));        // F means not connected to WiFi
+
+  if (num == 80)
+  {
+    Serial.println();
+    num = 1;
+  }
+  else if (num++ % 10 == 0)
+  {
+    Serial.print(F(" "));
+  }
+}
+
+void requestCB(void* optParm, AsyncHTTPRequest* request)
+{
+  Serial.println("\n**************************************");
+  Serial.println((const char*) optParm);
+
+  if (request->responseHTTPcode() == 200)
+    Serial.println(request->responseText());
+  else
+    Serial.println("Failed, code = " + String(request->responseHTTPcode()));
+
+  Serial.println("**************************************");
+}
+
+void sendRequest()
+{
+  // No readyState() checks: jobs wait in the dispatcher's queue until a request object is free
+  for (const char* zone : zones)
+  {
+    auto url = parseURL(String("http://worldtimeapi.org/api/timezone/") + zone + ".txt");
+
+    if ( ! url || ! dispatcher.submit(*url, requestCB, (void*) zone))
+      Serial.println("Can't queue " + String(zone));
+  }
+}
+
+void setup()
+{
+  // put your setup code here, to run once:
+  Serial.begin(115200);
+  while (!Serial);
+
+  Serial.println("\nStarting AsyncHTTPDispatcher_ESP using " + String(ARDUINO_BOARD));
+
+  WiFi.mode(WIFI_STA);
+
+  if (WiFi.status() == WL_NO_SHIELD)
+  {
+    Serial.println(F("WiFi shield not present"));
+    // don't continue
+    while (true);
+  }
+
+  WiFi.begin(ssid, password);
+
+  Serial.println("Connecting to WiFi SSID: " + String(ssid));
+
+  while (WiFi.status() != WL_CONNECTED)
+  {
+    delay(500);
+    Serial.print(".");
+  }
+
+  Serial.print(F("\nHTTP WebServer is @ IP : "));
+  Serial.println(WiFi.localIP());
+
+  // Two at a time, both may go to the same host
+  dispatcher.setMaxConcurrent(2);
+  dispatcher.setMaxPerHost(2);
+
+  ticker.attach(HTTP_REQUEST_INTERVAL, sendRequest);
+
+  heartbeat.attach(HEARTBEAT_INTERVAL, heartBeatPrint);
+
+  // Send first requests now
+  sendRequest();
+}
+
+void loop()
+{
+}
@@ -0,0 +1,1993 @@
+/****************************************************************************************************************************
+  AsyncHTTP2Session.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+
+#include "AsyncHTTPRequest.h"
+
+namespace {
+#if ESP32
+class LockHelper
+{
+public:
+    LockHelper(QueueHandle_t _xMutex) :
+        xMutex{_xMutex}
+    {
+        xSemaphoreTakeRecursive(xMutex, portMAX_DELAY);
+    }
+    ~LockHelper()
+    {
+        xSemaphoreGiveRecursive(xMutex);
+    }
+
+private:
+    const QueueHandle_t xMutex;
+};
+#define _lock LockHelper lock{this->threadLock}
+#else
+#define _lock
+#endif
+
+enum : uint8_t
+{
+  DATA          = 0x0,
+  HEADERS       = 0x1,
+  PRIORITY      = 0x2,
+  RST_STREAM    = 0x3,
+  SETTINGS      = 0x4,
+  PUSH_PROMISE  = 0x5,
+  PING          = 0x6,
+  GOAWAY        = 0x7,
+  WINDOW_UPDATE = 0x8,
+  CONTINUATION  = 0x9
+};
+
+enum : uint8_t
+{
+  FLAG_END_STREAM  = 0x01,
+  FLAG_ACK         = 0x01,
+  FLAG_END_HEADERS = 0x04,
+  FLAG_PADDED      = 0x08,
+  FLAG_PRIORITY    = 0x20
+};
+
+enum : uint32_t
+{
+  NO_ERROR            = 0x0,
+  PROTOCOL_ERROR      = 0x1,
+  FLOW_CONTROL_ERROR  = 0x3,
+  FRAME_SIZE_ERROR    = 0x6,
+  REFUSED_STREAM      = 0x7,
+  CANCEL              = 0x8,
+  COMPRESSION_ERROR   = 0x9,
+  ENHANCE_YOUR_CALM   = 0xb
+};
+
+const char preface[] PROGMEM = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+// HPACK static table (RFC 7541 appendix A), entries 1 to 61 as name and value, each ending in a NUL
+const char staticTable[] PROGMEM =
+  ":authority\0" "\0"             ":method\0" "GET\0"             ":method\0" "POST\0"
+  ":path\0" "/\0"                 ":path\0" "/index.html\0"       ":scheme\0" "http\0"
+  ":scheme\0" "https\0"           ":status\0" "200\0"             ":status\0" "204\0"
+  ":status\0" "206\0"             ":status\0" "304\0"             ":status\0" "400\0"
+  ":status\0" "404\0"             ":status\0" "500\0"             "accept-charset\0" "\0"
+  "accept-encoding\0" "gzip, deflate\0"                           "accept-language\0" "\0"
+  "accept-ranges\0" "\0"          "accept\0" "\0"                 "access-control-allow-origin\0" "\0"
+  "age\0" "\0"                    "allow\0" "\0"                  "authorization\0" "\0"
+  "cache-control\0" "\0"          "content-disposition\0" "\0"    "content-encoding\0" "\0"
+  "content-language\0" "\0"       "content-length\0" "\0"         "content-location\0" "\0"
+  "content-range\0" "\0"          "content-type\0" "\0"           "cookie\0" "\0"
+  "date\0" "\0"                   "etag\0" "\0"                   "expect\0" "\0"
+  "expires\0" "\0"                "from\0" "\0"                   "host\0" "\0"
+  "if-match\0" "\0"               "if-modified-since\0" "\0"      "if-none-match\0" "\0"
+  "if-range\0" "\0"               "if-unmodified-since\0" "\0"    "last-modified\0" "\0"
+  "link\0" "\0"                   "location\0" "\0"               "max-forwards\0" "\0"
+  "proxy-authenticate\0" "\0"     "proxy-authorization\0" "\0"    "range\0" "\0"
+  "referer\0" "\0"                "refresh\0" "\0"                "retry-after\0" "\0"
+  "server\0" "\0"                 "set-cookie\0" "\0"             "strict-transport-security\0" "\0"
+  "transfer-encoding\0" "\0"      "user-agent\0" "\0"             "vary\0" "\0"
+  "via\0" "\0"                    "www-authenticate\0" "\0";
+
+#define H2_STATIC_ENTRIES   61
+
+// HPACK Huffman code (RFC 7541 appendix B) in canonical form: how many codes there are of each length
+// in bits, and the symbols in code order. Index 256 would be EOS, which never appears in a string.
+const uint8_t huffmanCounts[31] PROGMEM =
+{
+  0, 0, 0, 0, 0, 10, 26, 32, 6, 0, 5, 3, 2, 6, 2, 3, 0, 0, 0, 3, 8, 13, 26, 29, 12, 4, 15, 19, 29, 0, 4
+};
+
+const uint8_t huffmanSymbols[256] PROGMEM =
+{
+  0x30, 0x31, 0x32, 0x61, 0x63, 0x65, 0x69, 0x6f, 0x73, 0x74, 0x20, 0x25, 0x2d, 0x2e, 0x2f, 0x33,
+  0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3d, 0x41, 0x5f, 0x62, 0x64, 0x66, 0x67, 0x68, 0x6c, 0x6d,
+  0x6e, 0x70, 0x72, 0x75, 0x3a, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c,
+  0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x59, 0x6a, 0x6b, 0x71, 0x76,
+  0x77, 0x78, 0x79, 0x7a, 0x26, 0x2a, 0x2c, 0x3b, 0x58, 0x5a, 0x21, 0x22, 0x28, 0x29, 0x3f, 0x27,
+  0x2b, 0x7c, 0x23, 0x3e, 0x00, 0x24, 0x40, 0x5b, 0x5d, 0x7e, 0x5e, 0x7d, 0x3c, 0x60, 0x7b, 0x5c,
+  0xc3, 0xd0, 0x80, 0x82, 0x83, 0xa2, 0xb8, 0xc2, 0xe0, 0xe2, 0x99, 0xa1, 0xa7, 0xac, 0xb0, 0xb1,
+  0xb3, 0xd1, 0xd8, 0xd9, 0xe3, 0xe5, 0xe6, 0x81, 0x84, 0x85, 0x86, 0x88, 0x92, 0x9a, 0x9c, 0xa0,
+  0xa3, 0xa4, 0xa9, 0xaa, 0xad, 0xb2, 0xb5, 0xb9, 0xba, 0xbb, 0xbd, 0xbe, 0xc4, 0xc6, 0xe4, 0xe8,
+  0xe9, 0x01, 0x87, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8f, 0x93, 0x95, 0x96, 0x97, 0x98, 0x9b, 0x9d,
+  0x9e, 0xa5, 0xa6, 0xa8, 0xae, 0xaf, 0xb4, 0xb6, 0xb7, 0xbc, 0xbf, 0xc5, 0xe7, 0xef, 0x09, 0x8e,
+  0x90, 0x91, 0x94, 0x9f, 0xab, 0xce, 0xd7, 0xe1, 0xec, 0xed, 0xc7, 0xcf, 0xea, 0xeb, 0xc0, 0xc1,
+  0xc8, 0xc9, 0xca, 0xcd, 0xd2, 0xd5, 0xda, 0xdb, 0xee, 0xf0, 0xf2, 0xf3, 0xff, 0xcb, 0xcc, 0xd3,
+  0xd4, 0xd6, 0xdd, 0xde, 0xdf, 0xf1, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe,
+  0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x0b, 0x0c, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14,
+  0x15, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x7f, 0xdc, 0xf9, 0x0a, 0x0d, 0x16
+};
+
+// Compares a string of the static table with s and moves past it
+bool staticEquals(const char* &p, const String &s)
+{
+  bool   equal = true;
+  size_t i = 0;
+
+  for (char c; (c = pgm_read_byte(p++)); i++)
+    equal = equal && i < s.length() && c == s[i];
+
+  return equal && i == s.length();
+}
+
+// Reads a string of the static table and moves past it
+String staticString(const char* &p)
+{
+  String s;
+
+  for (char c; (c = pgm_read_byte(p++)); )
+    s += c;
+
+  return s;
+}
+
+uint32_t read32(const uint8_t* p)
+{
+  return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+void write32(uint8_t* p, uint32_t value)
+{
+  p[0] = value >> 24;
+  p[1] = value >> 16;
+  p[2] = value >> 8;
+  p[3] = value;
+}
+}
+
+// Largest frame taken from the server (its default SETTINGS_MAX_FRAME_SIZE, never raised)
+#define H2_MAX_FRAME        16384
+
+// HPACK dynamic table for the server's response headers, in bytes as HPACK counts them
+#define H2_HEADER_TABLE     512
+
+// Largest response header list taken, announced as SETTINGS_MAX_HEADER_LIST_SIZE. Caps the header block as it
+// arrives across CONTINUATION frames, and the fields decoded from it (name, value and 32 each, as HTTP/2 counts)
+#define H2_MAX_HEADER_LIST  8192
+
+// Connection level receive window, given back once half of it has been used
+#define H2_CONNECTION_WINDOW  65535
+
+// A request is sent again at most this many times after the connection was lost or its stream refused
+#define H2_MAX_REPLAYS      2
+
+//**************************************************************************************************************
+AsyncHTTP2Session::AsyncHTTP2Session()
+{
+  _out     = new xbuf;
+  _payload = new xbuf;
+  _block   = new xbuf;
+  _tableMax = H2_HEADER_TABLE;
+}
+
+//**************************************************************************************************************
+AsyncHTTP2Session::~AsyncHTTP2Session()
+{
+  // Requests still on it can't complete any more
+  while (_streams)
+  {
+    stream* s = _streams;
+    _streams = s->next;
+    s->next = nullptr;
+
+    AsyncHTTPRequest* request = s->request;
+    delete s;
+
+    if ( ! request)
+      continue;
+
+    request->_h2 = false;
+    request->_session = nullptr;
+    request->_onDisconnect(nullptr);
+  }
+
+  if (_client)
+  {
+    _client->onDisconnect(nullptr, nullptr);
+    _client->onPoll(nullptr, nullptr);
+    _client->onData(nullptr, nullptr);
+    _client->onAck(nullptr, nullptr);
+    _client->onError(nullptr, nullptr);
+    _client->close(true);
+    delete _client;
+  }
+
+  delete _out;
+  delete _payload;
+  delete _block;
+  delete _table;
+
+#ifdef ESP32
+  vSemaphoreDelete(threadLock);
+#endif
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::begin(const String &host, int port)
+{
+  _lock;
+
+  if (_client && (port != _port || ! host.equalsIgnoreCase(_host)))
+    close();
+
+  _host = host;
+  _port = port;
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::setMaxStreams(uint8_t streams)
+{
+  _maxStreams = streams ? streams : 1;
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::setStreamWindow(uint32_t bytes)
+{
+  // Announced to the server on the next connection, budgets of open streams follow at once
+  _window = bytes < 1 ? 1 : (bytes > 0x7FFFFFFF ? 0x7FFFFFFF : bytes);
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::close()
+{
+  _lock;
+
+  if ( ! _client)
+    return;
+
+  if (connected())
+  {
+    uint8_t payload[8] = { 0 };
+
+    _frame(GOAWAY, 0, 0, payload, sizeof(payload));
+    _flush();
+  }
+
+  _client->close();
+}
+
+//**************************************************************************************************************
+bool AsyncHTTP2Session::connected() const
+{
+  return _client && _client->connected();
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTP2Session::active() const
+{
+  size_t count = 0;
+
+  for (stream* s = _streams; s; s = s->next)
+    if (s->id)
+      count++;
+
+  return count;
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTP2Session::queued() const
+{
+  size_t count = 0;
+
+  for (stream* s = _streams; s; s = s->next)
+    if ( ! s->id)
+      count++;
+
+  return count;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTP2Session::_accepts(const String &host, int port) const
+{
+  return _host.length() && port == _port && host.equalsIgnoreCase(_host);
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_enqueue(AsyncHTTPRequest* request)
+{
+  _lock;
+
+  if (_find(request))
+    return;
+
+  stream* tail = (stream*) &_streams;
+
+  while (tail->next)
+    tail = tail->next;
+
+  tail->next = new stream;
+  tail->next->request = request;
+
+  AHTTP_LOGDEBUG3("h2 enqueue", request->_URL.path, ", queued =", queued());
+
+  if ( ! _client)
+    _connect();
+  else if (_client->connected())
+    request->_onConnect(nullptr);
+}
+
+//**************************************************************************************************************
+bool AsyncHTTP2Session::_queued(const AsyncHTTPRequest* request) const
+{
+  stream* s = _find(request);
+
+  return s && ! s->id;
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTP2Session::_write(AsyncHTTPRequest* request)
+{
+  _lock;
+
+  stream* s = _find(request);
+
+  if ( ! s || ! connected() || ! request->_request)
+    return 0;
+
+  size_t sent = 0;
+
+  if ( ! s->id)
+  {
+    // A new stream only while the server takes them, and no more at once than either side allows
+    size_t limit = _peerStreams < _maxStreams ? _peerStreams : _maxStreams;
+
+    if (_goaway || active() >= limit)
+      return 0;
+
+    int end = request->_request->indexOf("\r\n\r\n");
+
+    if (end < 0)
+      return 0;
+
+    String head = request->_request->readString(end + 4);
+
+    if (request->_replay)
+      request->_replay->write(head);
+
+    if (request->_sent)
+      request->_sent->write(head);
+
+    sent += head.length();
+
+    s->id         = _nextId;
+    s->sendWindow = _peerWindow;
+    s->recvWindow = _window;
+    _nextId += 2;
+    _opened++;
+
+    AHTTP_LOGDEBUG3("h2 stream", s->id, "opened for", request->_URL.path);
+
+    xbuf block;
+    _encode(&block, head);
+
+    // The header block in as many frames as it takes, the last one says it is all there
+    bool     last  = ! request->_request->available();
+    size_t   left  = block.available();
+    uint8_t* temp  = new uint8_t[left ? left : 1];
+    uint8_t* p     = temp;
+    uint8_t  type  = HEADERS;
+    uint8_t  flags = last ? FLAG_END_STREAM : 0;
+
+    block.read(temp, left);
+
+    do
+    {
+      size_t len = left < _peerFrame ? left : _peerFrame;
+      left -= len;
+
+      _frame(type, flags | (left ? 0 : FLAG_END_HEADERS), s->id, p, len);
+
+      p += len;
+      type  = CONTINUATION;
+      flags = 0;
+    } while (left);
+
+    delete[] temp;
+
+    // A budget larger than the window every stream starts with is granted straight away
+    _replenish(s);
+
+    if (last)
+    {
+      s->sentEnd = true;
+      _flush();
+      request->_allSent();
+
+      return sent;
+    }
+  }
+
+  // The body, as far as the windows and the room on the connection go
+  _flush();
+
+  while ( ! s->sentEnd && ! _out->available())
+  {
+    size_t len  = request->_request->available();
+    size_t room = _client->space();
+
+    if (room <= 9)
+      break;
+
+    room -= 9;
+
+    if (len > room)
+      len = room;
+
+    if (len > _peerFrame)
+      len = _peerFrame;
+
+    if ((int32_t) len > s->sendWindow)
+      len = s->sendWindow > 0 ? s->sendWindow : 0;
+
+    if ((int32_t) len > _sendWindow)
+      len = _sendWindow > 0 ? _sendWindow : 0;
+
+    if ( ! len)
+      break;
+
+    uint8_t* temp = new uint8_t[len];
+    request->_request->read(temp, len);
+
+    if (request->_replay)
+      request->_replay->write(temp, len);
+
+    if (request->_sent)
+      request->_sent->write(temp, len);
+
+    bool last = ! request->_request->available();
+
+    _frame(DATA, last ? FLAG_END_STREAM : 0, s->id, temp, len);
+    _flush();
+
+    delete[] temp;
+
+    s->sendWindow -= len;
+    _sendWindow -= len;
+    sent += len;
+
+    if (last)
+    {
+      s->sentEnd = true;
+      request->_allSent();
+    }
+  }
+
+  AHTTP_LOGDEBUG3("h2 stream", s->id, "sent", sent);
+
+  return sent;
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_consumed(AsyncHTTPRequest* request)
+{
+  _lock;
+
+  stream* s = _find(request);
+
+  if ( ! s)
+    return;
+
+  _replenish(s);
+  _flush();
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_finished(AsyncHTTPRequest* request)
+{
+  _lock;
+
+  stream* s = _find(request);
+
+  if ( ! s)
+    return;
+
+  if (s->id && ! s->sentEnd)
+  {
+    // Answered before it was all sent, the rest isn't wanted
+    uint8_t error[4];
+
+    write32(error, CANCEL);
+    _frame(RST_STREAM, 0, s->id, error, sizeof(error));
+    _unlink(s);
+  }
+  else
+  {
+    // Still open until the server ends it, usually in the frame that completed the response
+    s->request = nullptr;
+  }
+
+  _pump();
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_remove(AsyncHTTPRequest* request)
+{
+  _lock;
+
+  stream* s = _find(request);
+
+  if ( ! s)
+    return;
+
+  // On the wire: the server stops working on it, the connection carries on
+  if (s->id && connected())
+  {
+    uint8_t error[4];
+
+    write32(error, CANCEL);
+    _frame(RST_STREAM, 0, s->id, error, sizeof(error));
+  }
+
+  _unlink(s);
+  _pump();
+}
+
+//**************************************************************************************************************
+bool AsyncHTTP2Session::_connect()
+{
+  AHTTP_LOGDEBUG3("h2 connect", _host, ":", _port);
+
+  _reset();
+
+  _client = new AsyncClient();
+
+  _client->onConnect([](void *obj, AsyncClient * client)
+  {
+    ((AsyncHTTP2Session*)(obj))->_onConnect(client);
+  }, this);
+
+  _client->onDisconnect([](void *obj, AsyncClient * client)
+  {
+    ((AsyncHTTP2Session*)(obj))->_onDisconnect(client);
+  }, this);
+
+  _client->onPoll([](void *obj, AsyncClient * client)
+  {
+    ((AsyncHTTP2Session*)(obj))->_onPoll(client);
+  }, this);
+
+  _client->onError([](void *obj, AsyncClient * client, uint32_t error)
+  {
+    ((AsyncHTTP2Session*)(obj))->_onError(client, error);
+  }, this);
+
+  _client->onAck([](void* obj, AsyncClient * client, size_t len, uint32_t time)
+  {
+    ((AsyncHTTP2Session*)(obj))->_pump();
+  }, this);
+
+  _client->onData([](void* obj, AsyncClient * client, void* data, size_t len)
+  {
+    ((AsyncHTTP2Session*)(obj))->_onData(data, len);
+  }, this);
+
+  if (_client->connect(_host.c_str(), _port))
+    return true;
+
+  AHTTP_LOGDEBUG3("h2 connect failed:", _host, ",", _port);
+
+  delete _client;
+  _client = nullptr;
+
+  // Nothing queued can be sent
+  while (_streams)
+  {
+    stream* s = _streams;
+    _streams = s->next;
+    s->next = nullptr;
+
+    AsyncHTTPRequest* request = s->request;
+    delete s;
+
+    if (request)
+      request->_onDisconnect(nullptr);
+  }
+
+  return false;
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_reset()
+{
+  // Everything that belongs to one connection
+  _out->flush();
+  _payload->flush();
+  _block->flush();
+
+  delete _table;
+
+  _table       = nullptr;
+  _tableSize   = 0;
+  _tableMax    = H2_HEADER_TABLE;
+  _headLen     = 0;
+  _frameRead   = 0;
+  _chunkOpen   = false;
+  _blockStream = 0;
+  _closing     = false;
+  _goaway      = false;
+  _nextId      = 1;
+  _peerStreams = UINT32_MAX;
+  _peerWindow  = 65535;
+  _peerFrame   = 16384;
+  _sendWindow  = 65535;
+  _recvUnacked = 0;
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_pump()
+{
+  _lock;
+
+  if ( ! connected())
+    return;
+
+  _flush();
+
+  // Streams in the order queued: new ones open as others end, bodies go out as the windows allow
+  for (size_t i = 0; stream* s = _at(i); i++)
+  {
+    if (s->request && s->request->_request)
+      s->request->_send();
+  }
+
+  // The server is going away: once nothing is open on it, what waits goes on a new connection
+  if (_goaway && ! active() && _client)
+    _client->close();
+}
+
+//**************************************************************************************************************
+AsyncHTTP2Session::stream* AsyncHTTP2Session::_find(const AsyncHTTPRequest* request) const
+{
+  for (stream* s = _streams; s; s = s->next)
+    if (s->request == request)
+      return s;
+
+  return nullptr;
+}
+
+//**************************************************************************************************************
+AsyncHTTP2Session::stream* AsyncHTTP2Session::_find(uint32_t id) const
+{
+  if ( ! id)
+    return nullptr;
+
+  for (stream* s = _streams; s; s = s->next)
+    if (s->id == id)
+      return s;
+
+  return nullptr;
+}
+
+//**************************************************************************************************************
+AsyncHTTP2Session::stream* AsyncHTTP2Session::_at(size_t index) const
+{
+  // By position, for walks that call into requests: those may take streams out of the list meanwhile
+  stream* s = _streams;
+
+  while (s && index--)
+    s = s->next;
+
+  return s;
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_unlink(stream* s)
+{
+  for (stream* prev = (stream*) &_streams; prev->next; prev = prev->next)
+  {
+    if (prev->next != s)
+      continue;
+
+    prev->next = s->next;
+    s->next = nullptr;
+    delete s;
+
+    return;
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_resend(stream* s)
+{
+  AHTTP_LOGDEBUG1("h2 resending stream", s->id);
+
+  s->id      = 0;
+  s->sentEnd = false;
+  s->started = false;
+  s->chunked = false;
+  s->replays++;
+  _replays++;
+
+  s->request->_rewind();
+
+  // On this connection if it still takes new streams, otherwise on the next one
+  if ( ! _goaway && connected())
+    s->request->_onConnect(nullptr);
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_replenish(stream* s)
+{
+  if ( ! s->id || ! s->request)
+    return;
+
+  AsyncHTTPRequest* request = s->request;
+
+  // Budget: what the request may hold unread; a stream without a limit of its own is bounded all the same
+  size_t budget = request->_maxResponseLength ? request->_maxResponseLength : _window;
+
+  if (request->_streaming && ! request->_maxResponseLength && budget > STREAM_MAX_BUFFERED)
+    budget = STREAM_MAX_BUFFERED;
+
+  if (budget > 0x7FFFFFFF)
+    budget = 0x7FFFFFFF;
+
+  size_t  unread = request->_response ? request->_response->available() : 0;
+  int32_t target = unread < budget ? budget - unread : 0;
+
+  if (target <= s->recvWindow)
+    return;
+
+  // Not a frame for every few bytes read, unless the server has nothing left to send with
+  int32_t increment = target - s->recvWindow;
+
+  if (increment < (int32_t) (budget / 4) && s->recvWindow > 0)
+    return;
+
+  _windowUpdate(s->id, increment);
+  s->recvWindow += increment;
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_deliver(uint32_t id, const void* data, size_t len)
+{
+  stream* s = _find(id);
+
+  if ( ! s || ! s->request)
+    return;
+
+  s->request->_onData((void*) data, len);
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_end(uint32_t id)
+{
+  stream* s = _find(id);
+
+  if ( ! s)
+    return;
+
+  AHTTP_LOGDEBUG1("h2 stream ended", id);
+
+  // The last chunk of a body without a length
+  if (s->chunked)
+  {
+    s->chunked = false;
+    _deliver(id, "0\r\n\r\n", 5);
+
+    if ( ! (s = _find(id)))
+      return;
+  }
+
+  AsyncHTTPRequest* request = s->request;
+
+  if ( ! s->sentEnd)
+  {
+    uint8_t error[4];
+
+    write32(error, CANCEL);
+    _frame(RST_STREAM, 0, id, error, sizeof(error));
+  }
+
+  _unlink(s);
+
+  // Still attached, the response fell short of what it said it would be
+  if (request && request->_readyState != ReadyState::Done)
+    request->_onDisconnect(nullptr);
+
+  _pump();
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_frame(uint8_t type, uint8_t flags, uint32_t id, const uint8_t* payload, size_t len)
+{
+  uint8_t head[9];
+
+  head[0] = len >> 16;
+  head[1] = len >> 8;
+  head[2] = len;
+  head[3] = type;
+  head[4] = flags;
+  write32(head + 5, id);
+
+  _out->write(head, sizeof(head));
+
+  if (len)
+    _out->write(payload, len);
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_windowUpdate(uint32_t id, uint32_t increment)
+{
+  uint8_t payload[4];
+
+  write32(payload, increment);
+  _frame(WINDOW_UPDATE, 0, id, payload, sizeof(payload));
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_fail(uint32_t error)
+{
+  AHTTP_LOGDEBUG1("h2 connection error", error);
+
+  // The server never opens streams, none of its own were processed
+  uint8_t payload[8] = { 0 };
+
+  write32(payload + 4, error);
+  _frame(GOAWAY, 0, 0, payload, sizeof(payload));
+
+  _closing = true;
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_flush()
+{
+  if ( ! connected() || ! _out->available() || ! _client->canSend())
+    return;
+
+  size_t len  = _out->available();
+  size_t room = _client->space();
+
+  if (len > room)
+    len = room;
+
+  if ( ! len)
+    return;
+
+  uint8_t* temp = new uint8_t[len];
+
+  _out->read(temp, len);
+  _client->add((char*) temp, len);
+  _client->send();
+
+  delete[] temp;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTP2Session::_frameBegin()
+{
+  _frameLen    = ((uint32_t) _head[0] << 16) | ((uint32_t) _head[1] << 8) | _head[2];
+  _frameType   = _head[3];
+  _frameFlags  = _head[4];
+  _frameStream = read32(_head + 5) & 0x7FFFFFFF;
+  _frameRead   = 0;
+  _framePad    = 0;
+  _chunkOpen   = false;
+
+  _payload->flush();
+
+  if (_frameLen > H2_MAX_FRAME)
+  {
+    _fail(FRAME_SIZE_ERROR);
+
+    return false;
+  }
+
+  // Nothing may come between the frames of a header block
+  if (_blockStream ? (_frameType != CONTINUATION || _frameStream != _blockStream) : _frameType == CONTINUATION)
+  {
+    _fail(PROTOCOL_ERROR);
+
+    return false;
+  }
+
+  if (_frameType != DATA)
+    return true;
+
+  if ( ! _frameStream || ((_frameFlags & FLAG_PADDED) && ! _frameLen))
+  {
+    _fail(PROTOCOL_ERROR);
+
+    return false;
+  }
+
+  // Padding counts against the windows as much as the data does
+  _recvUnacked += _frameLen;
+
+  stream* s = _find(_frameStream);
+
+  if (s && (s->recvWindow -= _frameLen) < 0)
+  {
+    _fail(FLOW_CONTROL_ERROR);
+
+    return false;
+  }
+
+  return true;
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_frameEnd()
+{
+  _headLen = 0;
+
+  switch (_frameType)
+  {
+  case DATA:
+    if (_chunkOpen)
+      _deliver(_frameStream, "\r\n", 2);
+
+    _chunkOpen = false;
+
+    if (_frameFlags & FLAG_END_STREAM)
+    {
+      _end(_frameStream);
+    }
+    else
+    {
+      stream* s = _find(_frameStream);
+
+      if (s)
+        _replenish(s);
+    }
+
+    // All of it was handed on as it came, the connection window only has to keep up
+    if (_recvUnacked >= H2_CONNECTION_WINDOW / 2)
+    {
+      _windowUpdate(0, _recvUnacked);
+      _recvUnacked = 0;
+    }
+
+    break;
+
+  case HEADERS:
+  case CONTINUATION:
+    _headers();
+    break;
+
+  case SETTINGS:
+    _settings();
+    break;
+
+  case RST_STREAM:
+    _resetStream();
+    break;
+
+  case GOAWAY:
+    _goAway();
+    break;
+
+  case PING:
+    if (_frameLen != 8)
+    {
+      _fail(FRAME_SIZE_ERROR);
+    }
+    else if ( ! (_frameFlags & FLAG_ACK))
+    {
+      uint8_t payload[8];
+
+      _payload->read(payload, sizeof(payload));
+      _frame(PING, FLAG_ACK, 0, payload, sizeof(payload));
+    }
+
+    break;
+
+  case WINDOW_UPDATE:
+    if (_frameLen != 4)
+    {
+      _fail(FRAME_SIZE_ERROR);
+    }
+    else
+    {
+      uint8_t payload[4];
+
+      _payload->read(payload, sizeof(payload));
+
+      uint32_t increment = read32(payload) & 0x7FFFFFFF;
+      stream*  s = _find(_frameStream);
+
+      if ( ! _frameStream)
+        _sendWindow += increment;
+      else if (s)
+        s->sendWindow += increment;
+
+      _pump();
+    }
+
+    break;
+
+  case PUSH_PROMISE:
+    // Push was turned off in our SETTINGS
+    _fail(PROTOCOL_ERROR);
+    break;
+
+  default:
+    // PRIORITY and anything unknown are of no concern to a client
+    break;
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_data(const uint8_t* data, size_t len)
+{
+  uint32_t offset = _frameRead;
+
+  // Pad length first, then the data, then the padding
+  if ((_frameFlags & FLAG_PADDED) && offset == 0)
+  {
+    _framePad = data[0];
+
+    if (_framePad >= _frameLen)
+    {
+      _fail(PROTOCOL_ERROR);
+
+      return;
+    }
+
+    data++;
+    len--;
+    offset++;
+  }
+
+  uint32_t begin = (_frameFlags & FLAG_PADDED) ? 1 : 0;
+  uint32_t end   = _frameLen - _framePad;
+
+  if (offset >= end)
+    return;
+
+  if (offset + len > end)
+    len = end - offset;
+
+  stream* s = _find(_frameStream);
+
+  // Only for a response under way; anything else is for a stream already given up
+  if ( ! len || ! s || ! s->request || ! s->started)
+    return;
+
+  if (s->chunked && ! _chunkOpen)
+  {
+    String size = String(end - begin, HEX) + "\r\n";
+
+    _chunkOpen = true;
+    _deliver(_frameStream, size.c_str(), size.length());
+  }
+
+  _deliver(_frameStream, data, len);
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_headers()
+{
+  size_t   len = _payload->available();
+  uint8_t* buf = new uint8_t[len ? len : 1];
+  uint8_t* p   = buf;
+  uint8_t* end = buf + len;
+  bool     ok  = true;
+
+  _payload->read(buf, len);
+
+  if (_frameType == HEADERS)
+  {
+    uint8_t pad = 0;
+
+    if (_frameFlags & FLAG_PADDED)
+    {
+      ok  = p < end;
+      pad = ok ? *p++ : 0;
+    }
+
+    // Priority is the server's business
+    if (_frameFlags & FLAG_PRIORITY)
+    {
+      ok = ok && end - p >= 5;
+      p += ok ? 5 : 0;
+    }
+
+    ok = ok && _frameStream && end - p >= pad;
+    end -= ok ? pad : 0;
+
+    _blockStream = _frameStream;
+    _blockEnd    = _frameFlags & FLAG_END_STREAM;
+  }
+
+  // However many frames it comes in, a block larger than the server was told is not held on to
+  bool large = ok && _block->available() + (end - p) > H2_MAX_HEADER_LIST;
+
+  if (ok && ! large)
+    _block->write(p, end - p);
+
+  delete[] buf;
+
+  if ( ! ok)
+  {
+    _fail(PROTOCOL_ERROR);
+
+    return;
+  }
+
+  if (large)
+  {
+    AHTTP_LOGDEBUG1("h2 header block too large, stream", _blockStream);
+
+    _fail(ENHANCE_YOUR_CALM);
+
+    return;
+  }
+
+  if ( ! (_frameFlags & FLAG_END_HEADERS))
+    return;
+
+  uint32_t id = _blockStream;
+  bool     endStream = _blockEnd;
+
+  _blockStream = 0;
+
+  // Decoded even for a stream given up, the table has to stay in step with the server's
+  if ( ! _decode(id, endStream))
+  {
+    _fail(COMPRESSION_ERROR);
+
+    return;
+  }
+
+  if (_closing)
+    return;
+
+  if (endStream)
+    _end(id);
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_settings()
+{
+  if (_frameStream || ((_frameFlags & FLAG_ACK) && _frameLen))
+  {
+    _fail(PROTOCOL_ERROR);
+
+    return;
+  }
+
+  if (_frameFlags & FLAG_ACK)
+    return;
+
+  if (_frameLen % 6)
+  {
+    _fail(FRAME_SIZE_ERROR);
+
+    return;
+  }
+
+  while (_payload->available() >= 6)
+  {
+    uint8_t entry[6];
+
+    _payload->read(entry, sizeof(entry));
+
+    uint16_t id    = ((uint16_t) entry[0] << 8) | entry[1];
+    uint32_t value = read32(entry + 2);
+
+    switch (id)
+    {
+    case 0x3:
+      // SETTINGS_MAX_CONCURRENT_STREAMS
+      _peerStreams = value;
+      break;
+
+    case 0x4:
+      // SETTINGS_INITIAL_WINDOW_SIZE, open streams move by the difference
+      if (value > 0x7FFFFFFF)
+      {
+        _fail(FLOW_CONTROL_ERROR);
+
+        return;
+      }
+
+      for (stream* s = _streams; s; s = s->next)
+        if (s->id)
+          s->sendWindow += (int32_t) value - _peerWindow;
+
+      _peerWindow = value;
+      break;
+
+    case 0x5:
+      // SETTINGS_MAX_FRAME_SIZE
+      if (value < 16384 || value > 16777215)
+      {
+        _fail(PROTOCOL_ERROR);
+
+        return;
+      }
+
+      _peerFrame = value;
+      break;
+
+    default:
+      // Its header table only matters to an encoder that indexes, and push is off
+      break;
+    }
+  }
+
+  _frame(SETTINGS, FLAG_ACK, 0, nullptr, 0);
+  _pump();
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_goAway()
+{
+  if (_frameStream || _frameLen < 8)
+  {
+    _fail(PROTOCOL_ERROR);
+
+    return;
+  }
+
+  uint8_t payload[8];
+
+  _payload->read(payload, sizeof(payload));
+
+  uint32_t last = read32(payload) & 0x7FFFFFFF;
+
+  AHTTP_LOGDEBUG3("h2 GOAWAY, last stream", last, ", error", read32(payload + 4));
+
+  _goaway = true;
+
+  // Streams past the last one were never looked at, they go again on the next connection
+  stream*  failed = nullptr;
+  stream** fail = &failed;
+
+  for (stream* prev = (stream*) &_streams; prev->next; )
+  {
+    stream* s = prev->next;
+
+    if (s->id <= last)
+    {
+      prev = s;
+    }
+    else if (s->request && s->replays < H2_MAX_REPLAYS)
+    {
+      _resend(s);
+      prev = s;
+    }
+    else
+    {
+      prev->next = s->next;
+      s->next = nullptr;
+      *fail = s;
+      fail = &s->next;
+    }
+  }
+
+  while (failed)
+  {
+    stream* s = failed;
+    failed = s->next;
+    s->next = nullptr;
+
+    AsyncHTTPRequest* request = s->request;
+    delete s;
+
+    if (request)
+      request->_onDisconnect(nullptr);
+  }
+
+  _pump();
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_resetStream()
+{
+  if ( ! _frameStream || _frameLen != 4)
+  {
+    _fail(_frameStream ? FRAME_SIZE_ERROR : PROTOCOL_ERROR);
+
+    return;
+  }
+
+  uint8_t payload[4];
+
+  _payload->read(payload, sizeof(payload));
+
+  uint32_t error = read32(payload);
+  stream*  s = _find(_frameStream);
+
+  if ( ! s)
+    return;
+
+  AHTTP_LOGDEBUG3("h2 RST_STREAM", _frameStream, ", error", error);
+
+  AsyncHTTPRequest* request = s->request;
+
+  // Refused before any work was done on it, it may simply be sent again
+  if (request && error == REFUSED_STREAM && ! s->started && s->replays < H2_MAX_REPLAYS)
+  {
+    _resend(s);
+
+    return;
+  }
+
+  _unlink(s);
+
+  if (request)
+    request->_onDisconnect(nullptr);
+
+  _pump();
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_encode(xbuf* block, const String &head)
+{
+  // Request line first: method and target, which become pseudo-header fields along with the host
+  int    lineEnd = head.indexOf("\r\n");
+  String line    = head.substring(0, lineEnd);
+  int    space   = line.indexOf(' ');
+  String authority;
+  xbuf   fields;
+
+  for (int beg = lineEnd + 2, end; (end = head.indexOf("\r\n", beg)) > beg; beg = end + 2)
+  {
+    String field = head.substring(beg, end);
+    int    colon = field.indexOf(':');
+
+    if (colon < 0)
+      continue;
+
+    String name  = field.substring(0, colon);
+    String value = field.substring(colon + 1);
+
+    name.trim();
+    name.toLowerCase();
+    value.trim();
+
+    if (name == "host")
+    {
+      authority = value;
+      continue;
+    }
+
+    // What is about this one connection has no meaning on a stream
+    if (name == "connection" || name == "keep-alive" || name == "proxy-connection" || name == "transfer-encoding" ||
+        name == "upgrade" || (name == "te" && value != "trailers"))
+    {
+      continue;
+    }
+
+    _encodeField(&fields, name, value);
+  }
+
+  _encodeField(block, ":method", line.substring(0, space));
+  _encodeField(block, ":scheme", "http");
+  _encodeField(block, ":path", line.substring(space + 1, line.lastIndexOf(' ')));
+  _encodeField(block, ":authority", authority.length() ? authority : _host + ':' + _port);
+
+  block->write(&fields, fields.available());
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_encodeField(xbuf* block, const String &name, const String &value)
+{
+  // The whole field from the static table if it is there, otherwise its name; never added to the server's table
+  const char* p = staticTable;
+  uint32_t    index = 0;
+
+  for (uint32_t i = 1; i <= H2_STATIC_ENTRIES; i++)
+  {
+    bool sameName  = staticEquals(p, name);
+    bool sameValue = staticEquals(p, value);
+
+    if (sameName && sameValue)
+    {
+      _writeInteger(block, 0x80, 7, i);
+
+      return;
+    }
+
+    if (sameName && ! index)
+      index = i;
+  }
+
+  _writeInteger(block, 0x00, 4, index);
+
+  if ( ! index)
+    _writeString(block, name);
+
+  _writeString(block, value);
+}
+
+//**************************************************************************************************************
+bool AsyncHTTP2Session::_decode(uint32_t id, bool endStream)
+{
+  size_t         len = _block->available();
+  uint8_t*       buf = new uint8_t[len ? len : 1];
+  const uint8_t* p   = buf;
+  const uint8_t* end = buf + len;
+  bool           ok  = true;
+  bool           length = false;
+  size_t         list = 0;
+  String         status;
+  String         head;
+
+  _block->read(buf, len);
+
+  while (ok && p < end)
+  {
+    String   name;
+    String   value;
+    uint32_t index;
+
+    if (*p & 0x80)
+    {
+      // Indexed field
+      ok = _integer(p, end, 7, index) && index && _field(index, name, value);
+    }
+    else if (*p & 0x40)
+    {
+      // Literal, added to the table
+      ok = _integer(p, end, 6, index) && (index ? _field(index, name, value) : _string(p, end, name)) &&
+           _string(p, end, value);
+
+      if (ok)
+        _insert(name, value);
+    }
+    else if (*p & 0x20)
+    {
+      // Table size update, within what our SETTINGS allow
+      ok = _integer(p, end, 5, index) && index <= H2_HEADER_TABLE;
+
+      if (ok)
+      {
+        _tableMax = index;
+        _evict(_tableMax);
+      }
+
+      continue;
+    }
+    else
+    {
+      // Literal, not indexed or never indexed
+      ok = _integer(p, end, 4, index) && (index ? _field(index, name, value) : _string(p, end, name)) &&
+           _string(p, end, value);
+    }
+
+    if ( ! ok)
+      break;
+
+    // A few bytes of block can stand for much more out of the table
+    list += name.length() + value.length() + 32;
+
+    if (list > H2_MAX_HEADER_LIST)
+      break;
+
+    if (name == ":status")
+    {
+      status = value;
+    }
+    else if (name[0] == ':' || (endStream && name == "content-length"))
+    {
+      continue;
+    }
+    else
+    {
+      length = length || name == "content-length";
+      head += name + ": " + value + "\r\n";
+    }
+  }
+
+  delete[] buf;
+
+  if ( ! ok)
+    return false;
+
+  // The connection goes, as for a block too large to take: the table can't follow the server's any more
+  if (list > H2_MAX_HEADER_LIST)
+  {
+    AHTTP_LOGDEBUG1("h2 header list too large, stream", id);
+
+    _fail(ENHANCE_YOUR_CALM);
+
+    return true;
+  }
+
+  stream* s = _find(id);
+
+  if ( ! s || ! s->request)
+    return true;
+
+  String message;
+
+  if (s->started)
+  {
+    // Trailers, after the last chunk of a body without a length; otherwise of no use
+    if ( ! s->chunked)
+      return true;
+
+    s->chunked = false;
+    message = "0\r\n" + head + "\r\n";
+  }
+  else
+  {
+    int code = status.toInt();
+
+    if (code < 100 || code > 999)
+    {
+      AHTTP_LOGDEBUG1("h2 response without a status, stream", id);
+
+      uint8_t error[4];
+      AsyncHTTPRequest* request = s->request;
+
+      write32(error, PROTOCOL_ERROR);
+      _frame(RST_STREAM, 0, id, error, sizeof(error));
+      _unlink(s);
+
+      request->_onDisconnect(nullptr);
+
+      return true;
+    }
+
+    // Handed on as HTTP/1.1: a body the stream ends without a length in front comes in chunks
+    if (code >= 200)
+    {
+      s->started = true;
+
+      if (endStream)
+      {
+        head += "content-length: 0\r\n";
+      }
+      else if ( ! length)
+      {
+        s->chunked = true;
+        head += "transfer-encoding: chunked\r\n";
+      }
+    }
+
+    message = "HTTP/1.1 " + status + " \r\n" + head + "\r\n";
+  }
+
+  _deliver(id, message.c_str(), message.length());
+
+  if ((s = _find(id)))
+    _replenish(s);
+
+  return true;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTP2Session::_field(uint32_t index, String &name, String &value) const
+{
+  if (index <= H2_STATIC_ENTRIES)
+  {
+    const char* p = staticTable;
+
+    // Past the entries before it, two strings each
+    for (uint32_t i = 1; i < index * 2 - 1; i++)
+      while (pgm_read_byte(p++));
+
+    name  = staticString(p);
+    value = staticString(p);
+
+    return true;
+  }
+
+  index -= H2_STATIC_ENTRIES + 1;
+
+  for (field* f = _table; f; f = f->next)
+  {
+    if (index--)
+      continue;
+
+    name  = f->name;
+    value = f->value;
+
+    return true;
+  }
+
+  return false;
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_insert(const String &name, const String &value)
+{
+  size_t size = name.length() + value.length() + 32;
+
+  // Larger than the whole table: it only empties it
+  _evict(size < _tableMax ? _tableMax - size : 0);
+
+  if (size > _tableMax)
+    return;
+
+  field* f = new field;
+
+  f->name  = name;
+  f->value = value;
+  f->next  = _table;
+
+  _table = f;
+  _tableSize += size;
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_evict(size_t max)
+{
+  // Oldest first, from the end of the list
+  while (_tableSize > max)
+  {
+    field** last = &_table;
+
+    while ((*last)->next)
+      last = &(*last)->next;
+
+    _tableSize -= (*last)->name.length() + (*last)->value.length() + 32;
+
+    delete *last;
+    *last = nullptr;
+  }
+}
+
+//**************************************************************************************************************
+bool AsyncHTTP2Session::_integer(const uint8_t* &p, const uint8_t* end, uint8_t prefix, uint32_t &value)
+{
+  if (p >= end)
+    return false;
+
+  uint8_t mask = (1 << prefix) - 1;
+
+  value = *p++ & mask;
+
+  if (value < mask)
+    return true;
+
+  // Seven bits at a time, least significant first; far more than any header needs is an error
+  for (uint8_t shift = 0; p < end && shift <= 21; shift += 7)
+  {
+    uint8_t b = *p++;
+
+    value += (uint32_t) (b & 0x7F) << shift;
+
+    if ( ! (b & 0x80))
+      return true;
+  }
+
+  return false;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTP2Session::_string(const uint8_t* &p, const uint8_t* end, String &s)
+{
+  if (p >= end)
+    return false;
+
+  bool     huffman = *p & 0x80;
+  uint32_t len;
+
+  if ( ! _integer(p, end, 7, len) || len > (uint32_t) (end - p))
+    return false;
+
+  // Replaces whatever the name's table entry brought along as its value
+  s = "";
+
+  if (huffman)
+  {
+    if ( ! _huffman(p, len, s))
+      return false;
+  }
+  else
+  {
+    s.reserve(len);
+
+    for (uint32_t i = 0; i < len; i++)
+      s += (char) p[i];
+  }
+
+  p += len;
+
+  return true;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTP2Session::_huffman(const uint8_t* p, size_t len, String &s)
+{
+  // Canonical decoding: codes of each length follow on from the shorter ones, counts say where each length ends
+  int32_t  code  = 0;
+  int32_t  first = 0;
+  int32_t  index = 0;
+  uint8_t  bits  = 0;
+  bool     ones  = true;
+
+  s.reserve(len * 8 / 5);
+
+  for (size_t i = 0; i < len; i++)
+  {
+    for (int8_t b = 7; b >= 0; b--)
+    {
+      uint8_t bit   = (p[i] >> b) & 1;
+      int32_t count = pgm_read_byte(&huffmanCounts[++bits]);
+
+      code |= bit;
+      ones  = ones && bit;
+
+      if (code - count < first)
+      {
+        index += code - first;
+
+        // EOS in the string
+        if (index >= 256)
+          return false;
+
+        s += (char) pgm_read_byte(&huffmanSymbols[index]);
+
+        code = first = index = bits = 0;
+        ones = true;
+
+        continue;
+      }
+
+      if (bits == 30)
+        return false;
+
+      index += count;
+      first  = (first + count) << 1;
+      code <<= 1;
+    }
+  }
+
+  // Padding: the start of EOS, all ones and shorter than a byte
+  return bits < 8 && ones;
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_writeInteger(xbuf* block, uint8_t flags, uint8_t prefix, uint32_t value)
+{
+  uint8_t mask = (1 << prefix) - 1;
+
+  if (value < mask)
+  {
+    block->write((uint8_t) (flags | value));
+
+    return;
+  }
+
+  block->write((uint8_t) (flags | mask));
+  value -= mask;
+
+  while (value >= 0x80)
+  {
+    block->write((uint8_t) ((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+
+  block->write((uint8_t) value);
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_writeString(xbuf* block, const String &s)
+{
+  // As it is, Huffman coding would only save a little on the few headers a request has
+  _writeInteger(block, 0x00, 7, s.length());
+  block->write(s);
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_onConnect(AsyncClient* client)
+{
+  AHTTP_LOGDEBUG("h2 _onConnect");
+
+  _lock;
+
+  // Connection preface, then our settings: a small header table, no push, the window each stream starts with,
+  // and the largest header list we take
+  uint8_t settings[24];
+
+  settings[0]  = 0;
+  settings[1]  = 0x1;
+  write32(settings + 2, H2_HEADER_TABLE);
+  settings[6]  = 0;
+  settings[7]  = 0x2;
+  write32(settings + 8, 0);
+  settings[12] = 0;
+  settings[13] = 0x4;
+  write32(settings + 14, _window);
+  settings[18] = 0;
+  settings[19] = 0x6;
+  write32(settings + 20, H2_MAX_HEADER_LIST);
+
+  for (const char* p = preface; pgm_read_byte(p); p++)
+    _out->write((uint8_t) pgm_read_byte(p));
+
+  _frame(SETTINGS, 0, 0, settings, sizeof(settings));
+  _flush();
+
+  for (size_t i = 0; stream* s = _at(i); i++)
+  {
+    if (s->request)
+      s->request->_onConnect(nullptr);
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_onDisconnect(AsyncClient* client)
+{
+  AHTTP_LOGDEBUG1("h2 _onDisconnect, active =", active());
+
+  _lock;
+
+  _client = nullptr;
+
+  // Requests that have none of their response are sent again, the rest end here
+  stream*  streams = _streams;
+  stream*  failed = nullptr;
+  stream** keep = &_streams;
+  stream** fail = &failed;
+
+  _streams = nullptr;
+
+  while (streams)
+  {
+    stream* s = streams;
+    streams = s->next;
+    s->next = nullptr;
+
+    AsyncHTTPRequest* request = s->request;
+
+    if ( ! request)
+    {
+      delete s;
+    }
+    else if (request->_HTTPcode < 0 || s->started || (s->id && s->replays >= H2_MAX_REPLAYS))
+    {
+      *fail = s;
+      fail = &s->next;
+    }
+    else
+    {
+      if (s->id)
+        _resend(s);
+
+      *keep = s;
+      keep = &s->next;
+    }
+  }
+
+  _reset();
+
+  delete client;
+
+  if (_streams)
+    _connect();
+
+  // Completion callbacks last, requests they send go behind the ones being resent
+  while (failed)
+  {
+    stream* s = failed;
+    failed = s->next;
+    s->next = nullptr;
+
+    AsyncHTTPRequest* request = s->request;
+    delete s;
+
+    request->_onDisconnect(nullptr);
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_onData(void* data, size_t len)
+{
+  _lock;
+
+  AsyncClient*   client = _client;
+  const uint8_t* p = (const uint8_t*) data;
+
+  // Frames as they come, whatever way the segments cut them; a lost connection ends the walk
+  while (len && _client == client && ! _closing)
+  {
+    if (_headLen < sizeof(_head))
+    {
+      size_t n = sizeof(_head) - _headLen;
+
+      if (n > len)
+        n = len;
+
+      memcpy(_head + _headLen, p, n);
+      _headLen += n;
+      p += n;
+      len -= n;
+
+      if (_headLen < sizeof(_head) || ! _frameBegin())
+        continue;
+    }
+    else
+    {
+      size_t n = _frameLen - _frameRead;
+
+      if (n > len)
+        n = len;
+
+      if (_frameType == DATA)
+        _data(p, n);
+      else
+        _payload->write(p, n);
+
+      _frameRead += n;
+      p += n;
+      len -= n;
+    }
+
+    if (_frameRead == _frameLen && _client == client && ! _closing)
+      _frameEnd();
+  }
+
+  _flush();
+
+  if (_closing && _client)
+    _client->close();
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_onPoll(AsyncClient* client)
+{
+  _lock;
+
+  _flush();
+
+  // Every stream carries its own deadlines
+  for (size_t i = 0; stream* s = _at(i); i++)
+  {
+    if (s->request)
+      s->request->_onPoll(client);
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTP2Session::_onError(AsyncClient* client, int8_t error)
+{
+  AHTTP_LOGDEBUG1("h2 _onError handler error =", error);
+
+  _lock;
+
+  // Ends every request on the connection, none are sent again into the same failure
+  for (stream* s = _streams; s; s = s->next)
+  {
+    if (s->request)
+      s->request->_onError(client, error);
+  }
+}
@@ -0,0 +1,195 @@
+/****************************************************************************************************************************
+  AsyncHTTP2Session.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+#pragma once
+
+#include <Arduino.h>
+#include <WString.h>
+
+#define H2_STREAM_WINDOW    4096                  // Response bytes a request may be sent before reading any, unless its max response length says
+
+class AsyncClient;
+class AsyncHTTPRequest;
+class xbuf;
+
+//! One HTTP/2 cleartext connection (h2c, prior knowledge) to a single origin, on which requests run
+//! concurrently, each on a stream of its own. Requests opt in with setHTTP2(). They are still built and
+//! parsed as HTTP/1.1: the session frames each request as HEADERS and DATA, and hands the response back
+//! as the HTTP/1.1 message it stands for, so everything a request does with a response works unchanged.
+//! Response headers are HPACK decoded with a small dynamic table, Huffman coded strings included; request
+//! headers go out as literals against the static table, which needs no table of our own.
+//! A stream's receive window is the request's response budget: the server sends no more than the request
+//! can hold unread, and more as the application reads it, so a slow reader holds back only its own stream.
+//! If the connection is lost or the server goes away, requests that have none of their response yet are
+//! sent again on a new connection.
+class AsyncHTTP2Session
+{
+    struct stream
+    {
+      stream*           next{};
+      AsyncHTTPRequest* request{};                // nullptr once the request is done with it, until the server ends it too
+      uint32_t          id{0};                    // 0 until its HEADERS go out
+      int32_t           sendWindow{0};            // request body the server takes before a WINDOW_UPDATE
+      int32_t           recvWindow{0};            // response the server may still send
+      bool              sentEnd{false};           // END_STREAM sent, the request is all out
+      bool              started{false};           // final response headers received
+      bool              chunked{false};           // no Content-Length: the body is handed on as chunks
+      uint8_t           replays{0};               // times sent again after the connection was lost
+
+      ~stream()
+      {
+        delete next;
+      }
+    };
+
+    struct field
+    {
+      field*            next{};
+      String            name;
+      String            value;
+
+      ~field()
+      {
+        delete next;
+      }
+    };
+
+  public:
+    AsyncHTTP2Session();
+    ~AsyncHTTP2Session();
+
+    void          begin(const String &host, int port = 80);             // Origin served by this session
+    void          setMaxStreams(uint8_t streams);                       // Requests in flight at once (default 4, fewer if the server says)
+    void          setStreamWindow(uint32_t bytes);                      // Response budget of requests without a max response length
+    void          close();                                              // GOAWAY and drop the connection, unanswered requests are resent
+
+    const String& host() const        { return _host; }
+    int           port() const        { return _port; }
+    bool          connected() const;
+    size_t        active() const;                                       // streams open on the connection
+    size_t        queued() const;                                       // requests waiting for a stream
+    uint32_t      opened() const      { return _opened; }               // streams opened, all connections
+    uint32_t      replays() const     { return _replays; }              // requests resent after a lost connection or refused stream
+    size_t        tableSize() const   { return _tableSize; }            // HPACK dynamic table in use (bytes)
+
+  private:
+    String        _host;
+    int           _port{80};
+    uint8_t       _maxStreams{4};
+    uint32_t      _window{H2_STREAM_WINDOW};
+    uint32_t      _opened{0};
+    uint32_t      _replays{0};
+    AsyncClient*  _client{nullptr};
+    stream*       _streams{nullptr};              // in order queued
+    xbuf*         _out{nullptr};                  // frames waiting for room on the connection
+    bool          _closing{false};                // GOAWAY sent, the connection goes once the frame is out
+    bool          _goaway{false};                 // server is going away, no new streams on this connection
+    uint32_t      _nextId{1};
+    uint32_t      _peerStreams{UINT32_MAX};       // SETTINGS_MAX_CONCURRENT_STREAMS
+    int32_t       _peerWindow{65535};             // SETTINGS_INITIAL_WINDOW_SIZE, send window of new streams
+    uint32_t      _peerFrame{16384};              // SETTINGS_MAX_FRAME_SIZE
+    int32_t       _sendWindow{65535};             // connection level, request bodies
+    uint32_t      _recvUnacked{0};                // connection level, received and not given back yet
+
+    // Frame being received
+    uint8_t       _head[9];
+    uint8_t       _headLen{0};
+    uint32_t      _frameLen{0};
+    uint8_t       _frameType{0};
+    uint8_t       _frameFlags{0};
+    uint32_t      _frameStream{0};
+    uint32_t      _frameRead{0};
+    uint8_t       _framePad{0};
+    bool          _chunkOpen{false};              // chunk header handed on for this DATA frame
+    xbuf*         _payload{nullptr};              // of frames other than DATA, which pass through as they come
+    xbuf*         _block{nullptr};                // header block, until its last CONTINUATION
+    uint32_t      _blockStream{0};
+    bool          _blockEnd{false};               // ... and whether its HEADERS ended the stream
+
+    // HPACK decoder
+    field*        _table{nullptr};                // dynamic table, newest first
+    size_t        _tableSize{0};
+    size_t        _tableMax{0};
+
+#ifdef ESP32
+    SemaphoreHandle_t threadLock{xSemaphoreCreateRecursiveMutex()};
+#endif
+
+    // Used by AsyncHTTPRequest
+    bool          _accepts(const String &host, int port) const;
+    void          _enqueue(AsyncHTTPRequest* request);
+    bool          _queued(const AsyncHTTPRequest* request) const;
+    size_t        _write(AsyncHTTPRequest* request);
+    void          _consumed(AsyncHTTPRequest* request);
+    void          _finished(AsyncHTTPRequest* request);
+    void          _remove(AsyncHTTPRequest* request);
+
+    bool          _connect();
+    void          _reset();
+    void          _pump();
+    stream*       _find(const AsyncHTTPRequest* request) const;
+    stream*       _find(uint32_t id) const;
+    stream*       _at(size_t index) const;
+    void          _unlink(stream* s);
+    void          _resend(stream* s);
+    void          _replenish(stream* s);
+    void          _deliver(uint32_t id, const void* data, size_t len);
+    void          _end(uint32_t id);
+
+    void          _frame(uint8_t type, uint8_t flags, uint32_t id, const uint8_t* payload, size_t len);
+    void          _windowUpdate(uint32_t id, uint32_t increment);
+    void          _fail(uint32_t error);
+    void          _flush();
+
+    bool          _frameBegin();
+    void          _frameEnd();
+    void          _data(const uint8_t* data, size_t len);
+    void          _headers();
+    void          _settings();
+    void          _goAway();
+    void          _resetStream();
+
+    // HPACK
+    void          _encode(xbuf* block, const String &head);
+    void          _encodeField(xbuf* block, const String &name, const String &value);
+    bool          _decode(uint32_t id, bool endStream);
+    bool          _field(uint32_t index, String &name, String &value) const;
+    void          _insert(const String &name, const String &value);
+    void          _evict(size_t max);
+    static bool   _integer(const uint8_t* &p, const uint8_t* end, uint8_t prefix, uint32_t &value);
+    static bool   _string(const uint8_t* &p, const uint8_t* end, String &s);
+    static bool   _huffman(const uint8_t* p, size_t len, String &s);
+    static void   _writeInteger(xbuf* block, uint8_t flags, uint8_t prefix, uint32_t value);
+    static void   _writeString(xbuf* block, const String &s);
+
+    void          _onConnect(AsyncClient* client);
+    void          _onDisconnect(AsyncClient* client);
+    void          _onData(void* data, size_t len);
+    void          _onPoll(AsyncClient* client);
+    void          _onError(AsyncClient* client, int8_t error);
+
+    friend class AsyncHTTPRequest;
+};
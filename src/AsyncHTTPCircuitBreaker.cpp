@@ -0,0 +1,268 @@
+/****************************************************************************************************************************
+  AsyncHTTPCircuitBreaker.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+
+#include "AsyncHTTPRequest.h"
+
+namespace {
+#if ESP32
+class LockHelper
+{
+public:
+    LockHelper(QueueHandle_t _xMutex) :
+        xMutex{_xMutex}
+    {
+        xSemaphoreTakeRecursive(xMutex, portMAX_DELAY);
+    }
+    ~LockHelper()
+    {
+        xSemaphoreGiveRecursive(xMutex);
+    }
+
+private:
+    const QueueHandle_t xMutex;
+};
+#define _lock LockHelper lock{this->threadLock}
+#else
+#define _lock
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPCircuitBreaker::AsyncHTTPCircuitBreaker()
+{
+}
+
+//**************************************************************************************************************
+AsyncHTTPCircuitBreaker::~AsyncHTTPCircuitBreaker()
+{
+  delete _origins;
+
+#ifdef ESP32
+  vSemaphoreDelete(threadLock);
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPCircuitBreaker& AsyncHTTPCircuitBreaker::instance()
+{
+  static AsyncHTTPCircuitBreaker breaker;
+
+  return breaker;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPCircuitBreaker::setFailureThreshold(uint8_t failures)
+{
+  _threshold = failures ? failures : 1;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPCircuitBreaker::setOpenTime(uint32_t ms)
+{
+  _openTime = ms;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPCircuitBreaker::allow(const String &host, int port)
+{
+  _lock;
+
+  entry* e = _find(host, port);
+
+  if ( ! e || e->state == CircuitState::Closed)
+    return true;
+
+  if ((millis() - e->since) < _openTime)
+  {
+    AHTTP_LOGDEBUG3("circuit open, failing fast", host, ":", port);
+
+    _rejected++;
+
+    return false;
+  }
+
+  // Open long enough, or the last probe never reported back: let one through
+  AHTTP_LOGDEBUG3("circuit half-open, probing", host, ":", port);
+
+  e->state = CircuitState::HalfOpen;
+  e->since = millis();
+
+  return true;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPCircuitBreaker::record(const String &host, int port, int code)
+{
+  if (isFailure(code))
+    failure(host, port);
+  else if (code > 0)
+    success(host, port);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPCircuitBreaker::success(const String &host, int port)
+{
+  _lock;
+
+  // A healthy origin needs no entry
+  for (entry* prev = (entry*) &_origins; prev->next; prev = prev->next)
+  {
+    entry* e = prev->next;
+
+    if (e->port != port || ! e->host.equalsIgnoreCase(host))
+      continue;
+
+    if (e->state != CircuitState::Closed)
+      AHTTP_LOGDEBUG3("circuit closed", host, ":", port);
+
+    prev->next = e->next;
+    e->next = nullptr;
+    delete e;
+
+    return;
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTPCircuitBreaker::failure(const String &host, int port)
+{
+  _lock;
+
+  entry* e = nullptr;
+  entry* tail = (entry*) &_origins;
+  uint8_t count = 0;
+
+  // Take it out if it is there, it goes back in last
+  while (tail->next)
+  {
+    if (tail->next->port == port && tail->next->host.equalsIgnoreCase(host))
+    {
+      e = tail->next;
+      tail->next = e->next;
+      e->next = nullptr;
+    }
+    else
+    {
+      tail = tail->next;
+      count++;
+    }
+  }
+
+  if ( ! e)
+  {
+    if (count >= CIRCUIT_MAX_ORIGINS)
+    {
+      entry* oldest = _origins;
+      _origins = oldest->next;
+      oldest->next = nullptr;
+      delete oldest;
+      tail = (entry*) &_origins;
+
+      while (tail->next)
+        tail = tail->next;
+    }
+
+    e = new entry;
+    e->host = host;
+    e->port = port;
+  }
+
+  tail->next = e;
+
+  // The probe failed: stay open for another round
+  if (e->state == CircuitState::HalfOpen)
+    _open(e);
+  // Otherwise a request let through before the circuit opened
+  else if (e->state == CircuitState::Closed && ++e->failures >= _threshold)
+    _open(e);
+}
+
+//**************************************************************************************************************
+CircuitState AsyncHTTPCircuitBreaker::state(const String &host, int port)
+{
+  _lock;
+
+  entry* e = _find(host, port);
+
+  return e ? e->state : CircuitState::Closed;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPCircuitBreaker::reset()
+{
+  _lock;
+
+  delete _origins;
+  _origins = nullptr;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPCircuitBreaker::isFailure(int code)
+{
+  switch (code)
+  {
+  // Local conditions, they say nothing about the origin
+  case HttpCode::TOO_LESS_RAM:
+  case HttpCode::ENCODING:
+  case HttpCode::STREAM_WRITE:
+  case HttpCode::DIGEST_MISMATCH:
+  case HttpCode::RESPONSE_TOO_LARGE:
+  case HttpCode::CIRCUIT_OPEN:
+    return false;
+
+  case 502:
+  case 503:
+  case 504:
+    return true;
+  }
+
+  // Any other error is the connection or the server failing
+  return code < 0;
+}
+
+//**************************************************************************************************************
+AsyncHTTPCircuitBreaker::entry* AsyncHTTPCircuitBreaker::_find(const String &host, int port)
+{
+  for (entry* e = _origins; e; e = e->next)
+  {
+    if (e->port == port && e->host.equalsIgnoreCase(host))
+      return e;
+  }
+
+  return nullptr;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPCircuitBreaker::_open(entry* e)
+{
+  AHTTP_LOGDEBUG3("circuit opened", e->host, ":", e->port);
+
+  e->state    = CircuitState::Open;
+  e->since    = millis();
+  e->failures = 0;
+  _trips++;
+}
@@ -0,0 +1,97 @@
+/****************************************************************************************************************************
+  AsyncHTTPCircuitBreaker.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+#pragma once
+
+#include <Arduino.h>
+#include <WString.h>
+
+#define CIRCUIT_MAX_ORIGINS       8               // origins whose state is tracked
+
+enum class CircuitState : uint8_t
+{
+  Closed,                                         // requests go through
+  Open,                                           // requests fail fast with HttpCode::CIRCUIT_OPEN
+  HalfOpen                                        // one probe is let through, its outcome decides
+};
+
+//! Per origin (host:port) circuit breaker, so a dead backend fails fast instead of holding sockets and RAM
+//! for the full connect timeout on every request. After failureThreshold consecutive failures the circuit opens:
+//! requests to the origin complete at once with HttpCode::CIRCUIT_OPEN. After openTime one probe request is let
+//! through (half-open); success closes the circuit, failure opens it for another openTime. A probe that never
+//! reports back is replaced by another one after openTime.
+//! Failures are transport errors (not connected, lost, timed out) and 502/503/504; any other response is success.
+class AsyncHTTPCircuitBreaker
+{
+    struct entry
+    {
+      entry*        next{};
+      String        host;
+      int           port{0};
+      CircuitState  state{CircuitState::Closed};
+      uint8_t       failures{0};                  // consecutive
+      uint32_t      since{0};                     // millis() when opened, or when the probe went out
+
+      ~entry()
+      {
+        delete next;
+      }
+    };
+
+  public:
+    AsyncHTTPCircuitBreaker();
+    ~AsyncHTTPCircuitBreaker();
+
+    static AsyncHTTPCircuitBreaker& instance();                         // The shared breaker
+
+    void          setFailureThreshold(uint8_t failures);                // Consecutive failures that open a circuit (default 5)
+    void          setOpenTime(uint32_t ms);                             // Open this long before a probe, and between probes (default 10s)
+
+    bool          allow(const String &host, int port);                  // May a request go to the origin now
+    void          record(const String &host, int port, int code);       // Outcome of a request that was allowed
+    void          success(const String &host, int port);
+    void          failure(const String &host, int port);
+    CircuitState  state(const String &host, int port);
+    void          reset();                                              // Close every circuit
+
+    static bool   isFailure(int code);                                  // Does code count against the origin
+    uint32_t      rejected() const    { return _rejected; }             // requests failed fast
+    uint32_t      trips() const       { return _trips; }                // times a circuit opened
+
+  private:
+    entry*        _origins{nullptr};              // least recently failed first
+    uint8_t       _threshold{5};
+    uint32_t      _openTime{10000};
+    uint32_t      _rejected{0};
+    uint32_t      _trips{0};
+
+#ifdef ESP32
+    SemaphoreHandle_t threadLock{xSemaphoreCreateRecursiveMutex()};
+#endif
+
+    entry*        _find(const String &host, int port);
+    void          _open(entry* e);
+};
@@ -0,0 +1,145 @@
+/****************************************************************************************************************************
+  AsyncHTTPCoalescer.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+
+#include "AsyncHTTPRequest.h"
+
+namespace {
+#if ESP32
+class LockHelper
+{
+public:
+    LockHelper(QueueHandle_t _xMutex) :
+        xMutex{_xMutex}
+    {
+        xSemaphoreTakeRecursive(xMutex, portMAX_DELAY);
+    }
+    ~LockHelper()
+    {
+        xSemaphoreGiveRecursive(xMutex);
+    }
+
+private:
+    const QueueHandle_t xMutex;
+};
+#define _lock LockHelper lock{this->threadLock}
+#else
+#define _lock
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPCoalescer::AsyncHTTPCoalescer()
+{
+}
+
+//**************************************************************************************************************
+AsyncHTTPCoalescer::~AsyncHTTPCoalescer()
+{
+  delete _entries;
+
+#ifdef ESP32
+  vSemaphoreDelete(threadLock);
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPCoalescer& AsyncHTTPCoalescer::instance()
+{
+  static AsyncHTTPCoalescer coalescer;
+
+  return coalescer;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPCoalescer::setKeyHeaders(const String &names)
+{
+  _keyHeaders = names;
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTPCoalescer::inFlight() const
+{
+  size_t count = 0;
+
+  for (entry* e = _entries; e; e = e->next)
+    count++;
+
+  return count;
+}
+
+//**************************************************************************************************************
+AsyncHTTPRequest* AsyncHTTPCoalescer::_find(const String &key, bool urlOnly)
+{
+  _lock;
+
+  for (entry* e = _entries; e; e = e->next)
+  {
+    // The URL part ends the key, or is followed by the header values
+    if (urlOnly ? (e->key.startsWith(key) && (e->key.length() == key.length() || e->key[key.length()] == '\n'))
+                : e->key == key)
+    {
+      return e->leader;
+    }
+  }
+
+  return nullptr;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPCoalescer::_add(const String &key, AsyncHTTPRequest* leader)
+{
+  _lock;
+
+  AHTTP_LOGDEBUG1("coalescer add", key);
+
+  entry* e = new entry;
+
+  e->key    = key;
+  e->leader = leader;
+  e->next   = _entries;
+  _entries  = e;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPCoalescer::_remove(AsyncHTTPRequest* leader)
+{
+  _lock;
+
+  for (entry* prev = (entry*) &_entries; prev->next; prev = prev->next)
+  {
+    entry* e = prev->next;
+
+    if (e->leader == leader)
+    {
+      prev->next = e->next;
+      e->next = nullptr;
+      delete e;
+
+      return;
+    }
+  }
+}
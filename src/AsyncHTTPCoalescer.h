@@ -0,0 +1,79 @@
+/****************************************************************************************************************************
+  AsyncHTTPCoalescer.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+#pragma once
+
+#include <Arduino.h>
+#include <WString.h>
+
+class AsyncHTTPRequest;
+
+//! Registry of GETs in flight, so a request for something that is already on its way shares that response
+//! instead of fetching it again. A request is keyed by host:port, path and query, plus the values of a few
+//! request headers that change what comes back (keyHeaders). One joining a request that has no response yet
+//! doesn't connect at all: every byte the first one receives is parsed by it too, with the same callbacks as
+//! if it had its own connection. N subscribers cost one round trip.
+class AsyncHTTPCoalescer
+{
+    struct entry
+    {
+      entry*            next{};
+      String            key;
+      AsyncHTTPRequest* leader{nullptr};          // the request doing the fetch
+
+      ~entry()
+      {
+        delete next;
+      }
+    };
+
+  public:
+    AsyncHTTPCoalescer();
+    ~AsyncHTTPCoalescer();
+
+    static AsyncHTTPCoalescer& instance();                              // The shared registry
+
+    void          setKeyHeaders(const String &names);                   // Comma separated headers that must match too (default Accept,Authorization,Range)
+    const String& keyHeaders() const    { return _keyHeaders; }
+
+    size_t        inFlight() const;                                     // GETs others may join
+    uint32_t      coalesced() const     { return _coalesced; }          // requests served by another's round trip
+
+  private:
+    friend class AsyncHTTPRequest;
+
+    entry*        _entries{nullptr};              // most recent first
+    String        _keyHeaders{"Accept,Authorization,Range"};
+    uint32_t      _coalesced{0};
+
+#ifdef ESP32
+    SemaphoreHandle_t threadLock{xSemaphoreCreateRecursiveMutex()};
+#endif
+
+    AsyncHTTPRequest* _find(const String &key, bool urlOnly = false);
+    void          _add(const String &key, AsyncHTTPRequest* leader);
+    void          _remove(AsyncHTTPRequest* leader);
+};
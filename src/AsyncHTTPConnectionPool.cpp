@@ -0,0 +1,400 @@
+/****************************************************************************************************************************
+  AsyncHTTPConnectionPool.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+
+#include "AsyncHTTPRequest.h"
+
+namespace {
+#if ESP32
+class LockHelper
+{
+public:
+    LockHelper(QueueHandle_t _xMutex) :
+        xMutex{_xMutex}
+    {
+        xSemaphoreTakeRecursive(xMutex, portMAX_DELAY);
+    }
+    ~LockHelper()
+    {
+        xSemaphoreGiveRecursive(xMutex);
+    }
+
+private:
+    const QueueHandle_t xMutex;
+};
+#define _lock LockHelper lock{this->threadLock}
+#else
+#define _lock
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPConnectionPool::AsyncHTTPConnectionPool()
+{
+}
+
+//**************************************************************************************************************
+AsyncHTTPConnectionPool::~AsyncHTTPConnectionPool()
+{
+  flush();
+
+#ifdef ESP32
+  vSemaphoreDelete(threadLock);
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPConnectionPool& AsyncHTTPConnectionPool::instance()
+{
+  static AsyncHTTPConnectionPool pool;
+
+  return pool;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPConnectionPool::setMaxIdlePerHost(uint8_t max)
+{
+  _maxIdlePerHost = max;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPConnectionPool::setMaxIdle(uint8_t max)
+{
+  _maxIdle = max;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPConnectionPool::setIdleTimeout(uint32_t ms)
+{
+  _idleTimeout = ms;
+}
+
+//**************************************************************************************************************
+AsyncClient* AsyncHTTPConnectionPool::checkout(const String &host, int port)
+{
+  _lock;
+
+  _sweep();
+
+  // Newest matching connection is the least likely to have been dropped by the server,
+  // one still being preconnected is the next best thing
+  entry* found = nullptr;
+  entry* warming = nullptr;
+
+  for (entry* e = _idle; e; e = e->next)
+  {
+    if (e->port != port || ! e->host.equalsIgnoreCase(host))
+      continue;
+
+    if (e->client->connected())
+      found = e;
+    else if ( ! warming)
+      warming = e;
+  }
+
+  if ( ! found)
+    found = warming;
+
+  if ( ! found)
+  {
+    _misses++;
+
+    return nullptr;
+  }
+
+  AsyncClient* client = found->client;
+  delete _unlink(client);
+  _hits++;
+
+  AHTTP_LOGDEBUG3("pool checkout", host, ":", port);
+
+  return client;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPConnectionPool::checkin(AsyncClient* client, const String &host, int port, uint32_t timeout)
+{
+  _lock;
+
+  if ( ! client->connected() || ! _maxIdlePerHost || ! _maxIdle)
+  {
+    _close(client);
+    return;
+  }
+
+  AHTTP_LOGDEBUG3("pool checkin", host, ":", port);
+
+  _park(client, host, port, timeout);
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPConnectionPool::preconnect(const String &host, int port, AsyncHTTPDNSCache* dns)
+{
+  _lock;
+
+  _sweep();
+
+  // An idle or warming connection to the origin is already there
+  if (idleCount(host, port))
+    return true;
+
+  if ( ! _maxIdlePerHost || ! _maxIdle)
+    return false;
+
+  AHTTP_LOGDEBUG3("pool preconnect", host, ":", port);
+
+  AsyncClient* client = new AsyncClient();
+  IPAddress    address;
+  bool         cached = dns && dns->lookup(host, address);
+
+  _park(client, host, port, 0);
+
+  client->onConnect([](void *obj, AsyncClient * client)
+  {
+    ((AsyncHTTPConnectionPool*)(obj))->_onConnect(client);
+  }, this);
+
+  // Remember where to store the address once the name is resolved
+  for (entry* e = _idle; e; e = e->next)
+  {
+    if (e->client == client)
+      e->dns = cached ? nullptr : dns;
+  }
+
+  if (cached ? client->connect(address, port) : client->connect(host.c_str(), port))
+    return true;
+
+  AHTTP_LOGDEBUG3("pool preconnect failed:", host, ",", port);
+
+  _close(client);
+
+  return false;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPConnectionPool::_park(AsyncClient* client, const String &host, int port, uint32_t timeout)
+{
+  _evict(host, port, _maxIdlePerHost - 1);
+
+  entry* tail = (entry*) &_idle;
+
+  while (tail->next)
+    tail = tail->next;
+
+  tail->next = new entry;
+  tail->next->client  = client;
+  tail->next->host    = host;
+  tail->next->port    = port;
+  tail->next->timeout = timeout && timeout < _idleTimeout ? timeout : _idleTimeout;
+
+  AsyncHTTPTimerWheel::instance().arm(tail->next->timer, tail->next->timeout, [this](void* client)
+  {
+    _onIdleTimeout((AsyncClient*) client);
+  }, client);
+
+  client->onDisconnect([](void *obj, AsyncClient * client)
+  {
+    ((AsyncHTTPConnectionPool*)(obj))->_onDisconnect(client);
+  }, this);
+
+#if (ESP32 || ESP8266)
+  client->onPoll(nullptr, nullptr);
+#else
+  // No ticker drives the wheel here unless loop() runs it, parked connections keep it going meanwhile
+  client->onPoll([](void *obj, AsyncClient * client)
+  {
+    AsyncHTTPTimerWheel::instance().run();
+  }, this);
+#endif
+
+  // Nothing is expected on an idle connection, anything that arrives means it can't be reused
+  client->onData([](void *obj, AsyncClient * client, void* data, size_t len)
+  {
+    client->close();
+  }, this);
+
+  client->onError(nullptr, nullptr);
+  client->onAck(nullptr, nullptr);
+
+  while (idleCount() > _maxIdle)
+    _close(_idle->client);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPConnectionPool::flush()
+{
+  _lock;
+
+  while (_idle)
+    _close(_idle->client);
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTPConnectionPool::idleCount() const
+{
+  size_t count = 0;
+
+  for (entry* e = _idle; e; e = e->next)
+    count++;
+
+  return count;
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTPConnectionPool::idleCount(const String &host, int port) const
+{
+  size_t count = 0;
+
+  for (entry* e = _idle; e; e = e->next)
+  {
+    if (e->port == port && e->host.equalsIgnoreCase(host))
+      count++;
+  }
+
+  return count;
+}
+
+//**************************************************************************************************************
+AsyncHTTPConnectionPool::entry* AsyncHTTPConnectionPool::_unlink(AsyncClient* client)
+{
+  entry* e = (entry*) &_idle;
+
+  while (e->next)
+  {
+    if (e->next->client == client)
+    {
+      entry* found = e->next;
+      e->next = found->next;
+      found->next = nullptr;
+
+      return found;
+    }
+
+    e = e->next;
+  }
+
+  return nullptr;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPConnectionPool::_close(AsyncClient* client)
+{
+  delete _unlink(client);
+
+  // Detach first, the disconnect must not come back into the pool for a client it no longer holds
+  client->onDisconnect(nullptr, nullptr);
+  client->onPoll(nullptr, nullptr);
+  client->onData(nullptr, nullptr);
+  client->close(true);
+  delete client;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPConnectionPool::_evict(const String &host, int port, uint8_t keep)
+{
+  while (idleCount(host, port) > keep)
+  {
+    for (entry* e = _idle; e; e = e->next)
+    {
+      if (e->port == port && e->host.equalsIgnoreCase(host))
+      {
+        _close(e->client);
+        break;
+      }
+    }
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTPConnectionPool::_sweep()
+{
+  // Preconnects that never made it are neither connected nor connecting
+  entry* e = _idle;
+
+  while (e)
+  {
+    AsyncClient* client = e->client;
+    e = e->next;
+
+    if ( ! client->connected() && ! client->connecting())
+      _close(client);
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTPConnectionPool::_onConnect(AsyncClient* client)
+{
+  _lock;
+
+  for (entry* e = _idle; e; e = e->next)
+  {
+    if (e->client == client)
+    {
+      AHTTP_LOGDEBUG3("pool preconnected", e->host, ":", e->port);
+
+      // Idle time starts now
+      AsyncHTTPTimerWheel::instance().arm(e->timer, e->timeout, [this](void* client)
+      {
+        _onIdleTimeout((AsyncClient*) client);
+      }, client);
+
+      if (e->dns)
+        e->dns->store(e->host, client->remoteIP());
+
+      e->dns = nullptr;
+
+      return;
+    }
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTPConnectionPool::_onDisconnect(AsyncClient* client)
+{
+  _lock;
+
+  AHTTP_LOGDEBUG("pool connection closed by server");
+
+  delete _unlink(client);
+  delete client;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPConnectionPool::_onIdleTimeout(AsyncClient* client)
+{
+  _lock;
+
+  for (entry* e = _idle; e; e = e->next)
+  {
+    if (e->client == client)
+    {
+      AHTTP_LOGDEBUG3("pool idle timeout", e->host, ":", e->port);
+
+      _close(client);
+
+      return;
+    }
+  }
+}
@@ -0,0 +1,104 @@
+/****************************************************************************************************************************
+  AsyncHTTPConnectionPool.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+#pragma once
+
+#include <Arduino.h>
+#include <WString.h>
+
+#include "AsyncHTTPTimerWheel.h"
+
+class AsyncClient;
+class AsyncHTTPDNSCache;
+
+//! Process wide set of idle keep-alive connections, keyed by host:port.
+//! Requests that use the pool check a live connection out in _connect() instead of opening a new one,
+//! and hand it back when a response completes on a connection the server keeps open.
+//! While parked, the pool owns the AsyncClient: it closes connections that sit idle too long (timed on the shared wheel),
+//! that the server closes, or that receive unsolicited data.
+//! preconnect() parks a connection ahead of time, so a latency critical request skips DNS and the TCP handshake;
+//! a request may check it out while the handshake is still under way and picks up from there.
+class AsyncHTTPConnectionPool
+{
+    struct entry
+    {
+      entry*        next{};
+      AsyncClient*  client{};
+      String        host;
+      int           port{0};
+      uint32_t      timeout{0};                   // idle timeout for this connection (ms)
+      AsyncHTTPDNSCache* dns{};                   // preconnecting by name, store the address here
+      AsyncHTTPTimer timer;                       // closes the connection when the idle timeout is up
+
+      ~entry()
+      {
+        delete next;
+      }
+    };
+
+  public:
+    AsyncHTTPConnectionPool();
+    ~AsyncHTTPConnectionPool();
+
+    static AsyncHTTPConnectionPool& instance();                         // The shared pool
+
+    void          setMaxIdlePerHost(uint8_t max);                       // Idle connections kept per host:port (default 2)
+    void          setMaxIdle(uint8_t max);                              // Idle connections kept in total (default 6)
+    void          setIdleTimeout(uint32_t ms);                          // Close parked connections after this (default 10s)
+
+    AsyncClient*  checkout(const String &host, int port);               // Live idle connection or nullptr
+    void          checkin(AsyncClient* client, const String &host, int port, uint32_t timeout = 0);
+    bool          preconnect(const String &host, int port = 80, AsyncHTTPDNSCache* dns = nullptr); // Warm up a connection
+    void          flush();                                              // Close every idle connection
+
+    size_t        idleCount() const;
+    size_t        idleCount(const String &host, int port) const;
+    uint32_t      hits() const        { return _hits; }                 // checkouts served from the pool
+    uint32_t      misses() const      { return _misses; }               // checkouts that found nothing
+
+  private:
+    entry*        _idle{nullptr};                 // oldest first
+    uint8_t       _maxIdlePerHost{2};
+    uint8_t       _maxIdle{6};
+    uint32_t      _idleTimeout{10000};
+    uint32_t      _hits{0};
+    uint32_t      _misses{0};
+
+#ifdef ESP32
+    SemaphoreHandle_t threadLock{xSemaphoreCreateRecursiveMutex()};
+#endif
+
+    entry*        _unlink(AsyncClient* client);
+    void          _close(AsyncClient* client);
+    void          _evict(const String &host, int port, uint8_t keep);
+    void          _park(AsyncClient* client, const String &host, int port, uint32_t timeout);
+    void          _sweep();
+
+    void          _onConnect(AsyncClient* client);
+
+    void          _onDisconnect(AsyncClient* client);
+    void          _onIdleTimeout(AsyncClient* client);
+};
@@ -0,0 +1,368 @@
+/****************************************************************************************************************************
+  AsyncHTTPDNSCache.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+
+#include "AsyncHTTPRequest.h"
+
+#if (ESP32 || ESP8266)
+  #include <lwip/dns.h>
+#endif
+
+#if ESP32
+  #include <lwip/tcpip.h>
+#endif
+
+namespace {
+#if ESP32
+class LockHelper
+{
+public:
+    LockHelper(QueueHandle_t _xMutex) :
+        xMutex{_xMutex}
+    {
+        xSemaphoreTakeRecursive(xMutex, portMAX_DELAY);
+    }
+    ~LockHelper()
+    {
+        xSemaphoreGiveRecursive(xMutex);
+    }
+
+private:
+    const QueueHandle_t xMutex;
+};
+#define _lock LockHelper lock{this->threadLock}
+#else
+#define _lock
+#endif
+
+#if (ESP32 || ESP8266)
+// A dual stack lwIP 2 may answer with an IPv6 address, which IPAddress can't hold and connect() can't use
+bool toIPAddress(const ip_addr_t* addr, IPAddress &ip)
+{
+#if LWIP_VERSION_MAJOR == 1
+  ip = IPAddress(addr->addr);
+#else
+  if ( ! IP_IS_V4(addr))
+    return false;
+
+  ip = IPAddress(ip4_addr_get_u32(ip_2_ip4(addr)));
+#endif
+
+  return true;
+}
+
+void dnsFound(const char* name, const ip_addr_t* ipaddr, void* arg)
+{
+  IPAddress ip;
+
+  if (ipaddr && toIPAddress(ipaddr, ip))
+    ((AsyncHTTPDNSCache*)(arg))->store(name, ip);
+  else
+    ((AsyncHTTPDNSCache*)(arg))->storeFailure(name);
+}
+
+#if ESP32
+// The resolver belongs to the tcpip thread, lwIP's own API calls are made from there
+struct dnsCall
+{
+  struct tcpip_api_call_data  call;
+  const char*                 host;
+  ip_addr_t*                  addr;
+  void*                       arg;
+};
+
+err_t dnsOnTcpip(struct tcpip_api_call_data* data)
+{
+  dnsCall* c = (dnsCall*) data;
+
+  return dns_gethostbyname(c->host, c->addr, dnsFound, c->arg);
+}
+#endif
+
+err_t gethostbyname(const char* host, ip_addr_t* addr, void* arg)
+{
+#if ESP32
+  dnsCall c;
+
+  c.host = host;
+  c.addr = addr;
+  c.arg  = arg;
+
+  return tcpip_api_call(dnsOnTcpip, &c.call);
+#else
+  // ESP8266 has a single context, the resolver can be called from here
+  return dns_gethostbyname(host, addr, dnsFound, arg);
+#endif
+}
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPDNSCache::AsyncHTTPDNSCache()
+{
+}
+
+//**************************************************************************************************************
+AsyncHTTPDNSCache::~AsyncHTTPDNSCache()
+{
+  delete _entries;
+
+#ifdef ESP32
+  vSemaphoreDelete(threadLock);
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPDNSCache& AsyncHTTPDNSCache::instance()
+{
+  static AsyncHTTPDNSCache cache;
+
+  return cache;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDNSCache::setTTL(uint32_t ms)
+{
+  _ttl = ms;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDNSCache::setNegativeTTL(uint32_t ms)
+{
+  _negativeTTL = ms;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDNSCache::setMaxEntries(uint8_t max)
+{
+  _lock;
+
+  _maxEntries = max;
+
+  while (count() > _maxEntries)
+  {
+    entry* oldest = _entries;
+    _entries = oldest->next;
+    oldest->next = nullptr;
+    delete oldest;
+  }
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPDNSCache::lookup(const String &host, IPAddress &ip)
+{
+  // Literal addresses need no lookup
+  if (ip.fromString(host))
+    return true;
+
+  _lock;
+
+  entry* e = _find(host);
+
+  if ( ! e || e->failed)
+  {
+    _misses++;
+
+    return false;
+  }
+
+  _hits++;
+  ip = e->ip;
+
+  AHTTP_LOGDEBUG3("dns cache hit", host, "=", ip.toString());
+
+  return true;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPDNSCache::failed(const String &host)
+{
+  _lock;
+
+  entry* e = _find(host);
+
+  return e && e->failed;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDNSCache::store(const String &host, const IPAddress &ip, uint32_t ttl)
+{
+  IPAddress literal;
+
+  if (literal.fromString(host) || ! uint32_t(ip))
+    return;
+
+  _put(host, ip, ttl ? ttl : _ttl, false);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDNSCache::storeFailure(const String &host)
+{
+  AHTTP_LOGDEBUG1("dns lookup failed", host);
+
+  _put(host, IPAddress(), _negativeTTL, true);
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPDNSCache::resolve(const String &host)
+{
+  IPAddress ip;
+
+  if (ip.fromString(host))
+    return true;
+
+  {
+    _lock;
+
+    entry* e = _find(host);
+
+    if (e && ! e->failed)
+      return true;
+  }
+
+#if (ESP32 || ESP8266)
+  ip_addr_t addr;
+
+  err_t err = gethostbyname(host.c_str(), &addr, this);
+
+  // Already in lwIP's own table, usable if it's IPv4
+  if (err == ERR_OK)
+  {
+    if (toIPAddress(&addr, ip))
+    {
+      store(host, ip);
+
+      return true;
+    }
+
+    storeFailure(host);
+
+    return false;
+  }
+
+  if (err != ERR_INPROGRESS)
+    storeFailure(host);
+#endif
+
+  return false;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDNSCache::flush()
+{
+  _lock;
+
+  delete _entries;
+  _entries = nullptr;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDNSCache::flush(const String &host)
+{
+  _lock;
+
+  for (entry* prev = (entry*) &_entries; prev->next; prev = prev->next)
+  {
+    entry* e = prev->next;
+
+    if (e->host.equalsIgnoreCase(host))
+    {
+      prev->next = e->next;
+      e->next = nullptr;
+      delete e;
+
+      return;
+    }
+  }
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTPDNSCache::count() const
+{
+  size_t count = 0;
+
+  for (entry* e = _entries; e; e = e->next)
+    count++;
+
+  return count;
+}
+
+//**************************************************************************************************************
+AsyncHTTPDNSCache::entry* AsyncHTTPDNSCache::_find(const String &host)
+{
+  for (entry* prev = (entry*) &_entries; prev->next; prev = prev->next)
+  {
+    entry* e = prev->next;
+
+    if ( ! e->host.equalsIgnoreCase(host))
+      continue;
+
+    if ((millis() - e->since) < e->ttl)
+      return e;
+
+    // Expired, drop it
+    prev->next = e->next;
+    e->next = nullptr;
+    delete e;
+
+    return nullptr;
+  }
+
+  return nullptr;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDNSCache::_put(const String &host, const IPAddress &ip, uint32_t ttl, bool failed)
+{
+  _lock;
+
+  flush(host);
+
+  if ( ! _maxEntries)
+    return;
+
+  entry* tail = (entry*) &_entries;
+
+  while (tail->next)
+    tail = tail->next;
+
+  tail->next = new entry;
+  tail->next->host    = host;
+  tail->next->ip      = ip;
+  tail->next->since   = millis();
+  tail->next->ttl     = ttl;
+  tail->next->failed  = failed;
+
+  AHTTP_LOGDEBUG3("dns cache store", host, failed ? "failed" : "=", ip.toString());
+
+  while (count() > _maxEntries)
+  {
+    entry* oldest = _entries;
+    _entries = oldest->next;
+    oldest->next = nullptr;
+    delete oldest;
+  }
+}
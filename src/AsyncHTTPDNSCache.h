@@ -0,0 +1,93 @@
+/****************************************************************************************************************************
+  AsyncHTTPDNSCache.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+#pragma once
+
+#include <Arduino.h>
+#include <WString.h>
+#include <IPAddress.h>
+
+// AsyncClient error reported when the name lookup of connect(host, port) fails
+#define ASYNC_TCP_DNS_FAILED      -55
+
+//! Process wide cache of resolved host names, so a new connection to a known host connects by address
+//! instead of paying for a DNS lookup. Entries expire after a TTL; failed lookups are remembered for a
+//! shorter negative TTL so a dead name fails fast instead of waiting on the resolver every time.
+//! Requests that use the cache store the peer address of every connection made by name.
+class AsyncHTTPDNSCache
+{
+    struct entry
+    {
+      entry*      next{};
+      String      host;
+      IPAddress   ip{};
+      uint32_t    since{0};                       // millis() when stored
+      uint32_t    ttl{0};                         // ms
+      bool        failed{false};                  // negative entry
+
+      ~entry()
+      {
+        delete next;
+      }
+    };
+
+  public:
+    AsyncHTTPDNSCache();
+    ~AsyncHTTPDNSCache();
+
+    static AsyncHTTPDNSCache& instance();                               // The shared cache
+
+    void        setTTL(uint32_t ms);                                    // Lifetime of a resolved address (default 5 min)
+    void        setNegativeTTL(uint32_t ms);                            // Lifetime of a failed lookup (default 10s)
+    void        setMaxEntries(uint8_t max);                             // Hosts kept, least recently stored go first (default 8)
+
+    bool        lookup(const String &host, IPAddress &ip);              // Fresh address for host, counts a hit or miss
+    bool        failed(const String &host);                             // Fresh negative entry for host
+    void        store(const String &host, const IPAddress &ip, uint32_t ttl = 0);
+    void        storeFailure(const String &host);
+    bool        resolve(const String &host);                            // Pre-resolve in the background, true if already cached
+    void        flush();                                                // Forget everything
+    void        flush(const String &host);                              // Forget one host
+
+    size_t      count() const;
+    uint32_t    hits() const          { return _hits; }                 // lookups answered from the cache
+    uint32_t    misses() const        { return _misses; }               // lookups that had to go to DNS
+
+  private:
+    entry*      _entries{nullptr};                // oldest first
+    uint32_t    _ttl{300000};
+    uint32_t    _negativeTTL{10000};
+    uint8_t     _maxEntries{8};
+    uint32_t    _hits{0};
+    uint32_t    _misses{0};
+
+#ifdef ESP32
+    SemaphoreHandle_t threadLock{xSemaphoreCreateRecursiveMutex()};
+#endif
+
+    entry*      _find(const String &host);
+    void        _put(const String &host, const IPAddress &ip, uint32_t ttl, bool failed);
+};
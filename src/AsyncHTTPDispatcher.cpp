@@ -0,0 +1,559 @@
+/****************************************************************************************************************************
+  AsyncHTTPDispatcher.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+
+#include "AsyncHTTPDispatcher.h"
+
+namespace {
+#if ESP32
+class LockHelper
+{
+public:
+    LockHelper(QueueHandle_t _xMutex) :
+        xMutex{_xMutex}
+    {
+        xSemaphoreTakeRecursive(xMutex, portMAX_DELAY);
+    }
+    ~LockHelper()
+    {
+        xSemaphoreGiveRecursive(xMutex);
+    }
+
+private:
+    const QueueHandle_t xMutex;
+};
+#define _lock LockHelper lock{this->threadLock}
+#else
+#define _lock
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPDispatcher::AsyncHTTPDispatcher() :
+  _pool{&AsyncHTTPConnectionPool::instance()},
+  _dns{&AsyncHTTPDNSCache::instance()},
+  _breaker{&AsyncHTTPCircuitBreaker::instance()}
+{
+}
+
+//**************************************************************************************************************
+AsyncHTTPDispatcher::~AsyncHTTPDispatcher()
+{
+  delete _queue;
+  delete _slots;
+
+#ifdef ESP32
+  vSemaphoreDelete(threadLock);
+#endif
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setMaxConcurrent(uint8_t max)
+{
+  _maxConcurrent = max ? max : 1;
+  _dispatch();
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setMaxPerHost(uint8_t max)
+{
+  _maxPerHost = max ? max : 1;
+  _dispatch();
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setMaxQueued(uint8_t max)
+{
+  _maxQueued = max;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setReservedSlots(uint8_t slots)
+{
+  _reserved = slots;
+  _dispatch();
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setPauseBulk(bool pause)
+{
+  _pauseBulk = pause;
+  _pauseUploads();
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setTimeout(int seconds)
+{
+  _timeout = seconds;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setConnectionPool(AsyncHTTPConnectionPool* pool)
+{
+  _pool = pool;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setDNSCache(AsyncHTTPDNSCache* cache)
+{
+  _dns = cache;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setRetryPolicy(AsyncHTTPRetryPolicy* policy)
+{
+  _retry = policy;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setCircuitBreaker(AsyncHTTPCircuitBreaker* breaker)
+{
+  _breaker = breaker;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setAdaptiveTimeouts(AsyncHTTPRTTEstimator* estimator)
+{
+  _rtt = estimator;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setHedging(uint32_t delayMs, AsyncHTTPRTTEstimator* estimator)
+{
+  _hedgeDelay = delayMs;
+  _hedgeRTT = estimator;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setCoalescer(AsyncHTTPCoalescer* coalescer)
+{
+  _coalescer = coalescer;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setHTTP2(AsyncHTTP2Session* session)
+{
+  _session = session;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::setResponseCache(AsyncHTTPResponseCache* cache)
+{
+  _cache = cache;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPDispatcher::submit(const URL &url, doneCB done, void* arg, prepareCB prepare, RequestPriority priority)
+{
+  job* newJob = new job;
+
+  newJob->url      = url;
+  newJob->priority = priority;
+  newJob->prepare  = prepare;
+  newJob->done     = done;
+  newJob->arg      = arg;
+
+  return _submit(newJob);
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPDispatcher::submit(const URL &url, const String &body, doneCB done, void* arg, prepareCB prepare,
+                                 RequestPriority priority)
+{
+  job* newJob = new job;
+
+  newJob->url      = url;
+  newJob->method   = HTTPmethod::POST;
+  newJob->priority = priority;
+  newJob->body     = body;
+  newJob->prepare  = prepare;
+  newJob->done     = done;
+  newJob->arg      = arg;
+
+  return _submit(newJob);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::clear()
+{
+  _lock;
+
+  delete _queue;
+  _queue = nullptr;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPDispatcher::preconnect(const URL &url)
+{
+  if ( ! _pool)
+    return false;
+
+  return _pool->preconnect(url.host, url.port, _dns);
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTPDispatcher::queued() const
+{
+  size_t count = 0;
+
+  for (job* j = _queue; j; j = j->next)
+    count++;
+
+  return count;
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTPDispatcher::active() const
+{
+  size_t count = 0;
+
+  for (slot* s = _slots; s; s = s->next)
+  {
+    if (s->current)
+      count++;
+  }
+
+  return count;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPDispatcher::_submit(job* newJob)
+{
+  {
+    _lock;
+
+    if (queued() >= _maxQueued)
+    {
+      AHTTP_LOGDEBUG1("dispatcher queue full, refused", newJob->url.toString());
+
+      delete newJob;
+
+      return false;
+    }
+
+    job* tail = (job*) &_queue;
+
+    while (tail->next)
+      tail = tail->next;
+
+    tail->next = newJob;
+
+    AHTTP_LOGDEBUG3("dispatcher submit", newJob->url.toString(), ", queued =", queued());
+  }
+
+  _dispatch();
+
+  return true;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::_dispatch()
+{
+  // The lock covers the queue and the slots only. Requests take their own lock before calling back into
+  // _onReadyStateChange(), so they are opened and sent, and jobs called back, with the dispatcher's released.
+  {
+    _lock;
+
+    // Jobs that finish (or fail) while being started come back here, the loop below picks up after them
+    if (_dispatching)
+      return;
+
+    _dispatching = true;
+  }
+
+  for (;;)
+  {
+    slot* s;
+    job*  next;
+
+    {
+      _lock;
+
+      next = active() < _maxConcurrent ? _next() : nullptr;
+
+      // Decided under the same lock a finishing job frees its slot under, so none is left waiting
+      if ( ! next)
+      {
+        _dispatching = false;
+        break;
+      }
+
+      // Claimed before the lock goes, so the slot counts as active and isn't handed out twice
+      s = _idleSlot(next->url);
+      s->current = next;
+    }
+
+    _start(s, next);
+  }
+
+  _pauseUploads();
+}
+
+//**************************************************************************************************************
+AsyncHTTPDispatcher::job* AsyncHTTPDispatcher::_next()
+{
+  // Oldest job of the highest priority whose host is below its cap, jobs for a busy host don't hold up the others.
+  // Only Urgent jobs may take the reserved slots.
+  bool  reserved = active() + _reserved >= _maxConcurrent;
+  job*  best = nullptr;
+  job*  bestPrev = nullptr;
+
+  for (job* prev = (job*) &_queue; prev->next; prev = prev->next)
+  {
+    job* j = prev->next;
+
+    if (reserved && j->priority != RequestPriority::Urgent)
+      continue;
+
+    if ((best && j->priority <= best->priority) || _active(j->url) >= _maxPerHost)
+      continue;
+
+    best = j;
+    bestPrev = prev;
+  }
+
+  if (best)
+  {
+    bestPrev->next = best->next;
+    best->next = nullptr;
+  }
+
+  return best;
+}
+
+//**************************************************************************************************************
+AsyncHTTPDispatcher::slot* AsyncHTTPDispatcher::_idleSlot(const URL &url)
+{
+  slot* idle = nullptr;
+
+  // Prefer the request that last talked to this host, it may still hold the connection
+  for (slot* s = _slots; s; s = s->next)
+  {
+    if (s->current)
+      continue;
+
+    if (s->request.url().port == url.port && s->request.url().host.equalsIgnoreCase(url.host))
+      return s;
+
+    if ( ! idle)
+      idle = s;
+  }
+
+  if (idle)
+    return idle;
+
+  slot* s = new slot;
+  s->next = _slots;
+  _slots = s;
+
+  s->request.onReadyStateChange([](void* obj, AsyncHTTPRequest* request, ReadyState readyState)
+  {
+    ((AsyncHTTPDispatcher*)(obj))->_onReadyStateChange(request, readyState);
+  }, this);
+
+  return s;
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTPDispatcher::_active(const URL &url) const
+{
+  size_t count = 0;
+
+  for (slot* s = _slots; s; s = s->next)
+  {
+    if (s->current && s->current->url.port == url.port && s->current->url.host.equalsIgnoreCase(url.host))
+      count++;
+  }
+
+  return count;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPDispatcher::_urgent() const
+{
+  for (job* j = _queue; j; j = j->next)
+  {
+    if (j->priority == RequestPriority::Urgent)
+      return true;
+  }
+
+  for (slot* s = _slots; s; s = s->next)
+  {
+    if (s->current && s->current->priority == RequestPriority::Urgent)
+      return true;
+  }
+
+  return false;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::_pauseUploads()
+{
+  // Bulk uploads give way between _send() calls while there is Urgent work, and pick up where they left off after
+  bool pause;
+
+  {
+    _lock;
+    pause = _pauseBulk && _urgent();
+  }
+
+  // Slots are only ever added at the head, the rest of the list holds still without the lock
+  for (slot* s = _slots; s; s = s->next)
+  {
+    AsyncHTTPRequest* request = nullptr;
+
+    {
+      _lock;
+
+      if (s->current && s->current->priority == RequestPriority::Bulk && s->request.sendPaused() != pause)
+        request = &s->request;
+    }
+
+    if (request)
+      request->pauseSend(pause);
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::_start(slot* s, job* j)
+{
+  AHTTP_LOGDEBUG3("dispatcher start", j->url.toString(), ", active =", active() + 1);
+
+  AsyncHTTPRequest& request = s->request;
+
+  // The request object is reused, options set by an earlier job's prepare don't carry over
+  request.setDigest(DigestType::None);
+  request.setJsonParser(nullptr);
+  request.setMaxResponseLength(0);
+  request.onData(nullptr);
+  request.setTimeout(_timeout);
+  request.setConnectTimeout(0);
+  request.setFirstByteTimeout(0);
+  request.setTotalTimeout(0);
+  request.setConnectionPool(_pool);
+  request.setPipeline(nullptr);
+  request.setEventStream(nullptr);
+  request.setStreaming(false);
+  request.setHeartbeat(0);
+  request.setDNSCache(_dns);
+  request.setRetryPolicy(_retry);
+  request.setCircuitBreaker(_breaker);
+  request.setAdaptiveTimeouts(_rtt);
+  request.setHedging(_hedgeDelay, _hedgeRTT);
+  request.setCoalescer(_coalescer);
+  request.setHTTP2(_session);
+  request.setResponseCache(_cache);
+
+  if ( ! request.open(j->url, j->method))
+  {
+    bool completed;
+
+    {
+      _lock;
+      completed = s->current != j;
+    }
+
+    // A failed connect has already completed the job through the Done callback
+    if ( ! completed)
+    {
+      if (j->done)
+        j->done(j->arg, &request);
+
+      _release(s);
+    }
+
+    return;
+  }
+
+  if (j->prepare)
+    j->prepare(j->arg, &request);
+
+  if (j->priority == RequestPriority::Bulk)
+  {
+    bool pause;
+
+    {
+      _lock;
+      pause = _pauseBulk && _urgent();
+    }
+
+    request.pauseSend(pause);
+  }
+
+  if (j->method == HTTPmethod::POST)
+    request.send(j->body);
+  else
+    request.send();
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::_onReadyStateChange(AsyncHTTPRequest* request, ReadyState readyState)
+{
+  if (readyState != ReadyState::Done)
+    return;
+
+  job*  done;
+  slot* s;
+
+  {
+    _lock;
+
+    s = _slots;
+
+    while (s && &s->request != request)
+      s = s->next;
+
+    if ( ! s || ! s->current)
+      return;
+
+    done = s->current;
+  }
+
+  AHTTP_LOGDEBUG3("dispatcher done", done->url.toString(), ", code =", request->responseHTTPcode());
+
+  // The slot stays busy until the callback returns, a job it submits can't be started on this request
+  if (done->done)
+    done->done(done->arg, request);
+
+  _release(s);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDispatcher::_release(slot* s)
+{
+  job* done;
+
+  {
+    _lock;
+
+    done = s->current;
+    s->current = nullptr;
+  }
+
+  delete done;
+
+  _dispatch();
+}
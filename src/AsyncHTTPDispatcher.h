@@ -0,0 +1,147 @@
+/****************************************************************************************************************************
+  AsyncHTTPDispatcher.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+#pragma once
+
+#include "AsyncHTTPRequest.h"
+
+//! Scheduling class of a job. Higher classes start first; Urgent jobs may also use the reserved slots,
+//! and while any is queued or in flight, Bulk uploads hold back the rest of their body.
+enum class RequestPriority : uint8_t
+{
+  Bulk,
+  Normal,
+  Urgent
+};
+
+//! Queue of request descriptors run on a small set of reused AsyncHTTPRequest objects.
+//! Up to maxConcurrent requests are in flight at once, at most maxPerHost of them to the same host:port;
+//! the rest wait by priority, then in submission order. Connections are shared through the connection pool.
+//! The done callback gets the request at Done: read the response there, the request object
+//! is handed to the next queued job as soon as the callback returns. Callbacks run without the dispatcher's
+//! lock held, they may submit() more jobs.
+class AsyncHTTPDispatcher
+{
+    //! Called after open() and before send(), to add headers or set per request options
+    using prepareCB = std::function<void(void* arg, AsyncHTTPRequest* request)>;
+    using doneCB    = std::function<void(void* arg, AsyncHTTPRequest* request)>;
+
+    struct job
+    {
+      job*          next{};
+      URL           url{};
+      HTTPmethod    method{HTTPmethod::GET};
+      RequestPriority priority{RequestPriority::Normal};
+      String        body;
+      prepareCB     prepare{};
+      doneCB        done{};
+      void*         arg{nullptr};
+
+      ~job()
+      {
+        delete next;
+      }
+    };
+
+    struct slot
+    {
+      slot*             next{};
+      AsyncHTTPRequest  request;
+      job*              current{};                // job in flight, nullptr when idle
+
+      ~slot()
+      {
+        delete current;
+        delete next;
+      }
+    };
+
+  public:
+    AsyncHTTPDispatcher();
+    ~AsyncHTTPDispatcher();
+
+    void        setMaxConcurrent(uint8_t max);                          // Requests in flight (default 4)
+    void        setMaxPerHost(uint8_t max);                             // Requests in flight per host:port (default 2)
+    void        setMaxQueued(uint8_t max);                              // Waiting jobs before submit() refuses (default 16)
+    void        setReservedSlots(uint8_t slots);                        // Of maxConcurrent, slots only Urgent jobs may use (default 0)
+    void        setPauseBulk(bool pause);                               // Pause Bulk uploads while Urgent work is pending (default true)
+    void        setTimeout(int seconds);                                // Timeout given to each request
+    void        setConnectionPool(AsyncHTTPConnectionPool* pool);       // Pool for the requests (default shared pool)
+    void        setDNSCache(AsyncHTTPDNSCache* cache);                  // Resolver cache for the requests (default shared cache)
+    void        setRetryPolicy(AsyncHTTPRetryPolicy* policy);           // Retry failed jobs before completing them (default none)
+    void        setCircuitBreaker(AsyncHTTPCircuitBreaker* breaker);    // Fail jobs fast to origins that are down (default shared breaker)
+    void        setAdaptiveTimeouts(AsyncHTTPRTTEstimator* estimator);  // Deadlines from measured RTTs (default none)
+    void        setHedging(uint32_t delayMs, AsyncHTTPRTTEstimator* estimator = nullptr); // Hedge slow GET jobs (default off)
+    void        setCoalescer(AsyncHTTPCoalescer* coalescer);            // Share responses between identical GET jobs (default none)
+    void        setHTTP2(AsyncHTTP2Session* session);                   // Run jobs to the session's origin as HTTP/2 streams (default none)
+    void        setResponseCache(AsyncHTTPResponseCache* cache);        // Answer GET jobs from fresh stored responses (default none)
+
+    bool        submit(const URL &url, doneCB done, void* arg = nullptr, prepareCB prepare = nullptr,
+                       RequestPriority priority = RequestPriority::Normal);   // Queue a GET
+    bool        submit(const URL &url, const String &body, doneCB done, void* arg = nullptr,
+                       prepareCB prepare = nullptr, RequestPriority priority = RequestPriority::Normal); // Queue a POST
+    void        clear();                                                // Drop jobs not yet started
+    bool        preconnect(const URL &url);                             // Park a warm connection to url's origin in the pool
+
+    size_t      queued() const;                                         // Jobs waiting
+    size_t      active() const;                                         // Jobs in flight
+
+  private:
+    job*        _queue{nullptr};                  // oldest first
+    slot*       _slots{nullptr};
+    uint8_t     _maxConcurrent{4};
+    uint8_t     _maxPerHost{2};
+    uint8_t     _maxQueued{16};
+    uint8_t     _reserved{0};
+    bool        _pauseBulk{true};
+    int         _timeout{DEFAULT_RX_TIMEOUT};
+    bool        _dispatching{false};
+    AsyncHTTPConnectionPool* _pool;
+    AsyncHTTPDNSCache* _dns;
+    AsyncHTTPRetryPolicy* _retry{nullptr};
+    AsyncHTTPCircuitBreaker* _breaker;
+    AsyncHTTPRTTEstimator* _rtt{nullptr};
+    uint32_t    _hedgeDelay{0};
+    AsyncHTTPRTTEstimator* _hedgeRTT{nullptr};
+    AsyncHTTPCoalescer* _coalescer{nullptr};
+    AsyncHTTP2Session* _session{nullptr};
+    AsyncHTTPResponseCache* _cache{nullptr};
+
+#ifdef ESP32
+    SemaphoreHandle_t threadLock{xSemaphoreCreateRecursiveMutex()};
+#endif
+
+    bool        _submit(job* newJob);
+    void        _dispatch();
+    job*        _next();
+    slot*       _idleSlot(const URL &url);
+    size_t      _active(const URL &url) const;
+    bool        _urgent() const;
+    void        _pauseUploads();
+    void        _start(slot* s, job* j);
+    void        _release(slot* s);
+    void        _onReadyStateChange(AsyncHTTPRequest* request, ReadyState readyState);
+};
@@ -0,0 +1,242 @@
+/****************************************************************************************************************************
+  AsyncHTTPDownload.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+
+#include "AsyncHTTPDownload.h"
+
+//**************************************************************************************************************
+bool AsyncHTTPDownload::begin(const URL &url, sinkCB sink, void* arg, size_t offset)
+{
+  AHTTP_LOGDEBUG3("download begin(url =", url.toString(), ", offset =", offset);
+
+  if (_active)
+    return false;
+
+  _url        = url;
+  _sink       = sink;
+  _sinkArg    = arg;
+  _offset     = offset;
+  _total      = 0;
+  _resumes    = 0;
+  _validator  = String();
+
+  _request.onReadyStateChange([](void* obj, AsyncHTTPRequest*, ReadyState readyState)
+  {
+    ((AsyncHTTPDownload*)(obj))->_onReadyStateChange(readyState);
+  }, this);
+
+  _request.onData([](void* obj, AsyncHTTPRequest*, size_t)
+  {
+    ((AsyncHTTPDownload*)(obj))->_drain();
+  }, this);
+
+  _active = true;
+
+  if ( ! _start())
+  {
+    _finish(_request.responseHTTPcode());
+    return false;
+  }
+
+  return true;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDownload::onDone(doneCB cb, void* arg)
+{
+  _doneCB = cb;
+  _doneCBarg = arg;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDownload::setMaxResumes(uint8_t resumes)
+{
+  _maxResumes = resumes;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDownload::abort()
+{
+  if ( ! _active)
+    return;
+
+  _active = false;
+  _request.abort();
+  _finish(HttpCode::STREAM_WRITE);
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPDownload::_start()
+{
+  _checked = false;
+
+  if ( ! _request.open(_url))
+    return false;
+
+  if (_offset)
+  {
+    _request.setRange(_offset);
+
+    if (_validator.length())
+      _request.setReqHeader("If-Range", _validator.c_str());
+  }
+
+  return _request.send();
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPDownload::_check()
+{
+  if (_checked)
+    return true;
+
+  int code = _request.responseHTTPcode();
+
+  if (code == 206)
+  {
+    if (_request.responseRangeStart() != _offset)
+    {
+      AHTTP_LOGDEBUG3("download range mismatch, asked", _offset, "got", _request.responseRangeStart());
+
+      return false;
+    }
+
+    _total = _request.responseRangeTotal();
+  }
+  else if (code == 200)
+  {
+    // Server sent the whole resource (no range support or If-Range failed), so start the sink over
+    if (_offset)
+    {
+      AHTTP_LOGDEBUG1("download restarting from 0, was at", _offset);
+
+      _offset = 0;
+    }
+
+    _total = _request.respHeaderExists("Transfer-Encoding") ? 0 : _request.responseLength();
+  }
+  else
+  {
+    return false;
+  }
+
+  String validator = _request.respHeaderValue("ETag");
+
+  if ( ! validator.length() || validator.startsWith("W/"))
+    validator = _request.respHeaderValue("Last-Modified");
+
+  _validator = validator;
+  _checked = true;
+
+  return true;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDownload::_drain()
+{
+  if ( ! _active || _request.readyState() < ReadyState::Loading)
+    return;
+
+  if ( ! _check())
+  {
+    // A 206 for some other range can't be spliced onto what the sink already has
+    if (_request.responseHTTPcode() == 206)
+    {
+      _active = false;
+      _request.abort();
+      _finish(HttpCode::RANGE_MISMATCH);
+    }
+
+    return;
+  }
+
+  uint8_t buf[128];
+
+  while (_active && _request.available())
+  {
+    size_t len = _request.responseRead(buf, sizeof(buf));
+
+    if ( ! _sink(_sinkArg, buf, len, _offset))
+    {
+      AHTTP_LOGDEBUG1("download sink refused data at", _offset);
+
+      abort();
+      return;
+    }
+
+    _offset += len;
+
+    // Only drops in a row with nothing delivered in between count towards the limit
+    _resumes = 0;
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDownload::_finish(int httpCode)
+{
+  AHTTP_LOGDEBUG3("download done, code =", httpCode, ", bytes =", _offset);
+
+  _active = false;
+
+  if (_doneCB)
+    _doneCB(_doneCBarg, this, httpCode);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPDownload::_onReadyStateChange(ReadyState readyState)
+{
+  if (readyState != ReadyState::Done || ! _active)
+    return;
+
+  _drain();
+
+  if ( ! _active)
+    return;
+
+  int code = _request.responseHTTPcode();
+
+  if (code == 200 || code == 206)
+  {
+    _finish(code);
+  }
+  else if (code == 416 && _total && _offset >= _total)
+  {
+    // Asked to resume at the very end, everything was already delivered
+    _finish(206);
+  }
+  else if ((code == HttpCode::CONNECTION_LOST || code == HttpCode::TIMEOUT) && _resumes < _maxResumes)
+  {
+    _resumes++;
+
+    AHTTP_LOGDEBUG3("download resume", _resumes, "from", _offset);
+
+    if ( ! _start())
+      _finish(_request.responseHTTPcode());
+  }
+  else
+  {
+    _finish(code);
+  }
+}
@@ -0,0 +1,74 @@
+/****************************************************************************************************************************
+  AsyncHTTPDownload.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+#pragma once
+
+#include "AsyncHTTPRequest.h"
+
+//! Resumable download of a single resource into a caller supplied sink.
+//! Body bytes are handed to the sink as they arrive. If the connection drops or times out part way,
+//! the request is re-opened with a Range header starting at the first byte the sink has not yet seen
+//! (guarded by If-Range so a changed resource restarts cleanly from offset 0).
+class AsyncHTTPDownload
+{
+    //! Return false to abort the download. offset is the position of data[0] in the resource;
+    //! it jumps back to 0 if the server could not resume and is sending the whole resource again.
+    using sinkCB = std::function<bool(void* arg, const uint8_t* data, size_t len, size_t offset)>;
+    using doneCB = std::function<void(void* arg, AsyncHTTPDownload* download, int httpCode)>;
+
+  public:
+    bool        begin(const URL &url, sinkCB sink, void* arg = nullptr, size_t offset = 0); // Start download at offset
+    void        onDone(doneCB cb, void* arg = nullptr);                 // Called once when finished or given up
+    void        setMaxResumes(uint8_t resumes);                         // Reconnects in a row without progress (default 5)
+    void        abort();                                                // Stop, onDone is called with STREAM_WRITE
+
+    bool        active() const        { return _active; }
+    size_t      offset() const        { return _offset; }               // Bytes delivered to the sink so far
+    size_t      totalLength() const   { return _total; }                // Resource length if known, else 0
+    uint8_t     resumes() const       { return _resumes; }              // Reconnects since data last arrived
+    AsyncHTTPRequest& request()       { return _request; }
+
+  private:
+    AsyncHTTPRequest _request;
+    URL             _url{};
+    sinkCB          _sink{};
+    void*           _sinkArg{nullptr};
+    doneCB          _doneCB{};
+    void*           _doneCBarg{nullptr};
+    String          _validator;                   // ETag or Last-Modified used for If-Range
+    size_t          _offset{0};
+    size_t          _total{0};
+    uint8_t         _maxResumes{5};
+    uint8_t         _resumes{0};
+    bool            _active{false};
+    bool            _checked{false};              // response status/range checked for this attempt
+
+    bool        _start();
+    bool        _check();
+    void        _drain();
+    void        _finish(int httpCode);
+    void        _onReadyStateChange(ReadyState readyState);
+};
@@ -0,0 +1,533 @@
+/****************************************************************************************************************************
+  AsyncHTTPFileCache.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+ 
+
+#include "AsyncHTTPRequest.h"
+
+namespace {
+#if ESP32
+class LockHelper
+{
+public:
+    LockHelper(QueueHandle_t _xMutex) :
+        xMutex{_xMutex}
+    {
+        xSemaphoreTakeRecursive(xMutex, portMAX_DELAY);
+    }
+    ~LockHelper()
+    {
+        xSemaphoreGiveRecursive(xMutex);
+    }
+
+private:
+    const QueueHandle_t xMutex;
+};
+#define _lock LockHelper lock{this->threadLock}
+#else
+#define _lock
+#endif
+}
+
+#if (ESP32 || ESP8266)
+
+//**************************************************************************************************************
+AsyncHTTPFileCache::AsyncHTTPFileCache(fs::FS &fs, const char* dir, size_t cap) :
+  _fs{fs},
+  _dir{dir},
+  _cap{cap}
+{
+}
+
+//**************************************************************************************************************
+AsyncHTTPFileCache::~AsyncHTTPFileCache()
+{
+  // Nothing queued is lost
+  run();
+
+  delete _index;
+
+#ifdef ESP32
+  vSemaphoreDelete(threadLock);
+#endif
+}
+
+//**************************************************************************************************************
+void AsyncHTTPFileCache::setCap(size_t bytes)
+{
+  _lock;
+
+  _readIndex();
+  _cap = bytes;
+  _trim(0);
+  _writeIndex();
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTPFileCache::used()
+{
+  _lock;
+
+  _readIndex();
+
+  return _used;
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTPFileCache::entries()
+{
+  _lock;
+
+  _readIndex();
+
+  size_t count = 0;
+
+  for (entry* e = _index; e; e = e->next)
+    count++;
+
+  return count;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPFileCache::flush()
+{
+  _lock;
+
+  _readIndex();
+
+  for (entry* e = _index; e; e = e->next)
+    _fs.remove(_path(e->hash));
+
+  delete _index;
+  _index = nullptr;
+  _used = 0;
+
+  delete _queue;
+  _queue = nullptr;
+  _queued = 0;
+  _dirty = false;
+
+  _fs.remove(_dir + "/index");
+}
+
+//**************************************************************************************************************
+void AsyncHTTPFileCache::run()
+{
+  _lock;
+
+  while (_queue)
+  {
+    pending* p = _queue;
+
+    _queue = p->next;
+    p->next = nullptr;
+    _queued -= p->size;
+
+    _readIndex();
+
+    if (p->size)
+      _write(p);
+    else
+      _erase(p->key);
+
+    delete p;
+  }
+
+  // Once for everything this run changed
+  if (_dirty)
+    _writeIndex();
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTPFileCache::queued() const
+{
+  size_t count = 0;
+
+  for (pending* p = _queue; p; p = p->next)
+    count++;
+
+  return count;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPFileCache::_load(const String &key, String &headers, uint8_t* &body, size_t &length)
+{
+  _lock;
+
+  // Not on file yet: the queued copy, or nothing if its removal is waiting
+  for (pending* p = _queue; p; p = p->next)
+  {
+    if (p->key != key)
+      continue;
+
+    if ( ! p->size)
+      return false;
+
+    headers = p->headers;
+    length  = p->length;
+    body    = length ? new uint8_t[length] : nullptr;
+
+    if (length)
+      memcpy(body, p->body, length);
+
+    _loads++;
+
+    return true;
+  }
+
+  _readIndex();
+
+  uint32_t hash = _hash(key);
+  entry*   e = _index;
+
+  while (e && e->hash != hash)
+    e = e->next;
+
+  if ( ! e)
+    return false;
+
+  File file = _fs.open(_path(hash), "r");
+
+  if ( ! file)
+  {
+    // Gone from under the index, which is rewritten on the next run()
+    delete _unlink(hash);
+    _dirty = true;
+
+    return false;
+  }
+
+  // Another key with the same hash
+  if (file.readStringUntil('\n') != key)
+    return false;
+
+  // Header lines up to an empty one, then the body
+  headers = String();
+
+  while (file.available())
+  {
+    String line = file.readStringUntil('\n');
+
+    if (line == "\r")
+      break;
+
+    headers += line + '\n';
+  }
+
+  length = file.available();
+  body   = length ? new uint8_t[length] : nullptr;
+
+  if (length && file.read(body, length) != length)
+  {
+    delete[] body;
+    body = nullptr;
+
+    return false;
+  }
+
+  AHTTP_LOGDEBUG3("file cache: loaded", key, ", length =", length);
+
+  _loads++;
+
+  return true;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPFileCache::_store(const String &key, const String &headers, const uint8_t* body, size_t length)
+{
+  _lock;
+
+  // A newer copy replaces whatever was waiting
+  delete _dequeue(key);
+
+  pending* p = new pending;
+  size_t   size = key.length() + 1 + headers.length() + 2 + length;
+
+  p->key = key;
+
+  // Too big for the cap, or to be held until run(): the older copy on file goes instead
+  if (size <= _cap && _queued + size <= FILE_CACHE_QUEUE)
+  {
+    p->headers = headers;
+    p->body    = length ? new uint8_t[length] : nullptr;
+    p->length  = length;
+    p->size    = size;
+
+    if (length)
+      memcpy(p->body, body, length);
+  }
+  else
+  {
+    AHTTP_LOGDEBUG3("file cache: not kept", key, ", size =", size);
+  }
+
+  _enqueue(p);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPFileCache::_remove(const String &key)
+{
+  _lock;
+
+  delete _dequeue(key);
+
+  pending* p = new pending;
+
+  p->key = key;
+  _enqueue(p);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPFileCache::_enqueue(pending* p)
+{
+  pending* tail = (pending*) &_queue;
+
+  while (tail->next)
+    tail = tail->next;
+
+  tail->next = p;
+  _queued += p->size;
+}
+
+//**************************************************************************************************************
+AsyncHTTPFileCache::pending* AsyncHTTPFileCache::_dequeue(const String &key)
+{
+  for (pending* prev = (pending*) &_queue; prev->next; prev = prev->next)
+  {
+    pending* p = prev->next;
+
+    if (p->key == key)
+    {
+      prev->next = p->next;
+      p->next = nullptr;
+      _queued -= p->size;
+
+      return p;
+    }
+  }
+
+  return nullptr;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPFileCache::_write(const pending* p)
+{
+  uint32_t hash = _hash(p->key);
+  String   path = _path(hash);
+
+  delete _unlink(hash);
+  _dirty = true;
+
+  // The cap may have come down since it was queued
+  if (p->size > _cap)
+  {
+    _fs.remove(path);
+
+    return;
+  }
+
+  _trim(p->size);
+  _fs.mkdir(_dir);
+
+  // Written aside and renamed, so power lost half way leaves the old file or none rather than a torn one
+  String temp = path + ".tmp";
+  File   file = _fs.open(temp, "w");
+
+  if ( ! file)
+  {
+    _fs.remove(path);
+
+    return;
+  }
+
+  bool written = file.print(p->key) == p->key.length() && file.print('\n') == 1 &&
+                 file.print(p->headers) == p->headers.length() && file.print("\r\n") == 2 &&
+                 (! p->length || file.write(p->body, p->length) == p->length);
+
+  file.close();
+  _fs.remove(path);
+
+  if ( ! written || ! _fs.rename(temp, path))
+  {
+    AHTTP_LOGDEBUG1("file cache: write failed", p->key);
+
+    _fs.remove(temp);
+
+    return;
+  }
+
+  entry*  e = new entry;
+  entry** tail = &_index;
+
+  while (*tail)
+    tail = &(*tail)->next;
+
+  e->hash = hash;
+  e->size = p->size;
+  *tail = e;
+  _used += p->size;
+  _writes++;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPFileCache::_erase(const String &key)
+{
+  uint32_t hash = _hash(key);
+  entry*   e = _unlink(hash);
+
+  if ( ! e)
+    return;
+
+  delete e;
+
+  _fs.remove(_path(hash));
+  _dirty = true;
+}
+
+//**************************************************************************************************************
+uint32_t AsyncHTTPFileCache::_hash(const String &key)
+{
+  // FNV-1a
+  uint32_t hash = 2166136261UL;
+
+  for (size_t i = 0; i < key.length(); i++)
+  {
+    hash ^= (uint8_t) key.charAt(i);
+    hash *= 16777619UL;
+  }
+
+  return hash;
+}
+
+//**************************************************************************************************************
+String AsyncHTTPFileCache::_path(uint32_t hash) const
+{
+  char name[10];
+
+  snprintf(name, sizeof(name), "/%08lx", (unsigned long) hash);
+
+  return _dir + name;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPFileCache::_readIndex()
+{
+  if (_indexed)
+    return;
+
+  _indexed = true;
+
+  // "hash size" per line, oldest first
+  File file = _fs.open(_dir + "/index", "r");
+
+  if ( ! file)
+    return;
+
+  entry** tail = &_index;
+
+  while (file.available())
+  {
+    String line  = file.readStringUntil('\n');
+    int    space = line.indexOf(' ');
+
+    if (space < 0)
+      continue;
+
+    entry* e = new entry;
+
+    e->hash = strtoul(line.substring(0, space).c_str(), nullptr, 16);
+    e->size = line.substring(space + 1).toInt();
+    *tail = e;
+    tail = &e->next;
+    _used += e->size;
+  }
+
+  AHTTP_LOGDEBUG1("file cache: index read, bytes =", _used);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPFileCache::_writeIndex()
+{
+  File file = _fs.open(_dir + "/index", "w");
+
+  if ( ! file)
+    return;
+
+  _dirty = false;
+
+  for (entry* e = _index; e; e = e->next)
+  {
+    char line[24];
+
+    snprintf(line, sizeof(line), "%08lx %lu\n", (unsigned long) e->hash, (unsigned long) e->size);
+    file.print(line);
+  }
+}
+
+//**************************************************************************************************************
+AsyncHTTPFileCache::entry* AsyncHTTPFileCache::_unlink(uint32_t hash)
+{
+  entry** pe = &_index;
+
+  while (*pe)
+  {
+    if ((*pe)->hash == hash)
+    {
+      entry* e = *pe;
+
+      *pe = e->next;
+      e->next = nullptr;
+      _used -= e->size;
+
+      return e;
+    }
+
+    pe = &(*pe)->next;
+  }
+
+  return nullptr;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPFileCache::_trim(size_t room)
+{
+  // Oldest written goes first
+  while (_index && _used + room > _cap)
+  {
+    entry* e = _index;
+
+    _index = e->next;
+    e->next = nullptr;
+
+    AHTTP_LOGDEBUG1("file cache: removing", _path(e->hash));
+
+    _fs.remove(_path(e->hash));
+    _used -= e->size;
+    delete e;
+  }
+}
+
+#endif    // (ESP32 || ESP8266)
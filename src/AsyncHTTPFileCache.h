@@ -0,0 +1,134 @@
+/****************************************************************************************************************************
+  AsyncHTTPFileCache.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+#pragma once
+
+#include <Arduino.h>
+#include <WString.h>
+
+#if (ESP32 || ESP8266)
+
+#include <FS.h>
+
+#ifndef FILE_CACHE_CAP
+  #define FILE_CACHE_CAP          65536           // bytes of entry files kept on the filesystem
+#endif
+
+#ifndef FILE_CACHE_QUEUE
+  #define FILE_CACHE_QUEUE        16384           // bytes of responses held in RAM until run() writes them
+#endif
+
+class xbuf;
+
+//! Filesystem tier below AsyncHTTPResponseCache (LittleFS, SPIFFS or SD), so stored responses survive a reboot
+//! or deep sleep. Only responses that can be revalidated (ETag or Last-Modified) are written: their age can't
+//! be known after a restart, so they come back stale and cost a conditional request, answered by a 304 when
+//! nothing changed, instead of a full download.
+//! Each response is a file named after a hash of its key, holding the key, the stored headers and the body.
+//! A small index (hash and size per file, oldest first) is read on first use and trims the files to the cap.
+//! Stores and removals arrive from the network callbacks, where ESP8266 mustn't block on flash: they are queued,
+//! and done by run() from loop(), the index written once per run.
+class AsyncHTTPFileCache
+{
+    struct entry
+    {
+      entry*        next{};
+      uint32_t      hash{0};
+      size_t        size{0};
+
+      ~entry()
+      {
+        delete next;
+      }
+    };
+
+    struct pending
+    {
+      pending*      next{};
+      String        key;
+      String        headers;
+      uint8_t*      body{nullptr};
+      size_t        length{0};
+      size_t        size{0};                      // of the file it makes, 0 for a removal
+
+      ~pending()
+      {
+        delete[] body;
+        delete next;
+      }
+    };
+
+  public:
+    AsyncHTTPFileCache(fs::FS &fs, const char* dir = "/httpcache", size_t cap = FILE_CACHE_CAP);
+    ~AsyncHTTPFileCache();
+
+    void          setCap(size_t bytes);                                 // Removes the oldest files down to it at once
+    size_t        cap() const           { return _cap; }
+    size_t        used();                                               // bytes in entry files
+    size_t        entries();
+    void          flush();                                              // Remove every file
+    void          run();                                                // Write what is queued, call from loop()
+    size_t        queued() const;                                       // stores and removals waiting for run()
+
+    uint32_t      loads() const         { return _loads; }              // responses brought back from the filesystem
+    uint32_t      writes() const        { return _writes; }             // responses written
+
+  private:
+    friend class AsyncHTTPResponseCache;
+
+    fs::FS&       _fs;
+    String        _dir;
+    size_t        _cap;
+    size_t        _used{0};
+    entry*        _index{nullptr};                // oldest first
+    bool          _indexed{false};                // index read from the filesystem
+    bool          _dirty{false};                  // index changed since written
+    pending*      _queue{nullptr};                // oldest first
+    size_t        _queued{0};                     // bytes held by _queue
+    uint32_t      _loads{0};
+    uint32_t      _writes{0};
+
+#ifdef ESP32
+    SemaphoreHandle_t threadLock{xSemaphoreCreateRecursiveMutex()};
+#endif
+
+    bool          _load(const String &key, String &headers, uint8_t* &body, size_t &length);
+    void          _store(const String &key, const String &headers, const uint8_t* body, size_t length);
+    void          _remove(const String &key);
+    void          _enqueue(pending* p);
+    pending*      _dequeue(const String &key);
+    void          _write(const pending* p);
+    void          _erase(const String &key);
+
+    static uint32_t _hash(const String &key);
+    String        _path(uint32_t hash) const;
+    void          _readIndex();
+    void          _writeIndex();
+    entry*        _unlink(uint32_t hash);
+    void          _trim(size_t room);
+};
+
+#endif    // (ESP32 || ESP8266)
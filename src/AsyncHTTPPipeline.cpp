@@ -0,0 +1,516 @@
+/****************************************************************************************************************************
+  AsyncHTTPPipeline.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+
+#include "AsyncHTTPRequest.h"
+
+namespace {
+#if ESP32
+class LockHelper
+{
+public:
+    LockHelper(QueueHandle_t _xMutex) :
+        xMutex{_xMutex}
+    {
+        xSemaphoreTakeRecursive(xMutex, portMAX_DELAY);
+    }
+    ~LockHelper()
+    {
+        xSemaphoreGiveRecursive(xMutex);
+    }
+
+private:
+    const QueueHandle_t xMutex;
+};
+#define _lock LockHelper lock{this->threadLock}
+#else
+#define _lock
+#endif
+}
+
+// A request is resent at most this many times after the server drops the connection under it
+#define PIPELINE_MAX_REPLAYS    2
+
+//**************************************************************************************************************
+AsyncHTTPPipeline::AsyncHTTPPipeline()
+{
+}
+
+//**************************************************************************************************************
+AsyncHTTPPipeline::~AsyncHTTPPipeline()
+{
+  // Requests still queued can't complete any more
+  while (_queue)
+  {
+    entry* e = _queue;
+    _queue = e->next;
+    e->next = nullptr;
+
+    AsyncHTTPRequest* request = e->request;
+    delete e;
+
+    request->_client = nullptr;
+    request->_piped = false;
+    request->_pipeline = nullptr;
+    request->_onDisconnect(nullptr);
+  }
+
+  if (_client)
+  {
+    _client->onDisconnect(nullptr, nullptr);
+    _client->onPoll(nullptr, nullptr);
+    _client->onData(nullptr, nullptr);
+    _client->onAck(nullptr, nullptr);
+    _client->onError(nullptr, nullptr);
+    _client->close(true);
+    delete _client;
+  }
+
+  delete _pending;
+
+#ifdef ESP32
+  vSemaphoreDelete(threadLock);
+#endif
+}
+
+//**************************************************************************************************************
+void AsyncHTTPPipeline::begin(const String &host, int port)
+{
+  _lock;
+
+  if (_client && (port != _port || ! host.equalsIgnoreCase(_host)))
+    close();
+
+  _host = host;
+  _port = port;
+  _fallback = false;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPPipeline::setMaxDepth(uint8_t depth)
+{
+  _maxDepth = depth ? depth : 1;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPPipeline::close()
+{
+  _lock;
+
+  if (_client)
+  {
+    _closing = true;
+    _client->close();
+  }
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTPPipeline::queued() const
+{
+  size_t count = 0;
+
+  for (entry* e = _queue; e; e = e->next)
+    count++;
+
+  return count;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPPipeline::_accepts(const String &host, int port) const
+{
+  return _host.length() && port == _port && host.equalsIgnoreCase(_host);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPPipeline::_enqueue(AsyncHTTPRequest* request)
+{
+  _lock;
+
+  entry* tail = (entry*) &_queue;
+
+  while (tail->next)
+  {
+    if (tail->next->request == request)
+      return;
+
+    tail = tail->next;
+  }
+
+  tail->next = new entry;
+  tail->next->request = request;
+
+  AHTTP_LOGDEBUG3("pipeline enqueue", request->_URL.path, ", queued =", queued());
+
+  if ( ! _client)
+    _connect();
+  else if (_client->connected())
+    request->_onConnect(_client);
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPPipeline::_canWrite(AsyncHTTPRequest* request) const
+{
+  // In order, and no deeper than allowed: everything ahead must be fully written
+  uint8_t depth = _fallback ? 1 : _maxDepth;
+  uint8_t ahead = 0;
+
+  for (entry* e = _queue; e; e = e->next)
+  {
+    if (e->request == request)
+      return ahead < depth;
+
+    if (e->request->_request)
+      return false;
+
+    ahead++;
+  }
+
+  return false;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPPipeline::_finished(AsyncHTTPRequest* request)
+{
+  _lock;
+
+  entry* e = _queue;
+
+  if ( ! e || e->request != request)
+    return;
+
+  _queue = e->next;
+  e->next = nullptr;
+  delete e;
+
+  if ( ! request->_httpMinor && ! _fallback)
+  {
+    AHTTP_LOGDEBUG("pipeline: HTTP/1.0 server, falling back to one request at a time");
+
+    _fallback = true;
+  }
+
+  // Anything the server sent past this response starts the next one, unless it is about to close
+  if ( ! request->_keepAlive)
+  {
+    _closing = true;
+  }
+  else if (request->_surplus)
+  {
+    _pending = request->_surplus;
+    request->_surplus = nullptr;
+  }
+
+  // The next request's response is due now, its deadlines start counting
+  if (_queue)
+  {
+    _queue->request->_lastActivity = millis();
+
+    if (_queue->request->_awaitingResponse)
+      _queue->request->_sentTime = millis();
+
+    _queue->request->_armDeadline();
+  }
+
+  _pump();
+}
+
+//**************************************************************************************************************
+void AsyncHTTPPipeline::_remove(AsyncHTTPRequest* request)
+{
+  _lock;
+
+  for (entry* prev = (entry*) &_queue; prev->next; prev = prev->next)
+  {
+    entry* e = prev->next;
+
+    if (e->request != request)
+      continue;
+
+    prev->next = e->next;
+    e->next = nullptr;
+    delete e;
+
+    // Its response would still arrive ahead of the others, the connection can't be used any more
+    bool written = _written(request);
+    request->_client = nullptr;
+
+    if (written && _client)
+    {
+      _closing = true;
+      _client->close();
+    }
+
+    return;
+  }
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPPipeline::_connect()
+{
+  AHTTP_LOGDEBUG3("pipeline connect", _host, ":", _port);
+
+  _client = new AsyncClient();
+
+  _client->onConnect([](void *obj, AsyncClient * client)
+  {
+    ((AsyncHTTPPipeline*)(obj))->_onConnect(client);
+  }, this);
+
+  _client->onDisconnect([](void *obj, AsyncClient * client)
+  {
+    ((AsyncHTTPPipeline*)(obj))->_onDisconnect(client);
+  }, this);
+
+  _client->onPoll([](void *obj, AsyncClient * client)
+  {
+    ((AsyncHTTPPipeline*)(obj))->_onPoll(client);
+  }, this);
+
+  _client->onError([](void *obj, AsyncClient * client, uint32_t error)
+  {
+    ((AsyncHTTPPipeline*)(obj))->_onError(client, error);
+  }, this);
+
+  _client->onAck([](void* obj, AsyncClient * client, size_t len, uint32_t time)
+  {
+    ((AsyncHTTPPipeline*)(obj))->_pump();
+  }, this);
+
+  _client->onData([](void* obj, AsyncClient * client, void* data, size_t len)
+  {
+    ((AsyncHTTPPipeline*)(obj))->_onData(data, len);
+  }, this);
+
+  if (_client->connect(_host.c_str(), _port))
+    return true;
+
+  AHTTP_LOGDEBUG3("pipeline connect failed:", _host, ",", _port);
+
+  delete _client;
+  _client = nullptr;
+
+  // Nothing queued can be sent
+  while (_queue)
+  {
+    entry* e = _queue;
+    _queue = e->next;
+    e->next = nullptr;
+
+    AsyncHTTPRequest* request = e->request;
+    delete e;
+
+    request->_onDisconnect(nullptr);
+  }
+
+  return false;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPPipeline::_pump()
+{
+  _lock;
+
+  // Write queued requests in order until one can't be written completely
+  for (entry* e = _queue; e; e = e->next)
+  {
+    AsyncHTTPRequest* request = e->request;
+
+    if ( ! request->_client || ! request->_request)
+      continue;
+
+    request->_send();
+
+    if (request->_request)
+      break;
+  }
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPPipeline::_written(AsyncHTTPRequest* request)
+{
+  // Sent something on this connection (kept in _replay), or already receiving (_replay gone)
+  return request->_client && ( ! request->_replay || request->_replay->available());
+}
+
+//**************************************************************************************************************
+void AsyncHTTPPipeline::_onConnect(AsyncClient* client)
+{
+  AHTTP_LOGDEBUG("pipeline _onConnect");
+
+  _lock;
+
+  for (entry* e = _queue; e; e = e->next)
+    e->request->_onConnect(client);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPPipeline::_onDisconnect(AsyncClient* client)
+{
+  AHTTP_LOGDEBUG1("pipeline _onDisconnect, queued =", queued());
+
+  _lock;
+
+  bool dropped = ! _closing;
+  _closing = false;
+  _client = nullptr;
+
+  delete _pending;
+  _pending = nullptr;
+
+  // Requests that saw none of their response are resent, the rest end here
+  entry*  queue = _queue;
+  entry*  failed = nullptr;
+  entry** keep = &_queue;
+  entry** fail = &failed;
+  uint8_t unanswered = 0;
+
+  _queue = nullptr;
+
+  while (queue)
+  {
+    entry* e = queue;
+    queue = e->next;
+    e->next = nullptr;
+
+    AsyncHTTPRequest* request = e->request;
+    bool written = _written(request);
+    bool started = request->_client && ! request->_replay;
+
+    if (written)
+      unanswered++;
+
+    request->_client = nullptr;
+
+    if (request->_HTTPcode < 0 || started || (written && e->replays >= PIPELINE_MAX_REPLAYS))
+    {
+      *fail = e;
+      fail = &e->next;
+    }
+    else
+    {
+      if (written)
+      {
+        e->replays++;
+        _replays++;
+      }
+
+      request->_rewind();
+      *keep = e;
+      keep = &e->next;
+    }
+  }
+
+  if (dropped && unanswered > 1 && ! _fallback)
+  {
+    AHTTP_LOGDEBUG("pipeline: server dropped pipelined requests, falling back to one request at a time");
+
+    _fallback = true;
+  }
+
+  delete client;
+
+  if (_queue)
+    _connect();
+
+  // Completion callbacks last, requests they send go behind the ones being resent
+  while (failed)
+  {
+    entry* e = failed;
+    failed = e->next;
+    e->next = nullptr;
+
+    AsyncHTTPRequest* request = e->request;
+    delete e;
+
+    request->_onDisconnect(nullptr);
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTPPipeline::_onData(void* data, size_t len)
+{
+  _lock;
+
+  if ( ! _queue)
+  {
+    AHTTP_LOGDEBUG("pipeline: unexpected data");
+
+    _client->close();
+
+    return;
+  }
+
+  _queue->request->_onData(data, len);
+
+  // The rest of the segment, past the end of the head's response, belongs to the requests behind it
+  while (_pending)
+  {
+    xbuf* pending = _pending;
+    _pending = nullptr;
+
+    if ( ! _queue)
+    {
+      delete pending;
+      _closing = true;
+
+      break;
+    }
+
+    size_t   count = pending->available();
+    uint8_t* temp  = new uint8_t[count];
+
+    pending->read(temp, count);
+    delete pending;
+
+    _queue->request->_onData(temp, count);
+
+    delete[] temp;
+  }
+
+  if (_closing && _client)
+    _client->close();
+}
+
+//**************************************************************************************************************
+void AsyncHTTPPipeline::_onPoll(AsyncClient* client)
+{
+  _lock;
+
+  // Only the head is waiting on the wire, it carries the timeout
+  if (_queue && _queue->request->_client)
+    _queue->request->_onPoll(client);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPPipeline::_onError(AsyncClient* client, int8_t error)
+{
+  AHTTP_LOGDEBUG1("pipeline _onError handler error =", error);
+
+  _lock;
+
+  if (_queue)
+    _queue->request->_onError(client, error);
+}
@@ -0,0 +1,103 @@
+/****************************************************************************************************************************
+  AsyncHTTPPipeline.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+#pragma once
+
+#include <Arduino.h>
+#include <WString.h>
+
+class AsyncClient;
+class AsyncHTTPRequest;
+class xbuf;
+
+//! One persistent connection to a single origin on which GET requests are pipelined:
+//! up to maxDepth requests are written back-to-back without waiting for the responses,
+//! which the server returns in order and which are handed to each request in turn.
+//! Requests opt in with setPipeline(). If the server closes the connection mid-pipeline,
+//! requests that have not seen any of their response are replayed on a new connection
+//! (GET is idempotent), and pipelining falls back to one request at a time.
+class AsyncHTTPPipeline
+{
+    struct entry
+    {
+      entry*            next{};
+      AsyncHTTPRequest* request{};
+      uint8_t           replays{0};               // times resent on a new connection
+
+      ~entry()
+      {
+        delete next;
+      }
+    };
+
+  public:
+    AsyncHTTPPipeline();
+    ~AsyncHTTPPipeline();
+
+    void          begin(const String &host, int port = 80);             // Origin served by this pipeline
+    void          setMaxDepth(uint8_t depth);                           // Requests in flight at once (default 4, 1 = no pipelining)
+    void          close();                                              // Drop the connection, queued requests are resent
+
+    const String& host() const        { return _host; }
+    int           port() const        { return _port; }
+    bool          pipelining() const  { return ! _fallback && _maxDepth > 1; }
+    size_t        queued() const;                                       // requests waiting for their response
+    uint32_t      replays() const     { return _replays; }              // requests resent after the server closed
+
+  private:
+    String        _host;
+    int           _port{80};
+    uint8_t       _maxDepth{4};
+    bool          _fallback{false};               // server dropped a pipeline or is HTTP/1.0: one at a time
+    bool          _closing{false};                // server asked to close after the current response
+    uint32_t      _replays{0};
+    AsyncClient*  _client{nullptr};
+    entry*        _queue{nullptr};                // in order written, the head owns the incoming response
+    xbuf*         _pending{nullptr};              // bytes past the end of the head's response
+
+#ifdef ESP32
+    SemaphoreHandle_t threadLock{xSemaphoreCreateRecursiveMutex()};
+#endif
+
+    // Used by AsyncHTTPRequest
+    bool          _accepts(const String &host, int port) const;
+    void          _enqueue(AsyncHTTPRequest* request);
+    bool          _canWrite(AsyncHTTPRequest* request) const;
+    void          _finished(AsyncHTTPRequest* request);
+    void          _remove(AsyncHTTPRequest* request);
+
+    bool          _connect();
+    void          _pump();
+    static bool   _written(AsyncHTTPRequest* request);
+
+    void          _onConnect(AsyncClient* client);
+    void          _onDisconnect(AsyncClient* client);
+    void          _onData(void* data, size_t len);
+    void          _onPoll(AsyncClient* client);
+    void          _onError(AsyncClient* client, int8_t error);
+
+    friend class AsyncHTTPRequest;
+};
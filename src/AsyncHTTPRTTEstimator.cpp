@@ -0,0 +1,264 @@
+/****************************************************************************************************************************
+  AsyncHTTPRTTEstimator.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+
+#include "AsyncHTTPRequest.h"
+
+namespace {
+#if ESP32
+class LockHelper
+{
+public:
+    LockHelper(QueueHandle_t _xMutex) :
+        xMutex{_xMutex}
+    {
+        xSemaphoreTakeRecursive(xMutex, portMAX_DELAY);
+    }
+    ~LockHelper()
+    {
+        xSemaphoreGiveRecursive(xMutex);
+    }
+
+private:
+    const QueueHandle_t xMutex;
+};
+#define _lock LockHelper lock{this->threadLock}
+#else
+#define _lock
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPRTTEstimator::AsyncHTTPRTTEstimator()
+{
+}
+
+//**************************************************************************************************************
+AsyncHTTPRTTEstimator::~AsyncHTTPRTTEstimator()
+{
+  delete _origins;
+
+#ifdef ESP32
+  vSemaphoreDelete(threadLock);
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPRTTEstimator& AsyncHTTPRTTEstimator::instance()
+{
+  static AsyncHTTPRTTEstimator estimator;
+
+  return estimator;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRTTEstimator::setBounds(uint32_t minMs, uint32_t maxMs)
+{
+  _min = minMs;
+  _max = maxMs < minMs ? minMs : maxMs;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRTTEstimator::sampleConnect(const String &host, int port, uint32_t ms)
+{
+  _lock;
+
+  AHTTP_LOGDEBUG3("rtt connect sample", host, ", ms =", ms);
+
+  entry* e = _find(host, port, true);
+
+  _sample(e->connect, ms);
+  e->backoff = 0;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRTTEstimator::sampleFirstByte(const String &host, int port, uint32_t ms)
+{
+  _lock;
+
+  AHTTP_LOGDEBUG3("rtt first byte sample", host, ", ms =", ms);
+
+  entry* e = _find(host, port, true);
+
+  _sample(e->firstByte, ms);
+  e->backoff = 0;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRTTEstimator::timedOut(const String &host, int port)
+{
+  _lock;
+
+  entry* e = _find(host, port, false);
+
+  // Like TCP's RTO: wait twice as long next time, until a sample shows how long it really takes
+  if (e && e->backoff < RTT_MAX_BACKOFF)
+    e->backoff++;
+}
+
+//**************************************************************************************************************
+uint32_t AsyncHTTPRTTEstimator::connectTimeout(const String &host, int port)
+{
+  _lock;
+
+  entry* e = _find(host, port, false);
+
+  return e ? _timeout(e, e->connect) : 0;
+}
+
+//**************************************************************************************************************
+uint32_t AsyncHTTPRTTEstimator::firstByteTimeout(const String &host, int port)
+{
+  _lock;
+
+  entry* e = _find(host, port, false);
+
+  return e ? _timeout(e, e->firstByte) : 0;
+}
+
+//**************************************************************************************************************
+uint32_t AsyncHTTPRTTEstimator::smoothedRTT(const String &host, int port)
+{
+  _lock;
+
+  entry* e = _find(host, port, false);
+
+  return e && e->connect.valid ? e->connect.srtt : 0;
+}
+
+//**************************************************************************************************************
+uint32_t AsyncHTTPRTTEstimator::percentile95(const String &host, int port)
+{
+  _lock;
+
+  entry* e = _find(host, port, false);
+
+  if ( ! e || ! e->connect.valid || ! e->firstByte.valid)
+    return 0;
+
+  // rttvar is a mean deviation, about 0.8 sigma: mean + 2 rttvar is near mean + 1.65 sigma
+  return e->connect.srtt + e->firstByte.srtt + 2 * (e->connect.rttvar + e->firstByte.rttvar);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRTTEstimator::flush()
+{
+  _lock;
+
+  delete _origins;
+  _origins = nullptr;
+}
+
+//**************************************************************************************************************
+AsyncHTTPRTTEstimator::entry* AsyncHTTPRTTEstimator::_find(const String &host, int port, bool create)
+{
+  entry* tail = (entry*) &_origins;
+  entry* found = nullptr;
+  uint8_t count = 0;
+
+  while (tail->next)
+  {
+    if (tail->next->port == port && tail->next->host.equalsIgnoreCase(host))
+    {
+      found = tail->next;
+
+      if ( ! create)
+        return found;
+
+      // Sampled now, it goes last
+      tail->next = found->next;
+      found->next = nullptr;
+    }
+    else
+    {
+      tail = tail->next;
+      count++;
+    }
+  }
+
+  if ( ! create)
+    return nullptr;
+
+  if ( ! found)
+  {
+    if (count >= RTT_MAX_ORIGINS)
+    {
+      entry* oldest = _origins;
+      _origins = oldest->next;
+      oldest->next = nullptr;
+      delete oldest;
+      tail = (entry*) &_origins;
+
+      while (tail->next)
+        tail = tail->next;
+    }
+
+    found = new entry;
+    found->host = host;
+    found->port = port;
+  }
+
+  tail->next = found;
+
+  return found;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRTTEstimator::_sample(estimate &est, uint32_t ms)
+{
+  // RFC 6298 2.2 and 2.3, alpha 1/8, beta 1/4
+  if ( ! est.valid)
+  {
+    est.srtt   = ms;
+    est.rttvar = ms / 2;
+    est.valid  = true;
+
+    return;
+  }
+
+  uint32_t delta = est.srtt > ms ? est.srtt - ms : ms - est.srtt;
+
+  est.rttvar = (3 * est.rttvar + delta) / 4;
+  est.srtt   = (7 * est.srtt + ms) / 8;
+}
+
+//**************************************************************************************************************
+uint32_t AsyncHTTPRTTEstimator::_timeout(const entry* e, const estimate &est) const
+{
+  if ( ! est.valid)
+    return 0;
+
+  // RTO = SRTT + max(G, 4 * RTTVAR), G being the timer wheel's granularity
+  uint32_t variance = 4 * est.rttvar;
+  uint32_t timeout  = est.srtt + (variance > TIMER_WHEEL_TICK_MS ? variance : TIMER_WHEEL_TICK_MS);
+
+  if (timeout < _min)
+    timeout = _min;
+
+  timeout <<= e->backoff;
+
+  return timeout > _max ? _max : timeout;
+}
@@ -0,0 +1,94 @@
+/****************************************************************************************************************************
+  AsyncHTTPRTTEstimator.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+#pragma once
+
+#include <Arduino.h>
+#include <WString.h>
+
+#define RTT_MAX_ORIGINS           8               // origins whose round trip times are tracked
+#define RTT_MAX_BACKOFF           4               // timeouts in a row double the derived deadlines up to 16x
+
+//! Per origin (host:port) smoothed round trip time and variance, kept the way TCP does for its retransmission
+//! timeout (RFC 6298), for two phases: the TCP connect and the time to the first response byte.
+//! Requests that opt in with setAdaptiveTimeouts() feed it every sample and take their connect, first-byte and
+//! idle deadlines from it: srtt + 4 * rttvar, within the bounds. Deadlines adapt to the link, short on a LAN and
+//! long on a cellular one. A timeout doubles the next deadlines for the origin until a new sample arrives.
+//! Until an origin has samples, the request's static timeouts apply.
+class AsyncHTTPRTTEstimator
+{
+    struct estimate
+    {
+      uint32_t    srtt{0};                        // ms
+      uint32_t    rttvar{0};                      // ms
+      bool        valid{false};
+    };
+
+    struct entry
+    {
+      entry*      next{};
+      String      host;
+      int         port{0};
+      estimate    connect;
+      estimate    firstByte;
+      uint8_t     backoff{0};                     // timeouts since the last sample
+
+      ~entry()
+      {
+        delete next;
+      }
+    };
+
+  public:
+    AsyncHTTPRTTEstimator();
+    ~AsyncHTTPRTTEstimator();
+
+    static AsyncHTTPRTTEstimator& instance();                           // The shared estimator
+
+    void        setBounds(uint32_t minMs, uint32_t maxMs);              // Range of derived deadlines (default 250, 30000)
+
+    void        sampleConnect(const String &host, int port, uint32_t ms);
+    void        sampleFirstByte(const String &host, int port, uint32_t ms);
+    void        timedOut(const String &host, int port);                 // A derived deadline passed
+    uint32_t    connectTimeout(const String &host, int port);           // Derived deadline, 0 without samples
+    uint32_t    firstByteTimeout(const String &host, int port);         // Derived deadline, 0 without samples
+    uint32_t    smoothedRTT(const String &host, int port);              // Connect srtt, 0 without samples
+    uint32_t    percentile95(const String &host, int port);             // Rough p95 of connect plus first byte, 0 without samples
+    void        flush();
+
+  private:
+    entry*      _origins{nullptr};                // least recently sampled first
+    uint32_t    _min{250};
+    uint32_t    _max{30000};
+
+#ifdef ESP32
+    SemaphoreHandle_t threadLock{xSemaphoreCreateRecursiveMutex()};
+#endif
+
+    entry*      _find(const String &host, int port, bool create);
+    void        _sample(estimate &est, uint32_t ms);
+    uint32_t    _timeout(const entry* e, const estimate &est) const;
+};
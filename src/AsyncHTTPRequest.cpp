@@ -103,15 +103,40 @@ std::optional<URL> parseURL(const String &url)
   return _URL;
 }
 
+uint32_t AsyncHTTPRequest::_hedgesFired = 0;
+uint32_t AsyncHTTPRequest::_hedgesWon   = 0;
 
 //**************************************************************************************************************
 AsyncHTTPRequest::~AsyncHTTPRequest()
 {
+  AsyncHTTPTimerWheel::instance().cancel(_deadline);
+  AsyncHTTPTimerWheel::instance().cancel(_retryTimer);
+  AsyncHTTPTimerWheel::instance().cancel(_hedgeTimer);
+
+  _leave();
+
+  if (_coalescer)
+    _coalescer->_remove(this);
+
+  _releaseFollowers();
+
+  if (_piped)
+    _pipeline->_remove(this);
+
+  if (_h2)
+    _session->_remove(this);
+
   if (_client)
-    _client->close(true);
+    _dropClient();
+
+  delete _hedge;
 
   delete _headers;
   delete _request;
+  delete _replay;
+  delete _surplus;
+  delete _sent;
+  delete _cacheBody;
   delete _response;
   delete _chunks;
 
@@ -155,31 +180,117 @@ bool  AsyncHTTPRequest::open(const URL &url, HTTPmethod method)
 
   _requestStartTime = millis();
 
+  // Sent but not yet connected, it is still queued
+  if (_piped)
+    _pipeline->_remove(this);
+
+  if (_h2)
+    _session->_remove(this);
+
+  // Whatever was shared before ends here
+  _leave();
+
+  if (_coalescer)
+    _coalescer->_remove(this);
+
+  _releaseFollowers();
+  _connectPending = false;
+  _fromCache      = false;
+  _revalidating   = false;
+
+  delete _cacheBody;
+  _cacheBody = nullptr;
+
   delete _headers;
   delete _request;
   delete _response;
   delete _chunks;
+  delete _surplus;
 
   _headers      = nullptr;
   _response     = nullptr;
   _request      = nullptr;
   _chunks       = nullptr;
+  _surplus      = nullptr;
   _chunked      = false;
+  _closeDelimited = false;
+  _HTTPcode     = 0;
   _contentRead  = 0;
+  _rangeStart   = 0;
+  _rangeTotal   = 0;
+  _sendPaused   = false;
+  _awaitingResponse = false;
+  _streaming    = false;
   _readyState   = ReadyState::Unsent;
+  _digest.begin(_digest.type());
+
+  if (_json)
+    _json->reset();
+
+  if (_sse)
+    _sse->resume();
+
   _HTTPmethod = method;
 
   _URL = url;
 
-  if ( _client && _client->connected() && (_URL.host != _connectedHost || _URL.port != _connectedPort))
+  // A retry resends exactly what went out, keep a copy of it
+  AsyncHTTPTimerWheel::instance().cancel(_retryTimer);
+  _retryPending = false;
+  _aborted      = false;
+  _attempt      = 0;
+
+  // A hedge copies what went out too
+  _stopHedge();
+  _hedged = false;
+
+  delete _sent;
+  _sent = (_retry || _hedgeDelay) ? new xbuf : nullptr;
+
+  if (_retry)
+    _retry->deposit(_URL.host);
+
+  // What is written changes what is stored
+  if (_cache && method != HTTPmethod::GET)
+    _cache->_remove(_cacheKey(HTTPmethod::GET));
+
+  // Anything to the session's origin is a stream on its connection, which streams of any length share
+  _h2 = _session && _session->_accepts(_URL.host, _URL.port);
+
+  // GETs to the pipeline's origin are written on its connection, when send() queues them; a stream would never let go of it
+  _piped = ! _h2 && _pipeline && method == HTTPmethod::GET && ! _sse && _pipeline->_accepts(_URL.host, _URL.port);
+
+  // Keep a live connection only for the same origin and only while the server still promises to hold it
+  if (_client && (_piped || _h2 || _URL.host != _connectedHost || _URL.port != _connectedPort || ! _client->connected() ||
+                  (_keepAliveTimeout && (millis() - _requestEndTime) >= _keepAliveTimeout)))
   {
-    return false;
+    _dropClient();
   }
 
   _addHeader("host", _URL.host + ':' + _URL.port);
   _lastActivity = millis();
 
-  return _connect();
+  // Asked for as a stream, from where the last connection to it left off
+  if (_sse && method == HTTPmethod::GET)
+  {
+    _addHeader("Accept", "text/event-stream");
+    _addHeader("Cache-Control", "no-cache");
+
+    if (_sse->lastEventId().length())
+      _addHeader("Last-Event-ID", _sse->lastEventId());
+  }
+
+  // Fresh in the cache, or already on its way: send() decides once the request headers are known
+  if (method == HTTPmethod::GET &&
+      ((_cache && _cache->_fresh(_cache->_find(_cacheKey(method)))) ||
+       (_coalescer && ! _piped && ! _client && _coalescer->_find(_coalesceKey(true), true))))
+  {
+    _connectPending = true;
+
+    return true;
+  }
+
+  return _startExchange();
 }
 //**************************************************************************************************************
 void AsyncHTTPRequest::onReadyStateChange(readyStateChangeCB cb, callback_arg_t arg)
@@ -199,7 +310,86 @@ void  AsyncHTTPRequest::setTimeout(int seconds)
 {
   AHTTP_LOGDEBUG1("setTimeout = ", seconds);
 
-  _timeout = seconds;
+  setIdleTimeout(seconds * 1000);
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::setIdleTimeout(uint32_t ms)
+{
+  AHTTP_LOGDEBUG1("setIdleTimeout = ", ms);
+
+  _lock;
+  _timeout = ms;
+  _armDeadline();
+  _unlock;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::setConnectTimeout(uint32_t ms)
+{
+  AHTTP_LOGDEBUG1("setConnectTimeout = ", ms);
+
+  _lock;
+  _connectTimeout = ms;
+  _armDeadline();
+  _unlock;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::setFirstByteTimeout(uint32_t ms)
+{
+  AHTTP_LOGDEBUG1("setFirstByteTimeout = ", ms);
+
+  _lock;
+  _firstByteTimeout = ms;
+  _armDeadline();
+  _unlock;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::setTotalTimeout(uint32_t ms)
+{
+  AHTTP_LOGDEBUG1("setTotalTimeout = ", ms);
+
+  _lock;
+  _totalTimeout = ms;
+  _armDeadline();
+  _unlock;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::setAdaptiveTimeouts(AsyncHTTPRTTEstimator* estimator)
+{
+  _lock;
+  _rtt = estimator;
+  _rttConnect = 0;
+  _rttFirstByte = 0;
+  _unlock;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::setHedging(uint32_t delayMs, AsyncHTTPRTTEstimator* estimator)
+{
+  AHTTP_LOGDEBUG1("setHedging = ", delayMs);
+
+  _lock;
+  _hedgeDelay = delayMs;
+  _hedgeRTT = estimator;
+
+  if ( ! _hedgeDelay)
+    _stopHedge();
+  else if ( ! _sent && _readyState == ReadyState::Unsent)
+    _sent = new xbuf;
+
+  _unlock;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::setMaxResponseLength(size_t bytes)
+{
+  AHTTP_LOGDEBUG1("setMaxResponseLength = ", bytes);
+
+  _maxResponseLength = bytes;
 }
 
 //**************************************************************************************************************
@@ -208,6 +398,14 @@ bool  AsyncHTTPRequest::send()
   AHTTP_LOGDEBUG("send()");
 
   _lock;
+
+  // Answered from the cache, or by an identical GET already in flight: nothing to send
+  if (_connectPending && (_serveCached() || _coalesce()))
+  {
+    _connectPending = false;
+    _unlock;
+    return true;
+  }
   
   if (!_buildRequest())
     return false;
@@ -311,6 +509,52 @@ void AsyncHTTPRequest::abort()
   AHTTP_LOGDEBUG("abort()");
 
   _lock;
+
+  _aborted = true;
+  _stopHedge();
+
+  // Between attempts, nothing is connected: just end with the last failure
+  if (_retryPending)
+  {
+    AsyncHTTPTimerWheel::instance().cancel(_retryTimer);
+    _retryPending = false;
+    _setReadyState(ReadyState::Done);
+
+    return;
+  }
+
+  // Not ours to abort, only stop sharing it
+  if (_leader)
+  {
+    _leave();
+    _onDisconnect(nullptr);
+
+    return;
+  }
+
+  // The pipeline owns the connection, only leave it
+  if (_piped)
+  {
+    if (_readyState != ReadyState::Done)
+    {
+      _pipeline->_remove(this);
+      _onDisconnect(nullptr);
+    }
+
+    return;
+  }
+
+  // Only this stream is reset, the session's connection carries the others
+  if (_h2)
+  {
+    if (_readyState != ReadyState::Done)
+    {
+      _session->_remove(this);
+      _onDisconnect(nullptr);
+    }
+
+    return;
+  }
   
   if (! _client) 
     return;
@@ -318,6 +562,24 @@ void AsyncHTTPRequest::abort()
   _client->abort();
   _unlock;
 }
+//**************************************************************************************************************
+void AsyncHTTPRequest::pauseSend(bool pause)
+{
+  AHTTP_LOGDEBUG1("pauseSend", pause);
+
+  _lock;
+
+  _sendPaused = pause;
+
+  if ( ! pause && (_client || _h2) && _request)
+    _send();
+
+  // Idle time isn't counted while paused, it starts again from here
+  _lastActivity = millis();
+  _armDeadline();
+  _unlock;
+}
+
 //**************************************************************************************************************
 ReadyState  AsyncHTTPRequest::readyState() const
 {
@@ -354,7 +616,10 @@ String AsyncHTTPRequest::responseText()
     AHTTP_LOGDEBUG("responseText() no buffer");
 
     _HTTPcode = HttpCode::TOO_LESS_RAM;
-    _client->abort();
+
+    if (_client)
+      _client->abort();
+
     _unlock;
     
     return String();
@@ -363,6 +628,10 @@ String AsyncHTTPRequest::responseText()
   localString = _response->readString(avail);
   _contentRead += localString.length();
 
+  // Room for more of the response: the server may send it
+  if (_h2)
+    _session->_consumed(this);
+
   AHTTP_LOGDEBUG3("responseText(char)", localString.substring(0, 16).c_str(), ", avail =", avail);
 
   _unlock;
@@ -388,11 +657,33 @@ size_t AsyncHTTPRequest::responseRead(uint8_t* buf, size_t len)
   AHTTP_LOGDEBUG3("responseRead(char)", (char*) buf, ", avail =", avail);
 
   _contentRead += avail;
+
+  if (_h2)
+    _session->_consumed(this);
+
   _unlock;
 
   return avail;
 }
 
+//**************************************************************************************************************
+size_t AsyncHTTPRequest::responseRangeStart() const
+{
+  if (_readyState < ReadyState::HdrsRecvd)
+    return 0;
+
+  return _rangeStart;
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTPRequest::responseRangeTotal() const
+{
+  if (_readyState < ReadyState::HdrsRecvd)
+    return 0;
+
+  return _rangeTotal;
+}
+
 //**************************************************************************************************************
 size_t  AsyncHTTPRequest::available() const
 {
@@ -439,6 +730,108 @@ uint32_t AsyncHTTPRequest::elapsedTime() const
   return _requestEndTime - _requestStartTime;
 }
 
+//**************************************************************************************************************
+void AsyncHTTPRequest::setDigest(DigestType type, const char* verifyHeader)
+{
+  AHTTP_LOGDEBUG1("setDigest type =", int(type));
+
+  _digest.begin(type);
+  _digestHeader = verifyHeader ? verifyHeader : "";
+}
+
+//**************************************************************************************************************
+String AsyncHTTPRequest::responseDigest() const
+{
+  if ( ! _digest.finished())
+    return String();
+
+  return _digest.hex();
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRequest::setConnectionPool(AsyncHTTPConnectionPool* pool)
+{
+  _pool = pool;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRequest::setPipeline(AsyncHTTPPipeline* pipeline)
+{
+  _pipeline = pipeline;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRequest::setHTTP2(AsyncHTTP2Session* session)
+{
+  _session = session;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRequest::setDNSCache(AsyncHTTPDNSCache* cache)
+{
+  _dns = cache;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRequest::setRetryPolicy(AsyncHTTPRetryPolicy* policy)
+{
+  _retry = policy;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRequest::setCircuitBreaker(AsyncHTTPCircuitBreaker* breaker)
+{
+  _breaker = breaker;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRequest::setCoalescer(AsyncHTTPCoalescer* coalescer)
+{
+  _coalescer = coalescer;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRequest::setResponseCache(AsyncHTTPResponseCache* cache)
+{
+  _cache = cache;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRequest::setJsonParser(xjson* parser, bool keepBody)
+{
+  AHTTP_LOGDEBUG1("setJsonParser keepBody =", keepBody);
+
+  _json = parser;
+  _jsonKeepBody = keepBody;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRequest::setEventStream(xsse* parser)
+{
+  AHTTP_LOGDEBUG1("setEventStream", parser ? "on" : "off");
+
+  _sse = parser;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRequest::setStreaming(bool on)
+{
+  AHTTP_LOGDEBUG1("setStreaming", on ? "on" : "off");
+
+  _streamMode = on;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRequest::setHeartbeat(uint32_t ms)
+{
+  AHTTP_LOGDEBUG1("setHeartbeat = ", ms);
+
+  _lock;
+  _heartbeat = ms;
+  _armDeadline();
+  _unlock;
+}
+
 //**************************************************************************************************************
 String AsyncHTTPRequest::version() const
 {
@@ -455,67 +848,230 @@ String AsyncHTTPRequest::version() const
   _______________________________________________________________________________________________________________*/
 
 //**************************************************************************************************************
-bool  AsyncHTTPRequest::_connect()
+bool  AsyncHTTPRequest::_startExchange()
 {
-  AHTTP_LOGDEBUG("_connect()");
-
-  if ( ! _client)
+  if ( ! _piped && ! _h2)
   {
-    _client = new AsyncClient();
+    // Not connected, but a retry may be on its way
+    return _connect() || _retryPending;
   }
 
-  _connectedHost = _URL.host;
-  _connectedPort = _URL.port;
-  
-  _client->onConnect([](void *obj, AsyncClient * client) 
-  {
-    ((AsyncHTTPRequest*)(obj))->_onConnect(client);
-  }, this);
-  
-  _client->onDisconnect([](void *obj, AsyncClient * client) 
-  {
-    ((AsyncHTTPRequest*)(obj))->_onDisconnect(client);
-  }, this);
-  
-  _client->onPoll([](void *obj, AsyncClient * client) 
-  {
-    ((AsyncHTTPRequest*)(obj))->_onPoll(client);
-  }, this);
-  
-  _client->onError([](void *obj, AsyncClient * client, uint32_t error) 
-  {
-    ((AsyncHTTPRequest*)(obj))->_onError(client, error);
-  }, this);
-
-  if ( ! _client->connected())
+  if (_breaker && ! _breaker->allow(_URL.host, _URL.port))
   {
-    if ( ! _client->connect(_URL.host.c_str(), _URL.port))
-    {
-      AHTTP_LOGDEBUG3("client.connect failed:", _URL.host, ",", _URL.port);
-
-      _HTTPcode = HttpCode::NOT_CONNECTED;
-      _setReadyState(ReadyState::Done);
+    _HTTPcode = HttpCode::CIRCUIT_OPEN;
+    _setReadyState(ReadyState::Done);
 
-      return false;
-    }
-  }
-  else
-  {
-    _onConnect(_client);
+    return false;
   }
 
-  _lastActivity = millis();
+  if (_rtt)
+    _rttFirstByte = _rtt->firstByteTimeout(_URL.host, _URL.port);
+
+  _armDeadline();
 
   return true;
 }
 
 //**************************************************************************************************************
-bool   AsyncHTTPRequest::_buildRequest()
+bool  AsyncHTTPRequest::_connect()
 {
-  AHTTP_LOGDEBUG("_buildRequest()");
+  AHTTP_LOGDEBUG("_connect()");
 
-  // Build the header.
-  if ( ! _request)
+  // Origin known to be down, don't tie up a connection finding out again
+  if (_breaker && ! _breaker->allow(_URL.host, _URL.port))
+  {
+    _HTTPcode = HttpCode::CIRCUIT_OPEN;
+    _setReadyState(ReadyState::Done);
+
+    return false;
+  }
+
+  // Deadlines as this origin's round trip times currently suggest
+  if (_rtt)
+  {
+    _rttConnect   = _rtt->connectTimeout(_URL.host, _URL.port);
+    _rttFirstByte = _rtt->firstByteTimeout(_URL.host, _URL.port);
+  }
+
+  if ( ! _client && _pool)
+  {
+    _client = _pool->checkout(_URL.host, _URL.port);
+  }
+
+  if ( ! _client)
+  {
+    _client = new AsyncClient();
+  }
+
+  _connectedHost = _URL.host;
+  _connectedPort = _URL.port;
+
+  _bindClient();
+
+  delete _replay;
+  _replay = nullptr;
+
+  _awaitingResponse = false;
+  _connectStartTime = millis();
+  _timingConnect    = false;
+
+  if (_client->connecting())
+  {
+    // Preconnected by the pool and still in the handshake, its onConnect now comes here
+    AHTTP_LOGDEBUG3("*preconnect under way:", _URL.host, ",", _URL.port);
+
+    _connectByName = _dns != nullptr;
+    _connectByCache = false;
+  }
+  else if ( ! _client->connected())
+  {
+    IPAddress address;
+
+    _connectByCache = _dns && _dns->lookup(_URL.host, address);
+    _connectByName  = _dns && ! _connectByCache;
+
+    if (_connectByName && _dns->failed(_URL.host))
+    {
+      // Lookup failed a moment ago, don't wait on the resolver again
+      AHTTP_LOGDEBUG1("dns negative cache:", _URL.host);
+
+      _HTTPcode = HttpCode::NOT_CONNECTED;
+      _setReadyState(ReadyState::Done);
+
+      return false;
+    }
+
+    _timingConnect = true;
+
+    if (_connectByCache ? ! _client->connect(address, _URL.port) : ! _client->connect(_URL.host.c_str(), _URL.port))
+    {
+      AHTTP_LOGDEBUG3("client.connect failed:", _URL.host, ",", _URL.port);
+
+      _HTTPcode = HttpCode::NOT_CONNECTED;
+      _setReadyState(ReadyState::Done);
+
+      return false;
+    }
+  }
+  else
+  {
+    // Reused idle connection: keep what is sent, in case the server had already dropped it
+    _replay = new xbuf;
+    _onConnect(_client);
+  }
+
+  _lastActivity = millis();
+  _armDeadline();
+
+  return true;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_bindClient()
+{
+  _client->onConnect([](void *obj, AsyncClient * client) 
+  {
+    ((AsyncHTTPRequest*)(obj))->_onConnect(client);
+  }, this);
+  
+  _client->onDisconnect([](void *obj, AsyncClient * client) 
+  {
+    ((AsyncHTTPRequest*)(obj))->_onDisconnect(client);
+  }, this);
+  
+  _client->onPoll([](void *obj, AsyncClient * client) 
+  {
+    ((AsyncHTTPRequest*)(obj))->_onPoll(client);
+  }, this);
+  
+  _client->onError([](void *obj, AsyncClient * client, uint32_t error) 
+  {
+    ((AsyncHTTPRequest*)(obj))->_onError(client, error);
+  }, this);
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_dropClient()
+{
+  AHTTP_LOGDEBUG3("_dropClient()", _connectedHost, ":", _connectedPort);
+
+  // Detach first, this isn't the end of the current request
+  _client->onDisconnect(nullptr, nullptr);
+  _client->onPoll(nullptr, nullptr);
+  _client->onData(nullptr, nullptr);
+  _client->onAck(nullptr, nullptr);
+  _client->onError(nullptr, nullptr);
+  _client->close(true);
+  delete _client;
+  _client = nullptr;
+
+  _connectedHost = String{};
+  _connectedPort = -1;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_rewind()
+{
+  if ( ! _replay)
+    return;
+
+  // What was already sent goes back in front of what wasn't, ready to go out again
+  if (_request)
+    _replay->write(_request, _request->available());
+
+  delete _request;
+  _request = _replay;
+  _replay = nullptr;
+
+  // Copied again as it goes out
+  if (_sent)
+    _sent->flush();
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_keepSurplus(const uint8_t* data, size_t len)
+{
+  if ( ! len)
+    return;
+
+  // Only a pipelined response can be followed by another one, otherwise the server is misbehaving
+  if ( ! _piped)
+  {
+    AHTTP_LOGDEBUG1("*ignoring data past end of response, len =", len);
+
+    return;
+  }
+
+  if ( ! _surplus)
+    _surplus = new xbuf;
+
+  _surplus->write(data, len);
+}
+
+//**************************************************************************************************************
+bool   AsyncHTTPRequest::_buildRequest()
+{
+  AHTTP_LOGDEBUG("_buildRequest()");
+
+  // open() held the connect back and neither the cache nor a GET in flight could answer: fetch it after all
+  if (_connectPending)
+  {
+    _connectPending = false;
+
+    if ( ! _startExchange())
+      return false;
+  }
+
+  // Stale but checkable: ask whether it changed, otherwise it has to come in full
+  if (_cache && _HTTPmethod == HTTPmethod::GET && ! _sse && ! _cacheValidate())
+    _cache->_misses++;
+
+  // Others asking for the same meanwhile can share this response
+  if (_coalescer && _HTTPmethod == HTTPmethod::GET && ! _piped && _readyState != ReadyState::Done)
+    _coalescer->_add(_coalesceKey(), this);
+
+  // Build the header.
+  if ( ! _request)
     _request = new xbuf;
 
   _request->write(toString<String>(_HTTPmethod));
@@ -526,12 +1082,20 @@ bool   AsyncHTTPRequest::_buildRequest()
 
   header* hdr = _headers;
 
+  if (_sse)
+    _streamHeaders = String();
+
   while (hdr)
   {
     _request->write(hdr->name);
     _request->write(':');
     _request->write(hdr->value);
     _request->write("\r\n");
+
+    // A reconnect asks for the stream the same way, only from further on
+    if (_sse && ! hdr->name.equalsIgnoreCase("host") && ! hdr->name.equalsIgnoreCase("Last-Event-ID"))
+      _streamHeaders += hdr->name + ": " + hdr->value + "\r\n";
+
     hdr = hdr->next;
   }
 
@@ -540,6 +1104,8 @@ bool   AsyncHTTPRequest::_buildRequest()
 
   _request->write("\r\n");
 
+  _armHedge();
+
   return true;
 }
 
@@ -551,7 +1117,48 @@ size_t  AsyncHTTPRequest::_send()
 
   AHTTP_LOGDEBUG1("_send(), _request->available =", _request->available());
 
-  if ( ! _client->connected() || ! _client->canSend())
+  if (_piped && ! _client)
+  {
+    // Queue on the pipeline, written when it is connected and the requests ahead allow
+    _pipeline->_enqueue(this);
+
+    return 0;
+  }
+
+  if (_h2 && ! _session->_find(this))
+  {
+    // Queue on the session, opened as a stream once it is connected and has one free
+    _session->_enqueue(this);
+
+    return 0;
+  }
+
+  if (_piped && ! _pipeline->_canWrite(this))
+  {
+    AHTTP_LOGDEBUG("*waiting in pipeline");
+
+    return 0;
+  }
+
+  if (_sendPaused)
+  {
+    AHTTP_LOGDEBUG("*send paused");
+
+    return 0;
+  }
+
+  if (_h2)
+  {
+    // Framed onto the session's connection, as much as its windows allow
+    size_t sent = _session->_write(this);
+
+    if (sent)
+      _lastActivity = millis();
+
+    return sent;
+  }
+
+  if ( ! _client || ! _client->connected() || ! _client->canSend())
   {
     AHTTP_LOGDEBUG("*can't send");
 
@@ -572,147 +1179,1244 @@ size_t  AsyncHTTPRequest::_send()
     size_t chunk = supply < 100 ? supply : 100;
     supply -= _request->read(temp, chunk);
     sent += _client->add((char*)temp, chunk);
+
+    if (_replay)
+      _replay->write(temp, chunk);
+
+    if (_sent)
+      _sent->write(temp, chunk);
+  }
+
+  delete[] temp;
+
+  if (_request->available() == 0)
+    _allSent();
+
+  _client->send();
+
+  AHTTP_LOGDEBUG1("*send", sent);
+
+  _lastActivity = millis();
+
+  return sent;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_allSent()
+{
+  delete _request;
+  _request = nullptr;
+
+  // All out, the first-byte deadline runs from here
+  _sentTime = millis();
+  _awaitingResponse = true;
+  _armDeadline();
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_setReadyState(ReadyState readyState)
+{
+  if (_readyState != readyState)
+  {
+    if (readyState == ReadyState::Done && _retryPending)
+      return;
+
+    // Every attempt counts towards the origin's health, retried or not
+    if (readyState == ReadyState::Done && _breaker && ! _aborted && ! _leader && ! (_fromCache && ! _revalidating))
+      _breaker->record(_URL.host, _URL.port, _HTTPcode);
+
+    // The race ends with the attempt, whoever answered
+    if (readyState == ReadyState::Done)
+      _stopHedge();
+
+    // Failed but retryable: back to Unsent until the next attempt, Done isn't reported
+    if (readyState == ReadyState::Done && _scheduleRetry())
+      return;
+
+    // An event stream that dropped is picked up again, the application only hears of it ending for good
+    if (readyState == ReadyState::Done && _scheduleReconnect())
+      return;
+
+    if (readyState == ReadyState::Done)
+    {
+      delete _sent;
+      _sent = nullptr;
+
+      // No longer to be joined, and those sharing the response end with it
+      _leave();
+
+      if (_coalescer)
+        _coalescer->_remove(this);
+
+      _releaseFollowers();
+    }
+
+    if (readyState == ReadyState::Done && _digest.type() != DigestType::None && ! _digest.finished())
+    {
+      _digest.finish();
+
+      header* hdr = _digestHeader.length() ? _getHeader(_digestHeader) : nullptr;
+
+      if (_HTTPcode > 0 && _readyState >= ReadyState::HdrsRecvd && hdr && ! _digest.matches(hdr->value))
+      {
+        AHTTP_LOGDEBUG3("*digest mismatch", _digest.hex(), "expected", hdr->value);
+
+        _HTTPcode = HttpCode::DIGEST_MISMATCH;
+      }
+    }
+
+    if (readyState == ReadyState::Done && _cacheBody)
+      _cacheStore();
+
+    _readyState = readyState;
+
+    AHTTP_LOGDEBUG1("_setReadyState :", int(_readyState));
+
+    if (_readyState == ReadyState::Done)
+      AsyncHTTPTimerWheel::instance().cancel(_deadline);
+
+    if (_readyStateChangeCB)
+    {
+      // Done reached while a segment is being parsed: report it once _onData() is finished with the buffers,
+      // so the callback may open() this request again
+      if (_readyState == ReadyState::Done && _inData)
+      {
+        _doneDeferred = true;
+
+        return;
+      }
+
+      _readyStateChangeCB(_readyStateChangeCBarg, this, _readyState);
+    }
   }
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_processChunks()
+{
+  while (_chunks->available())
+  {
+    AHTTP_LOGDEBUG3("_processChunks()", _chunks->peekString(16).c_str(), ", chunks available =", _chunks->available());
 
-  delete temp;
+    size_t _chunkRemaining = _contentLength - _contentRead - _response->available();
+    _chunkRemaining -= _writeBody(_chunks, _chunkRemaining);
+
+    if (_chunks->indexOf("\r\n") == -1)
+    {
+      return;
+    }
+
+    String chunkHeader = _chunks->readStringUntil("\r\n");
+
+    AHTTP_LOGDEBUG3("*getChunkHeader", chunkHeader.c_str(), ", chunkHeader length =", chunkHeader.length());
+
+    // After the last chunk: trailer fields (ignored) up to the empty line that ends the message
+    if (_trailers)
+    {
+      if (chunkHeader.length() != 2)
+        continue;
+
+      AHTTP_LOGDEBUG("*all chunks received");
+
+      while (_chunks->available())
+      {
+        uint8_t temp[64];
+        size_t  count = _chunks->read(temp, sizeof(temp));
+        _keepSurplus(temp, count);
+      }
+
+      _finishResponse();
+
+      return;
+    }
+
+    // Bare CRLF terminating the previous chunk's data, not a chunk header
+    if (chunkHeader.length() == 2)
+      continue;
+
+    size_t chunkLength = strtol(chunkHeader.c_str(), nullptr, 16);
+
+    // A stream counts from the chunk it is in, totals would only grow for as long as it runs
+    if (_streaming)
+    {
+      _contentLength -= _contentRead;
+      _contentRead = 0;
+    }
+
+    _contentLength += chunkLength;
+
+    if ( ! _streaming && _tooLarge(_contentLength))
+      return;
+
+    if (chunkLength == 0)
+      _trailers = true;
+  }
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_finishResponse()
+{
+  if (_piped)
+  {
+    // The pipeline keeps the connection and hands what follows to the next request
+    _client = nullptr;
+    _pipeline->_finished(this);
+  }
+  else if (_h2)
+  {
+    // Only the stream ends, the session keeps the connection for the others
+    _session->_finished(this);
+  }
+  else if ( ! _keepAlive && _client)
+  {
+    AHTTP_LOGDEBUG("*closing TCP");
+
+    _client->close();
+  }
+  else if (_pool && _client)
+  {
+    AHTTP_LOGDEBUG("*keep-alive, returning connection to pool");
+
+    // Hand the connection over before Done, so a request opened from the callback can pick it up
+    AsyncClient* client = _client;
+    _client = nullptr;
+    _pool->checkin(client, _connectedHost, _connectedPort, _keepAliveTimeout);
+
+    _connectedHost = String{};
+    _connectedPort = -1;
+  }
+  else
+  {
+    AHTTP_LOGDEBUG("*keep-alive");
+  }
+
+  _requestEndTime = millis();
+  _lastActivity = 0;
+  _setReadyState(ReadyState::Done);
+}
+
+//**************************************************************************************************************
+size_t  AsyncHTTPRequest::_writeBody(const uint8_t* data, size_t len)
+{
+  // An event stream is parsed as it goes by and never held, however long it runs
+  if (_streaming && _sse)
+  {
+    _sse->parse(data, len);
+    _contentRead += len;
+
+    return len;
+  }
+
+  // Every decoded body byte passes through here on its way into _response; of a stream, only what is still unread
+  if (_tooLarge((_streaming ? 0 : _contentRead) + _response->available() + len))
+    return 0;
+
+  // Length of a close-delimited body is only known as it arrives
+  if (_closeDelimited && ! _streaming)
+    _contentLength += len;
+
+  // Past what the cache could ever hold, stop copying
+  if (_cacheBody && _cacheBody->available() + len > _cache->budget())
+  {
+    delete _cacheBody;
+    _cacheBody = nullptr;
+  }
+
+  if (_cacheBody)
+    _cacheBody->write(data, len);
+
+  _digest.update(data, len);
+
+  if (_json && _streaming)
+  {
+    // One document after another, each ending with its line (NDJSON); a bad one is given up at its line end
+    for (size_t used = 0; used < len; )
+    {
+      const uint8_t* eol = (const uint8_t*) memchr(data + used, '\n', len - used);
+      size_t line = eol ? (eol - data) + 1 - used : len - used;
+
+      _json->parse(data + used, line);
+      used += line;
+
+      if (eol && (_json->complete() || _json->error()))
+        _json->reset();
+    }
+  }
+  else if (_json)
+  {
+    _json->parse(data, len);
+  }
+
+  if (_json)
+  {
+    // Parsed and not kept: count it as read so completion works without buffering
+    if ( ! _jsonKeepBody)
+    {
+      _contentRead += len;
+      return len;
+    }
+  }
+
+  return _response->write(data, len);
+}
+
+//**************************************************************************************************************
+size_t  AsyncHTTPRequest::_writeBody(xbuf* src, size_t len)
+{
+  uint8_t temp[64];
+  size_t  written = 0;
+
+  while (written < len && src->available())
+  {
+    size_t chunk = (len - written) < sizeof(temp) ? (len - written) : sizeof(temp);
+    chunk = src->read(temp, chunk);
+    written += _writeBody(temp, chunk);
+  }
+
+  return written;
+}
+
+//**************************************************************************************************************
+bool  AsyncHTTPRequest::_tooLarge(size_t length)
+{
+  if (_HTTPcode == HttpCode::RESPONSE_TOO_LARGE)
+    return true;
+
+  // A stream is only ever as large as what is waiting to be read, and that is bounded even without a limit set
+  size_t limit = _streaming && ! _maxResponseLength ? STREAM_MAX_BUFFERED : _maxResponseLength;
+
+  if ( ! limit || length <= limit)
+    return false;
+
+  AHTTP_LOGDEBUG3("*response too large:", length, "> max", limit);
+
+  // Drop what is buffered and the connection; _onDisconnect() completes the request with this code
+  _HTTPcode = HttpCode::RESPONSE_TOO_LARGE;
+  _response->flush();
+
+  if (_chunks)
+    _chunks->flush();
+
+  if (_h2)
+  {
+    _session->_remove(this);
+    _onDisconnect(nullptr);
+  }
+  else if (_client)
+  {
+    _client->close(true);
+  }
+
+  return true;
+}
+
+//**************************************************************************************************************
+uint32_t  AsyncHTTPRequest::_deadlineIn(uint32_t now) const
+{
+  // Milliseconds until the nearest deadline that applies now, 0 if one has passed, UINT32_MAX if none
+  if (_readyState == ReadyState::Idle || _readyState == ReadyState::Done)
+    return UINT32_MAX;
+
+  uint32_t left = UINT32_MAX;
+
+  auto limit = [&left, now](uint32_t start, uint32_t timeout)
+  {
+    uint32_t spent = now - start;
+    uint32_t remain = spent >= timeout ? 0 : timeout - spent;
+
+    if (remain < left)
+      left = remain;
+  };
+
+  if (_totalTimeout)
+    limit(_requestStartTime, _totalTimeout);
+
+  // Waiting to retry, nothing is in progress
+  if (_retryPending)
+    return left;
+
+  // Queued behind other pipelined requests, nothing is on the wire for this one yet
+  if (_piped && ! (_pipeline->_queue && _pipeline->_queue->request == this))
+    return left;
+
+  // Waiting for a stream of its own on the session
+  if (_h2 && _session->_queued(this))
+    return left;
+
+  // Measured round trip times, where there are any, take over from the fixed timeouts
+  uint32_t connectTimeout   = _rttConnect ? _rttConnect : _connectTimeout;
+  uint32_t firstByteTimeout = _rttFirstByte ? _rttFirstByte : _firstByteTimeout;
+  uint32_t idleTimeout      = _rttFirstByte && _readyState > ReadyState::Opened ? _rttFirstByte : _timeout;
+
+  if (connectTimeout && _readyState == ReadyState::Unsent && ! _piped)
+    limit(_connectStartTime, connectTimeout);
+
+  if (firstByteTimeout && _awaitingResponse)
+    limit(_sentTime, firstByteTimeout);
+
+  // An open stream may be quiet for any length of time, only its heartbeat tells it is still there
+  if (_streaming)
+  {
+    if (_heartbeat)
+      limit(_lastActivity, _heartbeat);
+  }
+  else if (idleTimeout && ! (_sendPaused && _request))
+  {
+    limit(_lastActivity, idleTimeout);
+  }
+
+  return left;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_armDeadline()
+{
+  // Only when a deadline may have come closer; one that moved away just fires early and rearms
+  uint32_t left = _deadlineIn(millis());
+
+  if (left == UINT32_MAX)
+  {
+    AsyncHTTPTimerWheel::instance().cancel(_deadline);
+
+    return;
+  }
+
+  AsyncHTTPTimerWheel::instance().arm(_deadline, left, [](void* obj)
+  {
+    ((AsyncHTTPRequest*)(obj))->_onDeadline();
+  }, this);
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_expire()
+{
+  AHTTP_LOGDEBUG1("*deadline passed, readyState =", int(_readyState));
+
+  // Set first, _onDisconnect() completes the request with it
+  _HTTPcode = HttpCode::TIMEOUT;
+
+  // A derived deadline was too tight for the link as it is now; the total is the application's own budget
+  if (_rtt && (_rttConnect || _rttFirstByte) && ! (_totalTimeout && (millis() - _requestStartTime) >= _totalTimeout))
+    _rtt->timedOut(_URL.host, _URL.port);
+
+  if (_piped)
+  {
+    // Leave the pipeline, it only closes its connection if this request was written
+    _pipeline->_remove(this);
+    _onDisconnect(nullptr);
+  }
+  else if (_h2)
+  {
+    // Reset the stream, the others on the connection aren't held up
+    _session->_remove(this);
+    _onDisconnect(nullptr);
+  }
+  else if (_client)
+  {
+    _client->close();
+  }
+  else
+  {
+    _onDisconnect(nullptr);
+  }
+}
+
+//**************************************************************************************************************
+bool  AsyncHTTPRequest::_scheduleRetry()
+{
+  // Not once the application has been handed part of the response
+  if ( ! _retry || ! _sent || _leader || _aborted || _contentRead || _attempt + 1 >= _retry->maxAttempts() ||
+       ! _retry->retryable(_HTTPmethod, _HTTPcode))
+  {
+    return false;
+  }
+
+  uint32_t delay = _retry->backoff(_attempt + 1);
+
+  // The server says when to come back, if that isn't further off than the policy would ever wait
+  header* hdr = _readyState >= ReadyState::HdrsRecvd ? _getHeader("Retry-After") : nullptr;
+
+  if (hdr)
+  {
+    uint32_t after = hdr->value.toInt() * 1000;
+
+    if (after > _retry->maxBackoff())
+      return false;
+
+    if (after > delay)
+      delay = after;
+  }
+
+  if (_totalTimeout && (millis() - _requestStartTime) + delay >= _totalTimeout)
+    return false;
+
+  if ( ! _retry->withdraw(_URL.host))
+    return false;
+
+  AHTTP_LOGDEBUG3("*retrying after", HttpCode::toString(_HTTPcode), ", delay =", delay);
+
+  _retryPending = true;
+  _readyState   = ReadyState::Unsent;
+
+  // What the failed attempt received is of no use to anyone
+  if (_response)
+    _response->flush();
+
+  // Those sharing the response parse the retried one from its status line. One that has already handed part of
+  // the failed attempt to its application can't start over, it ends the way this attempt did.
+  for (AsyncHTTPRequest* follower = _followers, *next; follower; follower = next)
+  {
+    next = follower->_nextFollower;
+
+    if ( ! follower->_contentRead)
+    {
+      follower->_resetResponse();
+      follower->_beginResponse();
+
+      continue;
+    }
+
+    if (_HTTPcode < 0)
+      follower->_HTTPcode = _HTTPcode;
+
+    follower->_onDisconnect(nullptr);
+
+    if (follower->_leader)
+      follower->_leave();
+  }
+
+  AsyncHTTPTimerWheel::instance().cancel(_deadline);
+  AsyncHTTPTimerWheel::instance().arm(_retryTimer, delay, [](void* obj)
+  {
+    ((AsyncHTTPRequest*)(obj))->_onRetry();
+  }, this);
+
+  return true;
+}
+
+//**************************************************************************************************************
+bool  AsyncHTTPRequest::_scheduleReconnect()
+{
+  // A stream that ended, or a connection that never got as far as an answer; not one the server turned down
+  if ( ! _sse || _aborted || _HTTPmethod != HTTPmethod::GET ||
+       ! (_streaming || (_HTTPcode < 0 && _readyState < ReadyState::HdrsRecvd)))
+  {
+    return false;
+  }
+
+  uint32_t delay = _sse->retry() ? _sse->retry() : EVENT_STREAM_RETRY;
+
+  if (_totalTimeout && (millis() - _requestStartTime) + delay >= _totalTimeout)
+    return false;
+
+  AHTTP_LOGDEBUG3("*event stream ended,", HttpCode::toString(_HTTPcode), ", reconnecting in", delay);
+
+  _retryPending = true;
+  _streaming    = false;
+  _readyState   = ReadyState::Unsent;
+
+  if (_response)
+    _response->flush();
+
+  AsyncHTTPTimerWheel::instance().cancel(_deadline);
+  AsyncHTTPTimerWheel::instance().arm(_retryTimer, delay, [](void* obj)
+  {
+    ((AsyncHTTPRequest*)(obj))->_onReconnect();
+  }, this);
+
+  return true;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_armHedge()
+{
+  // Only safe to send twice, and a pipelined request has no connection of its own to race
+  if ( ! _hedgeDelay || _hedgeOf || _piped || _h2 || _HTTPmethod != HTTPmethod::GET)
+    return;
+
+  uint32_t delay = _hedgeDelay;
+
+  // Once the origin is known, hedge only what is slower than nearly all of its answers
+  if (_hedgeRTT)
+  {
+    uint32_t p95 = _hedgeRTT->percentile95(_URL.host, _URL.port);
+
+    if (p95)
+      delay = p95;
+  }
+
+  uint32_t elapsed = millis() - _requestStartTime;
+
+  AsyncHTTPTimerWheel::instance().arm(_hedgeTimer, delay > elapsed ? delay - elapsed : 0, [](void* obj)
+  {
+    ((AsyncHTTPRequest*)(obj))->_onHedge();
+  }, this);
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_stopHedge()
+{
+  AsyncHTTPTimerWheel::instance().cancel(_hedgeTimer);
+
+  if ( ! _hedge)
+    return;
+
+  // Kept for the next hedge, only its connection goes
+  AsyncHTTPTimerWheel::instance().cancel(_hedge->_deadline);
+
+  if (_hedge->_client)
+    _hedge->_dropClient();
+
+  _hedge->_readyState = ReadyState::Idle;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_adoptHedge(void* data, size_t len)
+{
+  _lock;
+
+  AHTTP_LOGDEBUG("*hedge answered first");
+
+  AsyncClient* client = _hedge->_client;
+
+  _hedge->_client = nullptr;
+  _stopHedge();
+
+  // Our own connection is too slow to bother with
+  if (_client)
+    _dropClient();
+
+  _client        = client;
+  _connectedHost = _URL.host;
+  _connectedPort = _URL.port;
+
+  _bindClient();
+
+  // Already sent on the hedge's connection
+  delete _request;
+  delete _replay;
+
+  _request       = nullptr;
+  _replay        = nullptr;
+  _timingConnect = false;
+
+  _onConnect(_client);
+
+  _sentTime         = _hedge->_sentTime;
+  _awaitingResponse = true;
+  _hedged           = true;
+  _hedgesWon++;
+
+  _onData(data, len);
+  _unlock;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_beginResponse()
+{
+  _setReadyState(ReadyState::Opened);
+  delete _response;
+  _response = new xbuf;
+  _contentLength = 0;
+  _contentRead = 0;
+  _chunked = false;
+  _closeDelimited = false;
+  _keepAlive = true;
+  _keepAliveTimeout = 0;
+  _httpMinor = 1;
+  _trailers = false;
+}
+
+//**************************************************************************************************************
+bool  AsyncHTTPRequest::_unanswered() const
+{
+  // Either still connecting, or sending or sent and waiting
+  return (_readyState == ReadyState::Unsent && ! _retryPending) ||
+         (_readyState == ReadyState::Opened && (_awaitingResponse || _request));
+}
+
+//**************************************************************************************************************
+String  AsyncHTTPRequest::_coalesceKey(bool urlOnly)
+{
+  String key = _URL.host + ':' + _URL.port + _URL.path + _URL.query;
+
+  if (urlOnly)
+    return key;
+
+  const String &names = _coalescer->keyHeaders();
+  int beg = 0;
+
+  while (beg < (int) names.length())
+  {
+    int end = names.indexOf(',', beg);
+
+    if (end < 0)
+      end = names.length();
+
+    String name = names.substring(beg, end);
+    name.trim();
+
+    header* hdr = _getHeader(name);
+
+    key += '\n';
+
+    if (hdr)
+      key += hdr->value;
+
+    beg = end + 1;
+  }
+
+  return key;
+}
+
+//**************************************************************************************************************
+bool  AsyncHTTPRequest::_coalesce()
+{
+  if ( ! _coalescer || _piped)
+    return false;
+
+  AsyncHTTPRequest* leader = _coalescer->_find(_coalesceKey());
+
+  if ( ! leader || ! leader->_unanswered())
+    return false;
+
+  _join(leader);
+
+  return true;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_join(AsyncHTTPRequest* leader)
+{
+  AHTTP_LOGDEBUG1("*coalescing with request in flight", _URL.path);
+
+  _leader = leader;
+  _nextFollower = leader->_followers;
+  leader->_followers = this;
+
+  // A 304 coming back is completed from the cache here too
+  _revalidating = leader->_revalidating;
+
+  _coalescer->_coalesced++;
+
+  delete _headers;
+  _headers = nullptr;
+
+  delete _sent;
+  _sent = nullptr;
+
+  _beginResponse();
+
+  _lastActivity = millis();
+  _armDeadline();
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_leave()
+{
+  if ( ! _leader)
+    return;
+
+  AsyncHTTPRequest** pf = &_leader->_followers;
+
+  while (*pf && *pf != this)
+    pf = &(*pf)->_nextFollower;
+
+  if (*pf)
+    *pf = _nextFollower;
+
+  _leader = nullptr;
+  _nextFollower = nullptr;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_releaseFollowers()
+{
+  // Whatever they haven't completed from the shared bytes ends the way this one did
+  while (_followers)
+  {
+    AsyncHTTPRequest* follower = _followers;
+
+    if (_HTTPcode < 0)
+      follower->_HTTPcode = _HTTPcode;
+
+    follower->_onDisconnect(nullptr);
+
+    if (_followers == follower)
+      follower->_leave();
+  }
+}
+
+//**************************************************************************************************************
+String  AsyncHTTPRequest::_cacheKey(HTTPmethod method)
+{
+  return toString<String>(method) + ' ' + _URL.host + ':' + _URL.port + _URL.path + _URL.query;
+}
+
+//**************************************************************************************************************
+bool  AsyncHTTPRequest::_serveCached()
+{
+  if ( ! _cache)
+    return false;
+
+  // A part of it, or explicitly not from a cache
+  header* hdr = _getHeader("Cache-Control");
+
+  if (_getHeader("Range") || _headerHasToken(hdr, "no-cache") || _headerHasToken(hdr, "no-store") ||
+      _headerHasToken(_getHeader("Pragma"), "no-cache"))
+  {
+    return false;
+  }
+
+  AsyncHTTPResponseCache::entry* e = _cache->_find(_cacheKey(_HTTPmethod));
+
+  // Could have gone stale between open() and send()
+  if ( ! _cache->_fresh(e))
+    return false;
+
+  AHTTP_LOGDEBUG1("*answered from cache", e->key);
+
+  _cache->_hits++;
+  _fromCache = true;
+  _piped     = false;
+  _h2        = false;
+
+  delete _headers;
+  _headers = nullptr;
+
+  _beginResponse();
+  _HTTPcode = 200;
+
+  _addHeaders(e->headers);
+
+  _addHeader("Content-Length", String(e->length));
+  _contentLength = e->length;
+  _requestEndTime = millis();
+
+  // As if it had just arrived, so every callback and body hook sees it the same way
+  _inData = true;
+  _setReadyState(ReadyState::HdrsRecvd);
+  _writeBody(e->body, e->length);
+
+  if (_response->available())
+    _setReadyState(ReadyState::Loading);
+
+  _finishResponse();
+
+  if (_onDataCB && available())
+  {
+    _onDataCB(_onDataCBarg, this, available());
+  }
+
+  _inData = false;
+
+  if (_doneDeferred)
+  {
+    _doneDeferred = false;
+
+    if (_readyStateChangeCB)
+      _readyStateChangeCB(_readyStateChangeCBarg, this, ReadyState::Done);
+  }
+
+  return true;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_cacheBegin()
+{
+  delete _cacheBody;
+  _cacheBody = nullptr;
+
+  if ( ! _cache || _fromCache || _streaming || _HTTPmethod != HTTPmethod::GET)
+    return;
+
+  if (_HTTPcode == 304 && _revalidating)
+  {
+    _serveRevalidated();
+
+    return;
+  }
+
+  if (_leader)
+    return;
+
+  // Asked conditionally, but it changed
+  if (_revalidating)
+    _cache->_misses++;
+
+  if (_HTTPcode != 200)
+    return;
+
+  // Whatever was stored is superseded, kept or not
+  _cache->_remove(_cacheKey(_HTTPmethod));
+
+  // A response that varies with request headers can't be told apart by URL alone
+  if (_getHeader("Vary"))
+    return;
+
+  header* control = _getHeader("Cache-Control");
+
+  if (_headerHasToken(control, "no-store"))
+    return;
+
+  header* expires = _getHeader("Expires");
+  header* date    = _getHeader("Date");
+  header* age     = _getHeader("Age");
+
+  _cacheLifetime = AsyncHTTPResponseCache::lifetime(control ? control->value : String(), expires ? expires->value : String(),
+                                                    date ? date->value : String(), age ? age->value : String());
+
+  // Without a lifetime it is still worth keeping if it can be revalidated
+  if ( ! _cacheLifetime && ! _getHeader("ETag") && ! _getHeader("Last-Modified"))
+    return;
+
+  if (_getHeader("Content-Length") && _contentLength > _cache->budget())
+    return;
+
+  _cacheBody = new xbuf;
+}
+
+//**************************************************************************************************************
+bool  AsyncHTTPRequest::_cacheValidate()
+{
+  // A part of it, or the application's own condition
+  if (_getHeader("Range") || _getHeader("If-None-Match") || _getHeader("If-Modified-Since"))
+    return false;
+
+  AsyncHTTPResponseCache::entry* e = _cache->_find(_cacheKey(_HTTPmethod));
+
+  if ( ! e)
+    return false;
+
+  String etag = AsyncHTTPResponseCache::_header(e, "ETag");
+  String modified = AsyncHTTPResponseCache::_header(e, "Last-Modified");
+
+  if (etag.length())
+    _addHeader("If-None-Match", etag);
+
+  if (modified.length())
+    _addHeader("If-Modified-Since", modified);
+
+  _revalidating = etag.length() || modified.length();
+
+  return _revalidating;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_serveRevalidated()
+{
+  AsyncHTTPResponseCache::entry* e = _cache->_find(_cacheKey(_HTTPmethod));
+
+  // Evicted while the question was out, all there is to give is the 304
+  if ( ! e)
+    return;
+
+  AHTTP_LOGDEBUG1("*not modified, answered from cache", e->key);
+
+  // Fresh again, for as long as the new answer says, or the stored one said
+  header* control = _getHeader("Cache-Control");
+  header* expires = _getHeader("Expires");
+  header* date    = _getHeader("Date");
+  header* age     = _getHeader("Age");
+
+  e->stored   = millis();
+  e->lifetime = AsyncHTTPResponseCache::lifetime(control ? control->value : AsyncHTTPResponseCache::_header(e, "Cache-Control"),
+                                                 expires ? expires->value : AsyncHTTPResponseCache::_header(e, "Expires"),
+                                                 date    ? date->value    : AsyncHTTPResponseCache::_header(e, "Date"),
+                                                 age     ? age->value     : String());
+
+  _cache->_hits++;
+  _cache->_revalidations++;
+  _fromCache = true;
+  _HTTPcode  = 200;
+
+  // The stored headers stand in for the 304's, how the connection goes on was already taken from those
+  delete _headers;
+  _headers = nullptr;
+
+  _addHeaders(e->headers);
+
+  _addHeader("Content-Length", String(e->length));
+  _contentLength = e->length;
+
+  // The stored body goes in as if it had followed the headers, ahead of anything received after the 304
+  xbuf* received = _response;
+
+  _response = new xbuf;
+  _response->write(e->body, e->length);
+  _response->write(received, received->available());
+
+  delete received;
+}
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_cacheStore()
+{
+  // Only a whole response: a chunked one is only complete once its last chunk was seen
+  if (_HTTPcode == 200 && ( ! _chunked || _trailers))
+  {
+    String stored;
+
+    for (header* hdr = _headers; hdr; hdr = hdr->next)
+    {
+      // How it was framed on the wire doesn't apply to the stored copy
+      if (hdr->name.equalsIgnoreCase("Connection") || hdr->name.equalsIgnoreCase("Keep-Alive") ||
+          hdr->name.equalsIgnoreCase("Transfer-Encoding") || hdr->name.equalsIgnoreCase("Content-Length"))
+      {
+        continue;
+      }
+
+      stored += hdr->name + ": " + hdr->value + "\r\n";
+    }
+
+    _cache->_store(_cacheKey(_HTTPmethod), stored, _cacheBody, _cacheLifetime);
+  }
+
+  delete _cacheBody;
+  _cacheBody = nullptr;
+}
+
+/*______________________________________________________________________________________________________________
+
+  EEEEE   V   V   EEEEE   N   N   TTTTT         H   H    AAA    N   N   DDDD    L       EEEEE   RRRR     SSS
+  E       V   V   E       NN  N     T           H   H   A   A   NN  N   D   D   L       E       R   R   S
+  EEE     V   V   EEE     N N N     T           HHHHH   AAAAA   N N N   D   D   L       EEE     RRRR     SSS
+  E        V V    E       N  NN     T           H   H   A   A   N  NN   D   D   L       E       R  R        S
+  EEEEE     V     EEEEE   N   N     T           H   H   A   A   N   N   DDDD    LLLLL   EEEEE   R   R    SSS
+  _______________________________________________________________________________________________________________*/
+
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_onConnect(AsyncClient* client)
+{
+  AHTTP_LOGDEBUG("_onConnect handler");
+
+  _lock;
+  _client = client;
+
+  // Remember where the name led, the next connection to this host can skip the lookup
+  if (_connectByName && client)
+  {
+    _dns->store(_URL.host, client->remoteIP());
+    _connectByName = false;
+  }
+
+  if (_timingConnect && _rtt)
+    _rtt->sampleConnect(_URL.host, _URL.port, millis() - _connectStartTime);
+
+  _timingConnect = false;
+
+  _connectByCache = false;
+  _beginResponse();
+
+  if (_piped || _h2)
+  {
+    // Pipeline or session dispatches acks and data, keep what is sent in case the server drops the connection
+    delete _replay;
+    _replay = new xbuf;
+  }
+  else
+  {
+    _client->onAck([](void* obj, AsyncClient * client, size_t len, uint32_t time) 
+    {
+      ((AsyncHTTPRequest*)(obj))->_send();
+    }, this);
+
+    _client->onData([](void* obj, AsyncClient * client, void* data, size_t len) 
+    {
+      ((AsyncHTTPRequest*)(obj))->_onData(data, len);
+    }, this);
+  }
+
+  if (_h2 || _client->canSend())
+  {
+    _send();
+  }
+
+  _lastActivity = millis();
+  _unlock;
+}
 
-  if (_request->available() == 0)
-  {
-    delete _request;
-    _request = nullptr;
-  }
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_onPoll(AsyncClient* client)
+{
+  _lock;
 
-  _client->send();
+  // Holding the upload back on purpose isn't inactivity
+  if (_sendPaused && _request)
+    _lastActivity = millis();
 
-  AHTTP_LOGDEBUG1("*send", sent);
+#if !(ESP32 || ESP8266)
+  // No ticker drives the wheel here unless loop() runs it, keep deadlines going at poll rate meanwhile
+  AsyncHTTPTimerWheel::instance().run();
+#endif
 
-  _lastActivity = millis();
+  if (_onDataCB && available())
+  {
+    _onDataCB(_onDataCBarg, this, available());
+  }
 
-  return sent;
+  _unlock;
 }
 
 //**************************************************************************************************************
-void  AsyncHTTPRequest::_setReadyState(ReadyState readyState)
+void  AsyncHTTPRequest::_onDeadline()
 {
-  if (_readyState != readyState)
-  {
-    _readyState = readyState;
+  _lock;
 
-    AHTTP_LOGDEBUG1("_setReadyState :", int(_readyState));
+  uint32_t left = _deadlineIn(millis());
 
-    if (_readyStateChangeCB)
-    {
-      _readyStateChangeCB(_readyStateChangeCBarg, this, _readyState);
-    }
-  }
+  if (left == 0)
+    _expire();
+  else if (left != UINT32_MAX)
+    _armDeadline();
+
+  _unlock;
 }
 
 //**************************************************************************************************************
-void  AsyncHTTPRequest::_processChunks()
+void  AsyncHTTPRequest::_onRetry()
 {
-  while (_chunks->available())
-  {
-    AHTTP_LOGDEBUG3("_processChunks()", _chunks->peekString(16).c_str(), ", chunks available =", _chunks->available());
+  _lock;
 
-    size_t _chunkRemaining = _contentLength - _contentRead - _response->available();
-    _chunkRemaining -= _response->write(_chunks, _chunkRemaining);
+  if ( ! _retryPending)
+    return;
 
-    if (_chunks->indexOf("\r\n") == -1)
-    {
-      return;
-    }
+  _retryPending = false;
+  _attempt++;
 
-    String chunkHeader = _chunks->readStringUntil("\r\n");
+  AHTTP_LOGDEBUG1("_onRetry, attempt", _attempt + 1);
 
-    AHTTP_LOGDEBUG3("*getChunkHeader", chunkHeader.c_str(), ", chunkHeader length =", chunkHeader.length());
+  // The same bytes go out again, ahead of anything that hadn't been sent yet
+  if (_request)
+    _sent->write(_request, _request->available());
 
-    size_t chunkLength = strtol(chunkHeader.c_str(), nullptr, 16);
-    _contentLength += chunkLength;
+  delete _request;
+  _request = _sent;
+  _sent = new xbuf;
 
-    if (chunkLength == 0)
-    {
-      const auto connectionHdr = respHeaderValue("connection");
+  delete _replay;
 
-      if (connectionHdr && connectionHdr == "disconnect")
-      {
-        AHTTP_LOGDEBUG("*all chunks received - closing TCP");
+  _replay       = nullptr;
+  _awaitingResponse = false;
+  _lastActivity = millis();
+  _resetResponse();
 
-        _client->close();
-      }
-      else
-      {
-        AHTTP_LOGDEBUG("*all chunks received - no disconnect");
-      }
+  if (_sse)
+    _sse->resume();
 
-      _requestEndTime = millis();
-      _lastActivity = 0;
-      _timeout = 0;
-      _setReadyState(ReadyState::Done);
+  if (_piped)
+  {
+    _client = nullptr;
+    _pipeline->_enqueue(this);
+    _armDeadline();
+  }
+  else if (_h2)
+  {
+    _session->_enqueue(this);
+    _armDeadline();
+  }
+  else
+  {
+    if (_client && ! _client->connected() && ! _client->connecting())
+      _dropClient();
 
-      return;
-    }
+    _connect();
   }
+
+  _unlock;
 }
 
-/*______________________________________________________________________________________________________________
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_resetResponse()
+{
+  // Nothing parsed yet, the next response starts from its status line
+  delete _headers;
+  delete _chunks;
+  delete _surplus;
 
-  EEEEE   V   V   EEEEE   N   N   TTTTT         H   H    AAA    N   N   DDDD    L       EEEEE   RRRR     SSS
-  E       V   V   E       NN  N     T           H   H   A   A   NN  N   D   D   L       E       R   R   S
-  EEE     V   V   EEE     N N N     T           HHHHH   AAAAA   N N N   D   D   L       EEE     RRRR     SSS
-  E        V V    E       N  NN     T           H   H   A   A   N  NN   D   D   L       E       R  R        S
-  EEEEE     V     EEEEE   N   N     T           H   H   A   A   N   N   DDDD    LLLLL   EEEEE   R   R    SSS
-  _______________________________________________________________________________________________________________*/
+  _headers      = nullptr;
+  _chunks       = nullptr;
+  _surplus      = nullptr;
+  _HTTPcode     = 0;
+  _chunked      = false;
+  _closeDelimited = false;
+  _contentRead  = 0;
+  _rangeStart   = 0;
+  _rangeTotal   = 0;
+  _streaming    = false;
+  _digest.begin(_digest.type());
+
+  if (_json)
+    _json->reset();
+}
 
 //**************************************************************************************************************
-void  AsyncHTTPRequest::_onConnect(AsyncClient* client)
+void  AsyncHTTPRequest::_onReconnect()
 {
-  AHTTP_LOGDEBUG("_onConnect handler");
-
   _lock;
-  _client = client;
-  _setReadyState(ReadyState::Opened);
-  _response = new xbuf;
-  _contentLength = 0;
-  _contentRead = 0;
-  _chunked = false;
-  
-  _client->onAck([](void* obj, AsyncClient * client, size_t len, uint32_t time) 
-  {
-    ((AsyncHTTPRequest*)(obj))->_send();
-  }, this);
-  
-  _client->onData([](void* obj, AsyncClient * client, void* data, size_t len) 
-  {
-    ((AsyncHTTPRequest*)(obj))->_onData(data, len);
-  }, this);
 
-  if (_client->canSend())
+  if ( ! _retryPending)
+    return;
+
+  AHTTP_LOGDEBUG1("_onReconnect, Last-Event-ID", _sse->lastEventId());
+
+  // open() asks for the stream from the last event on, the application's own headers go with it again
+  String headers = _streamHeaders;
+
+  if (open(_URL, HTTPmethod::GET))
   {
-    _send();
+    _addHeaders(headers);
+    send();
   }
 
-  _lastActivity = millis();
   _unlock;
 }
 
 //**************************************************************************************************************
-void  AsyncHTTPRequest::_onPoll(AsyncClient* client)
+void  AsyncHTTPRequest::_onHedge()
 {
   _lock;
 
-  if (_timeout && (millis() - _lastActivity) > (_timeout * 1000))
-  {
-    _client->close();
-    _HTTPcode = HttpCode::TIMEOUT;
+  size_t length = (_sent ? _sent->available() : 0) + (_request ? _request->available() : 0);
 
-    AHTTP_LOGDEBUG("_onPoll timeout");
-  }
+  // Without a copy of what already went out, there is nothing to send again
+  if ( ! _unanswered() || ! length || ( ! _sent && _readyState != ReadyState::Unsent))
+    return;
 
-  if (_onDataCB && available())
+  if ( ! _hedge)
   {
-    _onDataCB(_onDataCBarg, this, available());
+    _hedge = new AsyncHTTPRequest;
+    _hedge->_hedgeOf = this;
   }
 
+  AHTTP_LOGDEBUG1("*hedging after", millis() - _requestStartTime);
+
+  // The same bytes again, on a connection of its own
+  uint8_t* temp = new uint8_t[length];
+  size_t   sent = _sent ? _sent->peek(temp, length) : 0;
+
+  if (_request)
+    _request->peek(temp + sent, length - sent);
+
+  delete _hedge->_request;
+  _hedge->_request = new xbuf;
+  _hedge->_request->write(temp, length);
+
+  delete[] temp;
+
+  _hedge->_URL        = _URL;
+  _hedge->_HTTPmethod = _HTTPmethod;
+  _hedge->_pool       = _pool;
+  _hedge->_dns        = _dns;
+  _hedge->_debug      = _debug;
+  _hedge->_timeout    = _timeout;
+  _hedge->_HTTPcode   = 0;
+  _hedge->_readyState = ReadyState::Unsent;
+  _hedge->_requestStartTime = millis();
+
+  _hedgesFired++;
+
+  _hedge->_connect();
   _unlock;
 }
 
@@ -721,7 +2425,15 @@ void  AsyncHTTPRequest::_onError(AsyncClient* client, int8_t error)
 {
   AHTTP_LOGDEBUG1("_onError handler error =", error);
 
-  _HTTPcode = error;
+  if (_connectByName && error == ASYNC_TCP_DNS_FAILED)
+    _dns->storeFailure(_URL.host);
+  else if (_connectByCache)
+    _dns->flush(_URL.host);
+
+  // AsyncTCP passes lwIP's err_t, whose -1..-16 overlap HttpCode (ERR_RST would read as CIRCUIT_OPEN, ERR_ABRT as
+  // RESPONSE_TOO_LARGE): reported as where the connection failed. A code the request already settled on stands.
+  if (_HTTPcode >= 0)
+    _HTTPcode = _readyState >= ReadyState::Opened ? HttpCode::CONNECTION_LOST : HttpCode::NOT_CONNECTED;
 }
 
 //**************************************************************************************************************
@@ -730,14 +2442,65 @@ void  AsyncHTTPRequest::_onDisconnect(AsyncClient* client)
   AHTTP_LOGDEBUG("\n_onDisconnect handler");
 
   _lock;
-  
+
+  // Idle keep-alive connection closed by the server after the request completed
+  if (_readyState == ReadyState::Done)
+  {
+    delete _client;
+    _client = nullptr;
+
+    _connectedHost = String{};
+    _connectedPort = -1;
+    _unlock;
+
+    return;
+  }
+
+  // Connection kept from before, closed by the server while open() held back using it
+  if (_connectPending)
+  {
+    delete _client;
+    _client = nullptr;
+
+    _connectedHost = String{};
+    _connectedPort = -1;
+    _unlock;
+
+    return;
+  }
+
+  // Reused connection died before any response arrived: the server closed it while idle, send again once
+  if (_replay && ! _piped && ! _h2 && _readyState == ReadyState::Opened && ! _response->available() &&
+      _HTTPcode != HttpCode::TIMEOUT)
+  {
+    AHTTP_LOGDEBUG("*reused connection was dead, replaying request");
+
+    _rewind();
+
+    delete _client;
+    _client = nullptr;
+
+    if (_connect())
+    {
+      _unlock;
+      return;
+    }
+  }
+
   if (_readyState < ReadyState::Opened)
   {
-    _HTTPcode = HttpCode::NOT_CONNECTED;
+    // The cached address may be stale, look the name up again next time
+    if (_connectByCache)
+      _dns->flush(_URL.host);
+
+    if (_HTTPcode != HttpCode::TIMEOUT)
+      _HTTPcode = HttpCode::NOT_CONNECTED;
   }
-  else if (_HTTPcode > 0 &&
-           (_readyState < ReadyState::HdrsRecvd || (_contentRead + _response->available()) < _contentLength))
+  else if (_HTTPcode >= 0 &&
+           (_readyState < ReadyState::HdrsRecvd || (_contentRead + _response->available()) < _contentLength ||
+            (_chunked && ! _trailers)))
   {
+    // Cut off part way, a chunked body included: one that ends at a chunk boundary is still missing its last chunk
     _HTTPcode = HttpCode::CONNECTION_LOST;
   }
 
@@ -758,58 +2521,103 @@ void  AsyncHTTPRequest::_onData(void* Vbuf, size_t len)
 {
   AHTTP_LOGDEBUG3("_onData handler", (char*) Vbuf, ", len =", len);
 
+  // A hedge answering first hands its connection over, this object is not touched after that
+  if (_hedgeOf)
+  {
+    _hedgeOf->_adoptHedge(Vbuf, len);
+
+    return;
+  }
+
+  // Those sharing the response parse it as it arrives, before this one can complete and let them go
+  for (AsyncHTTPRequest* follower = _followers, *next; follower; follower = next)
+  {
+    next = follower->_nextFollower;
+    follower->_onData(Vbuf, len);
+  }
+
   _lastActivity = millis();
 
+  if (_awaitingResponse && _rtt)
+    _rtt->sampleFirstByte(_URL.host, _URL.port, millis() - _sentTime);
+
+  // Answered first, the hedge lost
+  if (_readyState == ReadyState::Opened && ! _response->available())
+    _stopHedge();
+
+  _awaitingResponse = false;
+
+  // The connection is alive after all, nothing will need replaying
+  delete _replay;
+  _replay = nullptr;
+
+  if (_readyState == ReadyState::Done)
+  {
+    AHTTP_LOGDEBUG("*data after response complete, ignored");
+
+    return;
+  }
+
+  _inData = true;
+
   // Transfer data to xbuf
   if (_chunks)
   {
     _chunks->write((uint8_t*)Vbuf, len);
     _processChunks();
   }
-  else
+  else if (_readyState == ReadyState::Opened)
   {
     _response->write((uint8_t*)Vbuf, len);
   }
-
-  // if headers not complete, collect them. If still not complete, just return.
-  if (_readyState == ReadyState::Opened)
+  else if (_closeDelimited)
   {
-    if ( ! _collectHeaders()) 
-      return;
+    _writeBody((uint8_t*)Vbuf, len);
   }
-
-  // If there's data in the buffer and not Done, advance readyState to Loading.
-  if (_response->available() && _readyState != ReadyState::Done)
+  else
   {
-    _setReadyState(ReadyState::Loading);
+    // Body ends at Content-Length, anything after it is the next response's
+    size_t remaining = _contentLength - _contentRead - _response->available();
+    size_t body = len < remaining ? len : remaining;
+
+    _writeBody((uint8_t*)Vbuf, body);
+    _keepSurplus((uint8_t*)Vbuf + body, len - body);
   }
 
-  // If not chunked and all data read, close it up.
-  if ( ! _chunked && (_response->available() + _contentRead) >= _contentLength)
+  // if headers not complete, collect them. If still not complete, nothing more to do.
+  if (_readyState != ReadyState::Opened || _collectHeaders())
   {
-    const auto connectionHdr = respHeaderValue("connection");
+    // If there's data in the buffer (or an event stream open) and not Done, advance readyState to Loading.
+    if ((_response->available() || _streaming) && _readyState != ReadyState::Done)
+    {
+      _setReadyState(ReadyState::Loading);
+    }
 
-    if (connectionHdr && connectionHdr == "disconnect")
+    // If not chunked or close-delimited and all data read, close it up.
+    // (Already Done if the connection was dropped while processing, e.g. response too large.)
+    if (_readyState != ReadyState::Done && ! _chunked && ! _closeDelimited &&
+        (_response->available() + _contentRead) >= _contentLength)
     {
-      AHTTP_LOGDEBUG("*all data received - closing TCP");
+      AHTTP_LOGDEBUG("*all data received");
 
-      _client->close();
+      _finishResponse();
     }
-    else
+
+    // If onData callback requested, do so.
+    if (_onDataCB && available())
     {
-      AHTTP_LOGDEBUG("*all data received - no disconnect");
+      _onDataCB(_onDataCBarg, this, available());
     }
-
-    _requestEndTime = millis();
-    _lastActivity = 0;
-    _timeout = 0;
-    _setReadyState(ReadyState::Done);
   }
 
-  // If onData callback requested, do so.
-  if (_onDataCB && available())
+  _inData = false;
+
+  if (_doneDeferred)
   {
-    _onDataCB(_onDataCBarg, this, available());
+    _doneDeferred = false;
+
+    if (_readyStateChangeCB)
+      _readyStateChangeCB(_readyStateChangeCBarg, this, ReadyState::Done);
   }
 
   _unlock;
@@ -832,15 +2640,25 @@ bool  AsyncHTTPRequest::_collectHeaders()
       return false;
     }
 
+    // If empty line after an interim (1xx) response, drop it and wait for the real one.
+    if (headerLine.length() == 2 && _HTTPcode >= 100 && _HTTPcode < 200)
+    {
+      AHTTP_LOGDEBUG1("*skipping interim response", _HTTPcode);
+
+      delete _headers;
+      _headers = nullptr;
+      _HTTPcode = 0;
+    }
     // If empty line, all headers are in, advance readyState.
-    if (headerLine.length() == 2)
+    else if (headerLine.length() == 2)
     {
       _setReadyState(ReadyState::HdrsRecvd);
     }
-    // If line is HTTP header, capture HTTPcode.
+    // If line is HTTP header, capture HTTP minor version and HTTPcode.
     else if (headerLine.substring(0, 7) == "HTTP/1.")
     {
-      _HTTPcode = headerLine.substring(9, headerLine.indexOf(' ', 9)).toInt();
+      _httpMinor = headerLine.charAt(7) == '0' ? 0 : 1;
+      _HTTPcode = headerLine.substring(9, 12).toInt();
     }
     // Ordinary header, add to header list.
     else
@@ -864,12 +2682,73 @@ bool  AsyncHTTPRequest::_collectHeaders()
   if (hdr)
   {
     _contentLength = hdr->value.toInt();
+
+    if (_tooLarge(_contentLength))
+      return false;
+  }
+
+  // If partial content, note where the range sits in the whole resource ("bytes first-last/total")
+  hdr = _HTTPcode == 206 ? _getHeader("Content-Range") : nullptr;
+
+  if (hdr && hdr->value.startsWith("bytes "))
+  {
+    int dash  = hdr->value.indexOf('-');
+    int slash = hdr->value.indexOf('/');
+
+    _rangeStart = hdr->value.substring(6, dash).toInt();
+    _rangeTotal = slash < 0 ? 0 : hdr->value.substring(slash + 1).toInt();
+
+    AHTTP_LOGDEBUG3("*content-range start =", _rangeStart, ", total =", _rangeTotal);
+  }
+
+  // Persistence: HTTP/1.1 keeps the connection unless told to close, HTTP/1.0 only if asked to keep it
+  hdr = _getHeader("Connection");
+
+  if (_httpMinor)
+    _keepAlive = ! _headerHasToken(hdr, "close");
+  else
+    _keepAlive = _headerHasToken(hdr, "keep-alive");
+
+  // Keep-Alive: timeout=5, max=100 - how long the server holds an idle connection, how many more requests it takes
+  hdr = _keepAlive ? _getHeader("Keep-Alive") : nullptr;
+
+  if (hdr)
+  {
+    int param = hdr->value.indexOf("timeout=");
+
+    if (param >= 0)
+      _keepAliveTimeout = hdr->value.substring(param + 8).toInt() * 1000;
+
+    param = hdr->value.indexOf("max=");
+
+    if (param >= 0 && hdr->value.substring(param + 4).toInt() <= 0)
+      _keepAlive = false;
+
+    AHTTP_LOGDEBUG3("*keep-alive", hdr->value, ", keep =", _keepAlive);
+  }
+
+  // Only a stream the server agreed to send is taken as one, anything else is an ordinary response
+  if (_sse)
+  {
+    hdr = _getHeader("Content-Type");
+    _streaming = hdr && _HTTPcode == 200 && _headerHasToken(hdr, "text/event-stream");
+  }
+  else
+  {
+    _streaming = _streamMode && _HTTPcode == 200;
   }
 
+  // The heartbeat takes over from the idle timeout, and is likely the closer of the two
+  if (_streaming)
+    _armDeadline();
+
+  // Before any of the body goes by
+  _cacheBegin();
+
   // If chunked specified, try to set _contentLength to size of first chunk
   hdr = _getHeader("Transfer-Encoding");
 
-  if (hdr && hdr->value == "chunked")
+  if (hdr && hdr->value.equalsIgnoreCase("chunked"))
   {
     AHTTP_LOGDEBUG("*transfer-encoding: chunked");
 
@@ -879,6 +2758,43 @@ bool  AsyncHTTPRequest::_collectHeaders()
     _chunks->write(_response, _response->available());
     _processChunks();
   }
+  else
+  {
+    // Neither length nor chunks: unless the status has no body, the body runs until the server closes
+    _closeDelimited = ! _getHeader("Content-Length") && _HTTPcode != 204 && _HTTPcode != 304;
+
+    if (_closeDelimited)
+    {
+      AHTTP_LOGDEBUG("*close-delimited body");
+
+      _keepAlive = false;
+    }
+  }
+
+  if ( ! _chunked && _response->available())
+  {
+    // Body that arrived along with the headers still has to pass through the body stage
+    xbuf* body = _response;
+    _response = new xbuf;
+
+    if (_closeDelimited)
+    {
+      _writeBody(body, body->available());
+    }
+    else
+    {
+      _writeBody(body, _contentLength);
+
+      while (body->available())
+      {
+        uint8_t temp[64];
+        size_t  count = body->read(temp, sizeof(temp));
+        _keepSurplus(temp, count);
+      }
+    }
+
+    delete body;
+  }
 
   return true;
 }
@@ -911,6 +2827,20 @@ void AsyncHTTPRequest::setReqHeader(const char* name, int32_t value)
   }
 }
 
+//**************************************************************************************************************
+void AsyncHTTPRequest::setRange(size_t first, size_t last)
+{
+  if (_readyState <= ReadyState::Opened && _headers)
+  {
+    String value = String("bytes=") + String(first) + '-';
+
+    if (last != SIZE_MAX)
+      value += String(last);
+
+    _addHeader("Range", value);
+  }
+}
+
 #if (ESP32 || ESP8266)
 
 //**************************************************************************************************************
@@ -1109,6 +3039,22 @@ AsyncHTTPRequest::header*  AsyncHTTPRequest::_addHeader(const String &name, cons
   return hdr->next;
 }
 
+//**************************************************************************************************************
+void  AsyncHTTPRequest::_addHeaders(const String &lines)
+{
+  // Kept as "name: value\r\n" lines
+  int beg = 0;
+
+  while (beg < (int) lines.length())
+  {
+    int colon = lines.indexOf(':', beg);
+    int end   = lines.indexOf("\r\n", beg);
+
+    _addHeader(lines.substring(beg, colon), lines.substring(colon + 2, end));
+    beg = end + 2;
+  }
+}
+
 //**************************************************************************************************************
 AsyncHTTPRequest::header* AsyncHTTPRequest::_getHeader(const String &name)
 {
@@ -1128,6 +3074,19 @@ AsyncHTTPRequest::header* AsyncHTTPRequest::_getHeader(const String &name)
   return hdr;
 }
 
+//**************************************************************************************************************
+bool AsyncHTTPRequest::_headerHasToken(header* hdr, const char* token)
+{
+  if ( ! hdr)
+    return false;
+
+  // Token lists such as "keep-alive, Upgrade" are matched case-insensitively
+  String value = hdr->value;
+  value.toLowerCase();
+
+  return value.indexOf(token) >= 0;
+}
+
 //**************************************************************************************************************
 AsyncHTTPRequest::header* AsyncHTTPRequest::_getHeader(int ndx)
 {
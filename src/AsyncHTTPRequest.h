@@ -61,14 +61,31 @@
   
 #endif
 
+#include "AsyncHTTPTimerWheel.h"
+#include "AsyncHTTPConnectionPool.h"
+#include "AsyncHTTPPipeline.h"
+#include "AsyncHTTP2Session.h"
+#include "AsyncHTTPDNSCache.h"
+#include "AsyncHTTPRetryPolicy.h"
+#include "AsyncHTTPCircuitBreaker.h"
+#include "AsyncHTTPRTTEstimator.h"
+#include "AsyncHTTPCoalescer.h"
+#include "AsyncHTTPResponseCache.h"
+#include "AsyncHTTPFileCache.h"
+
 #include <pgmspace.h>
 #include <utility/xbuf.h>
+#include <utility/xdigest.h>
+#include <utility/xjson.h>
+#include <utility/xsse.h>
 
 #define DEBUG_HTTP(format,...)  if(_debug){\
     DEBUG_IOTA_PORT.printf("Debug(%3ld): ", millis()-_requestStartTime);\
     DEBUG_IOTA_PORT.printf_P(PSTR(format),##__VA_ARGS__);}
 
 #define DEFAULT_RX_TIMEOUT 3                    // Seconds for timeout
+#define EVENT_STREAM_RETRY 3000                 // ms before reconnecting a dropped event stream, or as the stream's retry: says
+#define STREAM_MAX_BUFFERED 4096                // bytes of a stream left unread before it is dropped, unless setMaxResponseLength()
 
 namespace HttpCode
 {
@@ -85,6 +102,10 @@ enum
     ENCODING            = -9,
     STREAM_WRITE        = -10,
     TIMEOUT             = -11,
+    DIGEST_MISMATCH     = -12,
+    RESPONSE_TOO_LARGE  = -13,
+    CIRCUIT_OPEN        = -14,
+    RANGE_MISMATCH      = -15,
 };
 
 inline String toString(int code)
@@ -102,6 +123,10 @@ inline String toString(int code)
     case ENCODING:            return "ENCODING";
     case STREAM_WRITE:        return "STREAM_WRITE";
     case TIMEOUT:             return "TIMEOUT";
+    case DIGEST_MISMATCH:     return "DIGEST_MISMATCH";
+    case RESPONSE_TOO_LARGE:  return "RESPONSE_TOO_LARGE";
+    case CIRCUIT_OPEN:        return "CIRCUIT_OPEN";
+    case RANGE_MISMATCH:      return "RANGE_MISMATCH";
     }
 
     return String{code};
@@ -181,6 +206,9 @@ std::optional<URL> parseURL(const String &url);
 
 class AsyncHTTPRequest
 {
+    friend class AsyncHTTPPipeline;
+    friend class AsyncHTTP2Session;
+
     using callback_arg_t = void*;
 
     struct header
@@ -212,9 +240,25 @@ class AsyncHTTPRequest
     void        onReadyStateChangeArg(callback_arg_t arg = 0);                   // set event handlers arg
     // or you can simply poll readyState()
     void        setTimeout(int seconds);                                // overide default timeout (seconds)
+    void        setIdleTimeout(uint32_t ms);                            // max gap between packets (default 3000, 0 = none)
+    void        setConnectTimeout(uint32_t ms);                         // connection must be up within ms (0 = none)
+    void        setFirstByteTimeout(uint32_t ms);                       // response must start within ms of the request sent (0 = none)
+    void        setTotalTimeout(uint32_t ms);                           // whole exchange, open() to Done (0 = none)
+    void        setAdaptiveTimeouts(AsyncHTTPRTTEstimator* estimator);  // connect, first-byte and idle from measured RTTs (nullptr = off)
+    void        setHedging(uint32_t delayMs, AsyncHTTPRTTEstimator* estimator = nullptr); // second copy of a GET if no response by then (0 = off)
+    void        setConnectionPool(AsyncHTTPConnectionPool* pool);       // share idle keep-alive connections (nullptr = own connection)
+    void        setPipeline(AsyncHTTPPipeline* pipeline);               // pipeline GETs to the pipeline's origin (nullptr = off)
+    void        setHTTP2(AsyncHTTP2Session* session);                   // requests to the session's origin as HTTP/2 streams (nullptr = off)
+    void        setDNSCache(AsyncHTTPDNSCache* cache);                  // connect by cached address (nullptr = resolve every time)
+    void        setRetryPolicy(AsyncHTTPRetryPolicy* policy);           // retry failures per policy (nullptr = never)
+    void        setCircuitBreaker(AsyncHTTPCircuitBreaker* breaker);    // fail fast while the origin is down (nullptr = off)
+    void        setCoalescer(AsyncHTTPCoalescer* coalescer);            // share the response of an identical GET in flight (nullptr = off)
+    void        setResponseCache(AsyncHTTPResponseCache* cache);        // answer GETs from fresh stored responses (nullptr = off)
+    void        setMaxResponseLength(size_t bytes);                     // abort responses with a larger body (0 = no limit)
 
     void        setReqHeader(const char* name, const char* value);      // add a request header
     void        setReqHeader(const char* name, int32_t value);          // overload to use integer value
+    void        setRange(size_t first, size_t last = SIZE_MAX);         // request byte range first..last (inclusive)
     
 #if (ESP32 || ESP8266)
     void        setReqHeader(const char* name, const __FlashStringHelper* value);
@@ -229,6 +273,8 @@ class AsyncHTTPRequest
     bool        send(const uint8_t* buffer, size_t len);                // Send the request (POST) (binary data?)
     bool        send(xbuf* body, size_t len);                           // Send the request (POST) data in an xbuf
     void        abort();                                                // Abort the current operation
+    void        pauseSend(bool pause);                                  // Hold back the rest of the request body (true) or resume it
+    bool        sendPaused() const      { return _sendPaused; }
 
     ReadyState  readyState() const;                                     // Return the ready state
 
@@ -252,9 +298,26 @@ class AsyncHTTPRequest
     size_t      available() const;                                      // response available
     size_t      responseLength() const;                                 // indicated response length or sum of chunks to date
     int         responseHTTPcode() const;                               // HTTP response code or (negative) error code
+    size_t      responseRangeStart() const;                             // offset of 206 Partial Content body in the resource
+    size_t      responseRangeTotal() const;                             // full resource length from Content-Range (0 if unknown)
     String      responseText();                                         // response (whole* or partial* as string)
     size_t      responseRead(uint8_t* buffer, size_t len);              // Read response into buffer
     uint32_t    elapsedTime() const;                                    // Elapsed time of in progress transaction or last completed (ms)
+    uint8_t     retries() const         { return _attempt; }            // Retries made by the current or last request
+    bool        hedged() const          { return _hedged; }             // Response came from the hedged copy
+    bool        fromCache() const       { return _fromCache; }          // Response came from the response cache
+    bool        revalidated() const     { return _fromCache && _revalidating; } // ... after the server answered 304
+
+    static uint32_t hedgesFired()       { return _hedgesFired; }        // Hedged copies sent, all requests
+    static uint32_t hedgesWon()         { return _hedgesWon; }          // Hedged copies that answered first
+
+    void        setDigest(DigestType type, const char* verifyHeader = nullptr); // Hash response body as received, optionally verify against header
+    String      responseDigest() const;                                 // Hex digest of response body (at Done)
+    void        setJsonParser(xjson* parser, bool keepBody = false);    // Stream response body into parser, buffer it only if keepBody
+    void        setEventStream(xsse* parser);                           // GET a text/event-stream into parser, reconnect when dropped (nullptr = off)
+    void        setStreaming(bool on);                                  // take a 200 response as an endless stream, consumed as it arrives
+    void        setHeartbeat(uint32_t ms);                              // an open stream is dead after ms without a byte (0 = never)
+    bool        streaming() const       { return _streaming; }          // Response is open as a stream
     String      version() const;                                        // Version of AsyncHTTPRequest
     //___________________________________________________________________________________________________________________________________
 
@@ -265,21 +328,85 @@ class AsyncHTTPRequest
 
     int16_t         _HTTPcode{0};                 // HTTP response code or (negative) exception code
     bool            _chunked{false};              // Processing chunked response
+    bool            _closeDelimited{false};       // Response body ends when the server closes
+    bool            _keepAlive{true};             // Connection may be reused after this response
+    uint32_t        _keepAliveTimeout{0};         // Keep-Alive timeout announced by the server (ms), 0 if none
+    uint8_t         _httpMinor{1};                // Minor version of response, HTTP/1.x
     bool            _debug{DEBUG_IOTA_HTTP_SET};  // Debug state
-    uint32_t        _timeout{DEFAULT_RX_TIMEOUT}; // Default or user overide RxTimeout in seconds
+    uint32_t        _timeout{DEFAULT_RX_TIMEOUT * 1000}; // Idle (inter-packet) timeout in ms, 0 for none
+    uint32_t        _connectTimeout{0};           // Connect deadline in ms, 0 for none
+    uint32_t        _firstByteTimeout{0};         // First response byte deadline in ms, 0 for none
+    uint32_t        _totalTimeout{0};             // Overall deadline in ms, 0 for none
     uint32_t        _lastActivity{0};             // Time of last activity
+    uint32_t        _connectStartTime{0};         // Time the connection was asked for
+    uint32_t        _sentTime{0};                 // Time the last request byte went out
+    bool            _awaitingResponse{false};     // Request sent, no response byte yet
+    AsyncHTTPRTTEstimator* _rtt{nullptr};         // optional source of adaptive deadlines, fed with samples
+    uint32_t        _rttConnect{0};               // Adaptive connect deadline in ms, 0 for none
+    uint32_t        _rttFirstByte{0};             // Adaptive first-byte and idle deadline in ms, 0 for none
+    bool            _timingConnect{false};        // A connect is under way from its start, sample it
+    uint32_t        _hedgeDelay{0};               // Hedge a GET not answered after this (ms), 0 for never
+    AsyncHTTPRTTEstimator* _hedgeRTT{nullptr};    // optional p95 source for the hedge delay
+    AsyncHTTPRequest* _hedge{nullptr};            // the second copy, kept for reuse
+    AsyncHTTPRequest* _hedgeOf{nullptr};          // for a hedge: the request it races for
+    bool            _hedged{false};               // response is the hedge's
     uint32_t        _requestStartTime{0};         // Time last open() issued
     uint32_t        _requestEndTime{0};           // Time of last disconnect
     URL             _URL{};                       // -> URL data structure
     String          _connectedHost;               // Host when connected
     int             _connectedPort{-1};           // Port when connected
     AsyncClient*    _client{nullptr};             // ESPAsyncTCP AsyncClient instance
+    AsyncHTTPConnectionPool* _pool{nullptr};      // optional shared pool of idle connections
+    AsyncHTTPPipeline* _pipeline{nullptr};        // optional pipelined connection
+    AsyncHTTPDNSCache* _dns{nullptr};             // optional resolver cache
+    bool            _connectByName{false};        // connecting by host name, address goes into _dns
+    bool            _connectByCache{false};       // connecting to an address from _dns
+    bool            _piped{false};                // this request goes through _pipeline
+    AsyncHTTP2Session* _session{nullptr};         // optional HTTP/2 connection
+    bool            _h2{false};                   // this request is a stream on _session
+    bool            _trailers{false};             // last chunk seen, reading trailer fields
+    bool            _inData{false};               // inside _onData()
+    bool            _doneDeferred{false};         // Done reached inside _onData(), callback still due
+    bool            _sendPaused{false};           // _send() holds back what is left of the request
+    AsyncHTTPRetryPolicy* _retry{nullptr};        // optional retry policy
+    AsyncHTTPCircuitBreaker* _breaker{nullptr};   // optional per origin circuit breaker
+    uint8_t         _attempt{0};                  // retries made since open()
+    bool            _retryPending{false};         // failed, waiting out the backoff before trying again
+    bool            _aborted{false};              // abort() called, not to be retried
+    AsyncHTTPCoalescer* _coalescer{nullptr};      // optional registry of GETs in flight
+    bool            _connectPending{false};       // open() held the connect back, send() may answer without it
+    AsyncHTTPResponseCache* _cache{nullptr};      // optional cache of GET responses
+    uint32_t        _cacheLifetime{0};            // freshness of that response (ms)
+    bool            _fromCache{false};            // response came from _cache
+    bool            _revalidating{false};         // asked whether the stored response still holds
+    AsyncHTTPRequest* _leader{nullptr};           // request whose response this one shares
+    AsyncHTTPRequest* _followers{nullptr};        // requests sharing this one's response
+    AsyncHTTPRequest* _nextFollower{nullptr};     // next in the leader's list
     size_t          _contentLength{0};            // content-length header value or sum of chunk headers
-    size_t          _contentRead{0};              // number of bytes retrieved by user since last open()
+    size_t          _contentRead{0};              // number of bytes retrieved by user (or consumed by parser) since last open()
+    size_t          _maxResponseLength{0};        // body size limit, 0 for none
+    size_t          _rangeStart{0};               // Content-Range first byte of a 206 response
+    size_t          _rangeTotal{0};               // Content-Range complete length of a 206 response
     readyStateChangeCB _readyStateChangeCB{};     // optional callback for readyState change
     callback_arg_t  _readyStateChangeCBarg{};     // associated user argument
     onDataCB        _onDataCB{nullptr};           // optional callback when data received
     void*           _onDataCBarg{nullptr};        // associated user argument
+    xdigest         _digest{};                    // running digest of response body
+    String          _digestHeader;                // response header holding expected digest
+    xjson*          _json{nullptr};               // optional streaming parser fed with the response body
+    bool            _jsonKeepBody{false};         // also buffer the body for responseText()/responseRead()
+    xsse*           _sse{nullptr};                // optional event stream parser, the request reconnects to the stream
+    bool            _streamMode{false};           // responses are taken as streams
+    bool            _streaming{false};            // the response is a stream: consumed as it arrives, no idle timeout
+    uint32_t        _heartbeat{0};                // an open stream is dead after this long without a byte (ms), 0 for never
+    String          _streamHeaders;               // the application's request headers, sent again on reconnect
+
+    AsyncHTTPTimer  _deadline;                    // on the shared wheel, fires at the nearest deadline
+    AsyncHTTPTimer  _retryTimer;                  // ends the backoff before a retry
+    AsyncHTTPTimer  _hedgeTimer;                  // sends the hedge
+
+    static uint32_t _hedgesFired;
+    static uint32_t _hedgesWon;
 
 #ifdef ESP32
     SemaphoreHandle_t threadLock{xSemaphoreCreateRecursiveMutex()};
@@ -290,18 +417,56 @@ class AsyncHTTPRequest
     xbuf*       _request{nullptr};              // Tx data buffer
     xbuf*       _response{nullptr};             // Rx data buffer for headers
     xbuf*       _chunks{nullptr};               // First stage for chunked response
+    xbuf*       _replay{nullptr};               // Copy of request sent on a reused connection, until it answers
+    xbuf*       _surplus{nullptr};              // Bytes received past the end of the response (next pipelined one)
+    xbuf*       _sent{nullptr};                 // Copy of the request as sent, resent as is by a retry
+    xbuf*       _cacheBody{nullptr};            // Copy of a cacheable response body, as it goes by
     header*     _headers{nullptr};              // request or (readyState > readyStateHdrsRcvd) response headers
 
     // Protected functions
 
     header*     _addHeader(const String &name, const String &value);
+    void        _addHeaders(const String &lines);
     header*     _getHeader(const String &name);
     header*     _getHeader(int idx);
+    bool        _headerHasToken(header* hdr, const char* token);
     bool        _buildRequest();
     void        _processChunks();
+    void        _finishResponse();
+    size_t      _writeBody(const uint8_t* data, size_t len);
+    size_t      _writeBody(xbuf* src, size_t len);
+    bool        _tooLarge(size_t length);
     bool        _connect();
+    void        _dropClient();
+    void        _rewind();
+    void        _keepSurplus(const uint8_t* data, size_t len);
     size_t      _send();
+    void        _allSent();
     void        _setReadyState(ReadyState readyState);
+    uint32_t    _deadlineIn(uint32_t now) const;
+    void        _armDeadline();
+    void        _expire();
+    bool        _scheduleRetry();
+    bool        _scheduleReconnect();
+    void        _armHedge();
+    void        _stopHedge();
+    void        _adoptHedge(void* data, size_t len);
+    void        _bindClient();
+    void        _beginResponse();
+    void        _resetResponse();
+    bool        _unanswered() const;
+    String      _coalesceKey(bool urlOnly = false);
+    bool        _coalesce();
+    void        _join(AsyncHTTPRequest* leader);
+    void        _leave();
+    void        _releaseFollowers();
+    bool        _startExchange();
+    String      _cacheKey(HTTPmethod method);
+    bool        _serveCached();
+    void        _cacheBegin();
+    bool        _cacheValidate();
+    void        _serveRevalidated();
+    void        _cacheStore();
     
 #if (ESP32 || ESP8266)    
     char*       _charstar(const __FlashStringHelper *str);
@@ -314,5 +479,9 @@ class AsyncHTTPRequest
     void        _onData(void*, size_t);
     void        _onError(AsyncClient*, int8_t);
     void        _onPoll(AsyncClient*);
+    void        _onDeadline();
+    void        _onRetry();
+    void        _onReconnect();
+    void        _onHedge();
     bool        _collectHeaders();
 };
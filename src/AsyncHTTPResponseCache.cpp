@@ -0,0 +1,397 @@
+/****************************************************************************************************************************
+  AsyncHTTPResponseCache.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+ 
+
+#include "AsyncHTTPRequest.h"
+
+namespace {
+#if ESP32
+class LockHelper
+{
+public:
+    LockHelper(QueueHandle_t _xMutex) :
+        xMutex{_xMutex}
+    {
+        xSemaphoreTakeRecursive(xMutex, portMAX_DELAY);
+    }
+    ~LockHelper()
+    {
+        xSemaphoreGiveRecursive(xMutex);
+    }
+
+private:
+    const QueueHandle_t xMutex;
+};
+#define _lock LockHelper lock{this->threadLock}
+#else
+#define _lock
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPResponseCache::AsyncHTTPResponseCache(size_t budget) :
+  _budget{budget}
+{
+}
+
+//**************************************************************************************************************
+AsyncHTTPResponseCache::~AsyncHTTPResponseCache()
+{
+  delete _entries;
+
+#ifdef ESP32
+  vSemaphoreDelete(threadLock);
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPResponseCache& AsyncHTTPResponseCache::instance()
+{
+  static AsyncHTTPResponseCache cache;
+
+  return cache;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPResponseCache::setBudget(size_t bytes)
+{
+  _lock;
+
+  _budget = bytes;
+  _evict(0);
+}
+
+//**************************************************************************************************************
+size_t AsyncHTTPResponseCache::entries() const
+{
+  size_t count = 0;
+
+  for (entry* e = _entries; e; e = e->next)
+    count++;
+
+  return count;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPResponseCache::flush()
+{
+  _lock;
+
+  delete _entries;
+  _entries = nullptr;
+  _used = 0;
+
+#if (ESP32 || ESP8266)
+  if (_files)
+    _files->flush();
+#endif
+}
+
+#if (ESP32 || ESP8266)
+//**************************************************************************************************************
+void AsyncHTTPResponseCache::setFileCache(AsyncHTTPFileCache* files)
+{
+  _files = files;
+}
+#endif
+
+//**************************************************************************************************************
+uint32_t AsyncHTTPResponseCache::lifetime(const String &cacheControl, const String &expires, const String &date,
+                                          const String &age)
+{
+  String directives = cacheControl;
+  directives.toLowerCase();
+
+  if (directives.indexOf("no-store") >= 0 || directives.indexOf("no-cache") >= 0)
+    return 0;
+
+  uint32_t seconds = 0;
+  int param = directives.indexOf("max-age=");
+
+  if (param >= 0)
+  {
+    seconds = directives.substring(param + 8).toInt();
+  }
+  else if (expires.length())
+  {
+    // Against the server's own clock, the device's may not even be set
+    uint32_t expiry = parseDate(expires);
+    uint32_t now    = parseDate(date);
+
+    if ( ! now || expiry <= now)
+      return 0;
+
+    seconds = expiry - now;
+  }
+
+  // Already this old when it left the cache it came through
+  uint32_t aged = age.toInt();
+
+  seconds = seconds > aged ? seconds - aged : 0;
+
+  // Compared against millis() differences, keep well inside their range
+  if (seconds > 0x7FFFFFFF / 1000)
+    seconds = 0x7FFFFFFF / 1000;
+
+  return seconds * 1000;
+}
+
+//**************************************************************************************************************
+uint32_t AsyncHTTPResponseCache::parseDate(const String &date)
+{
+  // "Sun, 06 Nov 1994 08:49:37 GMT"
+  static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+  int  day, year, hour, minute, second;
+  char month[4];
+
+  if (sscanf(date.c_str(), "%*[^,], %d %3s %d %d:%d:%d", &day, month, &year, &hour, &minute, &second) != 6)
+    return 0;
+
+  const char* found = strstr(months, month);
+
+  if ( ! found || strlen(month) != 3 || year < 1970)
+    return 0;
+
+  int mon = (found - months) / 3 + 1;
+
+  // Days since 1970-01-01 of a civil date
+  int y    = year - (mon <= 2);
+  int era  = y / 400;
+  int yoe  = y - era * 400;
+  int doy  = (153 * (mon + (mon > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int doe  = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  uint32_t days = era * 146097 + doe - 719468;
+
+  return days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+//**************************************************************************************************************
+AsyncHTTPResponseCache::entry* AsyncHTTPResponseCache::_find(const String &key)
+{
+  _lock;
+
+  entry** pe = &_entries;
+
+  while (*pe)
+  {
+    entry* e = *pe;
+
+    if (e->key == key)
+    {
+      // Most recently used goes to the front, the back is evicted first
+      *pe = e->next;
+      e->next = _entries;
+      _entries = e;
+
+      return e;
+    }
+
+    pe = &e->next;
+  }
+
+#if (ESP32 || ESP8266)
+  if (_files)
+    return _restore(key);
+#endif
+
+  return nullptr;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPResponseCache::_fresh(const entry* e) const
+{
+  return e && (millis() - e->stored) < e->lifetime;
+}
+
+//**************************************************************************************************************
+String AsyncHTTPResponseCache::_header(const entry* e, const char* name)
+{
+  size_t length = strlen(name);
+  int    beg = 0;
+
+  while (beg < (int) e->headers.length())
+  {
+    int end = e->headers.indexOf("\r\n", beg);
+
+    if (e->headers.charAt(beg + length) == ':' && e->headers.substring(beg, beg + length).equalsIgnoreCase(name))
+      return e->headers.substring(beg + length + 2, end);
+
+    beg = end + 2;
+  }
+
+  return String();
+}
+
+//**************************************************************************************************************
+void AsyncHTTPResponseCache::_store(const String &key, const String &headers, xbuf* body, uint32_t lifetime)
+{
+  _lock;
+
+  _drop(key);
+
+  entry* e = new entry;
+
+  e->key      = key;
+  e->headers  = headers;
+  e->length   = body->available();
+  e->stored   = millis();
+  e->lifetime = lifetime;
+
+  size_t size = e->size();
+
+  if (size > _budget)
+  {
+    AHTTP_LOGDEBUG3("cache: too large to keep", key, ", size =", size);
+
+    delete e;
+
+#if (ESP32 || ESP8266)
+    if (_files)
+      _files->_remove(key);
+#endif
+
+    return;
+  }
+
+  _evict(size);
+
+  if (e->length)
+  {
+    e->body = new uint8_t[e->length];
+    body->read(e->body, e->length);
+  }
+
+  AHTTP_LOGDEBUG3("cache: stored", key, ", lifetime =", lifetime);
+
+  e->next  = _entries;
+  _entries = e;
+  _used   += size;
+
+#if (ESP32 || ESP8266)
+  // Only what can be revalidated is of use after a restart
+  if (_files && (_header(e, "ETag").length() || _header(e, "Last-Modified").length()))
+    _files->_store(key, headers, e->body, e->length);
+  else if (_files)
+    _files->_remove(key);
+#endif
+}
+
+//**************************************************************************************************************
+void AsyncHTTPResponseCache::_remove(const String &key)
+{
+  _lock;
+
+  _drop(key);
+
+#if (ESP32 || ESP8266)
+  if (_files)
+    _files->_remove(key);
+#endif
+}
+
+//**************************************************************************************************************
+void AsyncHTTPResponseCache::_drop(const String &key)
+{
+  entry** pe = &_entries;
+
+  while (*pe)
+  {
+    if ((*pe)->key == key)
+    {
+      entry* e = *pe;
+
+      *pe = e->next;
+      e->next = nullptr;
+      _used -= e->size();
+      delete e;
+
+      return;
+    }
+
+    pe = &(*pe)->next;
+  }
+}
+
+#if (ESP32 || ESP8266)
+//**************************************************************************************************************
+AsyncHTTPResponseCache::entry* AsyncHTTPResponseCache::_restore(const String &key)
+{
+  String   headers;
+  uint8_t* body = nullptr;
+  size_t   length = 0;
+
+  if ( ! _files->_load(key, headers, body, length))
+    return nullptr;
+
+  entry* e = new entry;
+
+  e->key      = key;
+  e->headers  = headers;
+  e->body     = body;
+  e->length   = length;
+  e->stored   = millis();
+  e->lifetime = 0;                                // age unknown across a restart, so stale: revalidated on use
+
+  size_t size = e->size();
+
+  if (size > _budget)
+  {
+    delete e;
+
+    return nullptr;
+  }
+
+  _evict(size);
+
+  e->next  = _entries;
+  _entries = e;
+  _used   += size;
+
+  return e;
+}
+#endif
+
+//**************************************************************************************************************
+void AsyncHTTPResponseCache::_evict(size_t room)
+{
+  // Least recently used is last
+  while (_entries && _used + room > _budget)
+  {
+    entry** pe = &_entries;
+
+    while ((*pe)->next)
+      pe = &(*pe)->next;
+
+    AHTTP_LOGDEBUG1("cache: evicting", (*pe)->key);
+
+    _used -= (*pe)->size();
+    delete *pe;
+    *pe = nullptr;
+    _evictions++;
+  }
+}
@@ -0,0 +1,123 @@
+/****************************************************************************************************************************
+  AsyncHTTPResponseCache.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+#pragma once
+
+#include <Arduino.h>
+#include <WString.h>
+
+#ifndef RESPONSE_CACHE_BUDGET
+  #define RESPONSE_CACHE_BUDGET   16384           // bytes of keys, headers and bodies kept
+#endif
+
+class AsyncHTTPRequest;
+class AsyncHTTPFileCache;
+class xbuf;
+
+//! Bounded in-memory cache of GET responses, keyed by method and URL. A response is stored when its
+//! Cache-Control max-age, or Expires relative to its Date, gives it a freshness lifetime (no-store and no-cache
+//! keep it out); a request finding a fresh copy is answered from it in send() without touching the network,
+//! through the same readyState and onData callbacks. Least recently used entries are evicted to stay within
+//! the byte budget. Only 200 responses to requests without a Range are kept.
+//! A response with an ETag or Last-Modified is kept even without a lifetime: once it is stale the request
+//! asks for it with If-None-Match / If-Modified-Since, and a 304 answer is completed from the stored copy as
+//! a 200, so polling something that doesn't change transfers only headers.
+class AsyncHTTPResponseCache
+{
+    struct entry
+    {
+      entry*        next{};
+      String        key;                          // "GET host:port/path?query"
+      String        headers;                      // "name: value\r\n" per stored response header
+      uint8_t*      body{nullptr};
+      size_t        length{0};
+      uint32_t      stored{0};                    // millis() when stored
+      uint32_t      lifetime{0};                  // fresh this long after stored (ms)
+
+      ~entry()
+      {
+        delete[] body;
+        delete next;
+      }
+
+      size_t size() const
+      {
+        return sizeof(entry) + key.length() + headers.length() + length;
+      }
+    };
+
+  public:
+    AsyncHTTPResponseCache(size_t budget = RESPONSE_CACHE_BUDGET);
+    ~AsyncHTTPResponseCache();
+
+    static AsyncHTTPResponseCache& instance();                          // The shared cache
+
+    void          setBudget(size_t bytes);                              // Evicts down to it at once
+    size_t        budget() const        { return _budget; }
+    size_t        used() const          { return _used; }               // bytes held
+    size_t        entries() const;
+    void          flush();                                              // Drop everything, on the filesystem too
+
+#if (ESP32 || ESP8266)
+    void          setFileCache(AsyncHTTPFileCache* files);              // Keep revalidatable responses across restarts (nullptr = off)
+#endif
+
+    uint32_t      hits() const          { return _hits; }               // answered from the cache
+    uint32_t      misses() const        { return _misses; }             // had to go to the network
+    uint32_t      evictions() const     { return _evictions; }          // dropped to make room
+    uint32_t      revalidations() const { return _revalidations; }      // hits confirmed by a 304
+
+    static uint32_t lifetime(const String &cacheControl, const String &expires, const String &date,
+                             const String &age);                        // Freshness lifetime in ms, 0 if none
+    static uint32_t parseDate(const String &date);                      // RFC 1123 date to Unix seconds, 0 if invalid
+
+  private:
+    friend class AsyncHTTPRequest;
+
+    entry*        _entries{nullptr};              // most recently used first
+    size_t        _budget;
+    size_t        _used{0};
+    uint32_t      _hits{0};
+    uint32_t      _misses{0};
+    uint32_t      _evictions{0};
+    uint32_t      _revalidations{0};
+    AsyncHTTPFileCache* _files{nullptr};          // optional filesystem tier
+
+#ifdef ESP32
+    SemaphoreHandle_t threadLock{xSemaphoreCreateRecursiveMutex()};
+#endif
+
+    entry*        _find(const String &key);       // and make it most recently used
+    bool          _fresh(const entry* e) const;
+    static String _header(const entry* e, const char* name);
+    void          _store(const String &key, const String &headers, xbuf* body, uint32_t lifetime);
+    void          _remove(const String &key);
+    void          _drop(const String &key);      // from memory only
+#if (ESP32 || ESP8266)
+    entry*        _restore(const String &key);    // from the filesystem tier into memory
+#endif
+    void          _evict(size_t room);
+};
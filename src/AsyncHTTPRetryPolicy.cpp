@@ -0,0 +1,246 @@
+/****************************************************************************************************************************
+  AsyncHTTPRetryPolicy.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+
+#include "AsyncHTTPRequest.h"
+
+#define RETRY_MAX_HOSTS           8               // hosts whose budget is tracked
+
+namespace {
+#if ESP32
+class LockHelper
+{
+public:
+    LockHelper(QueueHandle_t _xMutex) :
+        xMutex{_xMutex}
+    {
+        xSemaphoreTakeRecursive(xMutex, portMAX_DELAY);
+    }
+    ~LockHelper()
+    {
+        xSemaphoreGiveRecursive(xMutex);
+    }
+
+private:
+    const QueueHandle_t xMutex;
+};
+#define _lock LockHelper lock{this->threadLock}
+#else
+#define _lock
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPRetryPolicy::AsyncHTTPRetryPolicy()
+{
+  _methods = 1 << int(HTTPmethod::GET);
+
+  // Failures where the server most likely never acted on the request, or says to come back later
+  setRetryOn(HttpCode::CONNECTION_REFUSED);
+  setRetryOn(HttpCode::NOT_CONNECTED);
+  setRetryOn(HttpCode::CONNECTION_LOST);
+  setRetryOn(HttpCode::TIMEOUT);
+  setRetryOn(502);
+  setRetryOn(503);
+  setRetryOn(504);
+}
+
+//**************************************************************************************************************
+AsyncHTTPRetryPolicy::~AsyncHTTPRetryPolicy()
+{
+  delete _hosts;
+
+#ifdef ESP32
+  vSemaphoreDelete(threadLock);
+#endif
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRetryPolicy::setMaxAttempts(uint8_t attempts)
+{
+  _maxAttempts = attempts ? attempts : 1;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRetryPolicy::setBackoff(uint32_t baseMs, uint32_t maxMs)
+{
+  _baseBackoff = baseMs;
+  _maxBackoff  = maxMs < baseMs ? baseMs : maxMs;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRetryPolicy::setRetryOn(int code, bool retry)
+{
+  _lock;
+
+  for (uint8_t i = 0; i < _codeCount; i++)
+  {
+    if (_codes[i] != code)
+      continue;
+
+    if ( ! retry)
+      _codes[i] = _codes[--_codeCount];
+
+    return;
+  }
+
+  if (retry && _codeCount < RETRY_MAX_CODES)
+    _codes[_codeCount++] = code;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRetryPolicy::setRetryMethod(HTTPmethod method, bool retry)
+{
+  if (retry)
+    _methods |= 1 << int(method);
+  else
+    _methods &= ~(1 << int(method));
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRetryPolicy::setBudget(uint8_t percent, uint8_t burst)
+{
+  _lock;
+
+  _budget = percent;
+  _burst  = burst;
+
+  for (entry* e = _hosts; e; e = e->next)
+  {
+    if (e->tokens > _burst * 100)
+      e->tokens = _burst * 100;
+  }
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPRetryPolicy::retryable(HTTPmethod method, int code) const
+{
+  if ( ! (_methods & (1 << int(method))))
+    return false;
+
+  for (uint8_t i = 0; i < _codeCount; i++)
+  {
+    if (_codes[i] == code)
+      return true;
+  }
+
+  return false;
+}
+
+//**************************************************************************************************************
+uint32_t AsyncHTTPRetryPolicy::backoff(uint8_t retry) const
+{
+  uint32_t ceiling = _baseBackoff;
+
+  while (--retry && ceiling < _maxBackoff)
+    ceiling <<= 1;
+
+  if (ceiling > _maxBackoff)
+    ceiling = _maxBackoff;
+
+  // Anywhere up to the ceiling, so a fleet that failed at once spreads out
+  return random(ceiling + 1);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPRetryPolicy::deposit(const String &host)
+{
+  _lock;
+
+  entry* e = _find(host);
+
+  e->tokens = e->tokens + _budget < _burst * 100 ? e->tokens + _budget : _burst * 100;
+}
+
+//**************************************************************************************************************
+bool AsyncHTTPRetryPolicy::withdraw(const String &host)
+{
+  _lock;
+
+  entry* e = _find(host);
+
+  if (e->tokens < 100)
+  {
+    AHTTP_LOGDEBUG1("retry budget exhausted for", host);
+
+    _denied++;
+
+    return false;
+  }
+
+  e->tokens -= 100;
+  _retries++;
+
+  return true;
+}
+
+//**************************************************************************************************************
+AsyncHTTPRetryPolicy::entry* AsyncHTTPRetryPolicy::_find(const String &host)
+{
+  entry* prev = (entry*) &_hosts;
+  entry* found = nullptr;
+  uint8_t count = 0;
+
+  while (prev->next)
+  {
+    if (prev->next->host.equalsIgnoreCase(host))
+    {
+      found = prev->next;
+      prev->next = found->next;
+      found->next = nullptr;
+    }
+    else
+    {
+      prev = prev->next;
+      count++;
+    }
+  }
+
+  // A host not seen before starts with a full bucket
+  if ( ! found)
+  {
+    if (count >= RETRY_MAX_HOSTS)
+    {
+      entry* oldest = _hosts;
+      _hosts = oldest->next;
+      oldest->next = nullptr;
+      delete oldest;
+      prev = (entry*) &_hosts;
+
+      while (prev->next)
+        prev = prev->next;
+    }
+
+    found = new entry;
+    found->host   = host;
+    found->tokens = _burst * 100;
+  }
+
+  // Most recently used goes last
+  prev->next = found;
+
+  return found;
+}
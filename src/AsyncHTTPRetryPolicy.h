@@ -0,0 +1,94 @@
+/****************************************************************************************************************************
+  AsyncHTTPRetryPolicy.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+#pragma once
+
+#include <Arduino.h>
+#include <WString.h>
+
+enum class HTTPmethod;
+
+#define RETRY_MAX_CODES           8               // retryable codes a policy holds
+
+//! When and how soon a failed request is tried again, shared by the requests that opt in with setRetryPolicy().
+//! A failure is retried if its code and method are retryable, attempts remain, and the host's retry budget allows.
+//! Each retry waits a random time up to an exponentially growing backoff ("full jitter"), so clients that failed
+//! together don't come back together. A Retry-After from the server is honoured if it is within the longest backoff.
+//! The budget is a token bucket per host: every request adds budget/100 of a retry, every retry takes one, up to
+//! burst retries. During an outage retries stay a fixed fraction of the traffic instead of multiplying it.
+class AsyncHTTPRetryPolicy
+{
+    struct entry
+    {
+      entry*      next{};
+      String      host;
+      uint16_t    tokens{0};                      // retries available, in hundredths
+
+      ~entry()
+      {
+        delete next;
+      }
+    };
+
+  public:
+    AsyncHTTPRetryPolicy();
+    ~AsyncHTTPRetryPolicy();
+
+    void        setMaxAttempts(uint8_t attempts);                       // Attempts including the first (default 3)
+    void        setBackoff(uint32_t baseMs, uint32_t maxMs);            // Backoff before retry n is base * 2^(n-1), up to max (default 200, 10000)
+    void        setRetryOn(int code, bool retry = true);                // HttpCode or HTTP status that is retried
+    void        setRetryMethod(HTTPmethod method, bool retry = true);   // Methods retried (default GET only)
+    void        setBudget(uint8_t percent, uint8_t burst);              // Retries per host: percent of requests, up to burst (default 20, 10)
+
+    uint8_t     maxAttempts() const   { return _maxAttempts; }
+    bool        retryable(HTTPmethod method, int code) const;
+    uint32_t    backoff(uint8_t retry) const;                           // Jittered wait before retry number retry (1 = first)
+    uint32_t    maxBackoff() const    { return _maxBackoff; }
+    void        deposit(const String &host);                            // A request to host starts
+    bool        withdraw(const String &host);                           // Take a retry from host's budget
+
+    uint32_t    retries() const       { return _retries; }              // retries granted
+    uint32_t    denied() const        { return _denied; }               // retries refused by the budget
+
+  private:
+    uint8_t     _maxAttempts{3};
+    uint32_t    _baseBackoff{200};
+    uint32_t    _maxBackoff{10000};
+    uint8_t     _methods{0};                      // bit per HTTPmethod
+    int16_t     _codes[RETRY_MAX_CODES]{};
+    uint8_t     _codeCount{0};
+    uint8_t     _budget{20};
+    uint8_t     _burst{10};
+    entry*      _hosts{nullptr};                  // least recently used first
+    uint32_t    _retries{0};
+    uint32_t    _denied{0};
+
+#ifdef ESP32
+    SemaphoreHandle_t threadLock{xSemaphoreCreateRecursiveMutex()};
+#endif
+
+    entry*      _find(const String &host);
+};
@@ -0,0 +1,365 @@
+/****************************************************************************************************************************
+  AsyncHTTPTimerWheel.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+
+#include "AsyncHTTPRequest.h"
+
+namespace {
+#if ESP32
+class LockHelper
+{
+public:
+    LockHelper(QueueHandle_t _xMutex) :
+        xMutex{_xMutex}
+    {
+        xSemaphoreTakeRecursive(xMutex, portMAX_DELAY);
+    }
+    ~LockHelper()
+    {
+        xSemaphoreGiveRecursive(xMutex);
+    }
+
+private:
+    const QueueHandle_t xMutex;
+};
+#define _lock LockHelper lock{this->threadLock}
+#else
+#define _lock
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPTimer::~AsyncHTTPTimer()
+{
+  if (_pprev)
+    _wheel->cancel(*this);
+}
+
+//**************************************************************************************************************
+AsyncHTTPTimerWheel::AsyncHTTPTimerWheel()
+{
+  _lastRun = millis();
+}
+
+//**************************************************************************************************************
+AsyncHTTPTimerWheel::~AsyncHTTPTimerWheel()
+{
+#if (ESP32 || ESP8266)
+  _ticker.detach();
+#endif
+
+  // Timers outliving the wheel must not come back to it when they are destroyed
+  for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++)
+  {
+    for (uint8_t index = 0; index < TIMER_WHEEL_SLOTS; index++)
+    {
+      while (_slots[level][index])
+        _unlink(_slots[level][index]);
+    }
+  }
+
+  while (_due)
+    _unlink(_due);
+
+#ifdef ESP32
+  vSemaphoreDelete(threadLock);
+#endif
+}
+
+//**************************************************************************************************************
+AsyncHTTPTimerWheel& AsyncHTTPTimerWheel::instance()
+{
+  static AsyncHTTPTimerWheel wheel;
+
+  return wheel;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPTimerWheel::arm(AsyncHTTPTimer& timer, uint32_t ms, AsyncHTTPTimer::timerCB cb, void* arg)
+{
+  _lock;
+
+  if (timer.armed())
+  {
+    _unlink(&timer);
+    _armed--;
+  }
+
+  uint32_t now = millis();
+
+  // Nothing pending, the tick count can start over from here
+  if ( ! _armed)
+    _lastRun = now;
+
+  // First tick processed at or after now + ms, never earlier
+  uint32_t ticks = (now - _lastRun + ms + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS;
+
+  timer._expires  = _ticks + (ticks ? ticks : 1);
+  timer._callback = cb;
+  timer._arg      = arg;
+  timer._wheel    = this;
+
+  _insert(&timer);
+  _armed++;
+
+#if (ESP32 || ESP8266)
+  // Sooner than the Ticker is set for: bring it forward, a later one is picked up when it runs
+  if ( ! _ticker.active() || (int32_t) (timer._expires - _wakeTick) < 0)
+    _schedule();
+#endif
+}
+
+//**************************************************************************************************************
+void AsyncHTTPTimerWheel::cancel(AsyncHTTPTimer& timer)
+{
+  _lock;
+
+  if ( ! timer.armed())
+    return;
+
+  _unlink(&timer);
+  _armed--;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPTimerWheel::run()
+{
+  {
+    _lock;
+
+    uint32_t now = millis();
+
+    while (_armed && (now - _lastRun) >= TIMER_WHEEL_TICK_MS)
+    {
+      uint32_t elapsed = (now - _lastRun) / TIMER_WHEEL_TICK_MS;
+      uint32_t next    = _nextEvent();
+
+      // The ticks in between have nothing to fire or cascade, only the count moves on
+      uint32_t skip = (next > elapsed ? elapsed : next - 1);
+
+      _ticks   += skip;
+      _lastRun += skip * TIMER_WHEEL_TICK_MS;
+
+      if (skip < elapsed)
+      {
+        _lastRun += TIMER_WHEEL_TICK_MS;
+        _tick();
+      }
+    }
+  }
+
+  // Fired one at a time with the lock released: callbacks take their owners' locks, and the owners hold those
+  // around arm() and cancel(). A due timer cancelled or re-armed in the meantime leaves the list and doesn't fire.
+  for (;;)
+  {
+    AsyncHTTPTimer::timerCB callback;
+    void* arg;
+
+    {
+      _lock;
+
+      AsyncHTTPTimer* timer = _due;
+
+      if ( ! timer)
+      {
+#if (ESP32 || ESP8266)
+        _schedule();
+#endif
+
+        return;
+      }
+
+      _unlink(timer);
+      _armed--;
+      _fired++;
+
+      // Copied, the callback may well destroy the timer it belongs to
+      callback = timer->_callback;
+      arg = timer->_arg;
+
+      AHTTP_LOGDEBUG1("timer fired, armed =", _armed);
+    }
+
+    if (callback)
+      callback(arg);
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTPTimerWheel::_insert(AsyncHTTPTimer* timer)
+{
+  const uint32_t span = 1UL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS);
+
+  uint32_t delta = timer->_expires - _ticks;
+
+  // Further out than the wheel reaches: wait in the top level's furthest slot, placed again when it cascades
+  uint32_t at = delta < span ? timer->_expires : _ticks + span - 1;
+
+  if (delta >= span)
+    delta = span - 1;
+
+  uint8_t level = 0;
+
+  while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1UL << (TIMER_WHEEL_BITS * (level + 1))))
+    level++;
+
+  _link(&_slots[level][(at >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1)], timer);
+}
+
+//**************************************************************************************************************
+void AsyncHTTPTimerWheel::_link(AsyncHTTPTimer** slot, AsyncHTTPTimer* timer)
+{
+  timer->_next = *slot;
+
+  if (*slot)
+    (*slot)->_pprev = &timer->_next;
+
+  *slot = timer;
+  timer->_pprev = slot;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPTimerWheel::_unlink(AsyncHTTPTimer* timer)
+{
+  *timer->_pprev = timer->_next;
+
+  if (timer->_next)
+    timer->_next->_pprev = timer->_pprev;
+
+  timer->_next  = nullptr;
+  timer->_pprev = nullptr;
+}
+
+//**************************************************************************************************************
+void AsyncHTTPTimerWheel::_cascade(uint8_t level)
+{
+  AsyncHTTPTimer** slot = &_slots[level][(_ticks >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1)];
+  AsyncHTTPTimer*  timer = *slot;
+
+  *slot = nullptr;
+
+  // Now within reach of the levels below, each finds its place there
+  while (timer)
+  {
+    AsyncHTTPTimer* next = timer->_next;
+
+    _insert(timer);
+    timer = next;
+  }
+}
+
+//**************************************************************************************************************
+void AsyncHTTPTimerWheel::_tick()
+{
+  _ticks++;
+
+  for (uint8_t level = 1; level < TIMER_WHEEL_LEVELS; level++)
+  {
+    if (_ticks & ((1UL << (TIMER_WHEEL_BITS * level)) - 1))
+      break;
+
+    _cascade(level);
+  }
+
+  AsyncHTTPTimer** slot = &_slots[0][_ticks & (TIMER_WHEEL_SLOTS - 1)];
+
+  // Still armed until run() fires them
+  while (*slot)
+  {
+    AsyncHTTPTimer* timer = *slot;
+
+    _unlink(timer);
+    _link(&_due, timer);
+  }
+}
+
+//**************************************************************************************************************
+// Ticks from now to the next one with something to do: a level 0 slot holding timers, or a higher level slot that
+// cascades. The ones in between can be skipped. UINT32_MAX when the wheel is empty.
+uint32_t AsyncHTTPTimerWheel::_nextEvent()
+{
+  uint32_t next = UINT32_MAX;
+
+  for (uint32_t ahead = 1; ahead <= TIMER_WHEEL_SLOTS; ahead++)
+  {
+    if (_slots[0][(_ticks + ahead) & (TIMER_WHEEL_SLOTS - 1)])
+    {
+      next = ahead;
+      break;
+    }
+  }
+
+  for (uint8_t level = 1; level < TIMER_WHEEL_LEVELS; level++)
+  {
+    const uint8_t shift = TIMER_WHEEL_BITS * level;
+
+    // Level cascades on each multiple of its span, one slot at a time
+    uint32_t boundary = ((_ticks >> shift) + 1) << shift;
+
+    for (uint8_t i = 0; i < TIMER_WHEEL_SLOTS; i++, boundary += (1UL << shift))
+    {
+      if (boundary - _ticks >= next)
+        break;
+
+      if (_slots[level][(boundary >> shift) & (TIMER_WHEEL_SLOTS - 1)])
+      {
+        next = boundary - _ticks;
+        break;
+      }
+    }
+  }
+
+  return next;
+}
+
+//**************************************************************************************************************
+#if (ESP32 || ESP8266)
+void AsyncHTTPTimerWheel::_schedule()
+{
+  if ( ! _armed)
+  {
+    // Nothing left to time, stop until something is armed again
+    _ticker.detach();
+
+    return;
+  }
+
+  uint32_t next = _due ? 0 : _nextEvent();
+  uint32_t sleep = next > TIMER_WHEEL_MAX_SLEEP_MS / TIMER_WHEEL_TICK_MS ? TIMER_WHEEL_MAX_SLEEP_MS
+                                                                           : next * TIMER_WHEEL_TICK_MS;
+
+  // Counted from the last tick processed, which may be behind; at least a millisecond so the Ticker does go off
+  int32_t ms = (int32_t) (_lastRun + sleep - millis());
+
+  _wakeTick = _ticks + sleep / TIMER_WHEEL_TICK_MS;
+
+  _ticker.once_ms<AsyncHTTPTimerWheel*>(ms > 0 ? ms : 1, [](AsyncHTTPTimerWheel* wheel)
+  {
+    wheel->_wakeups++;
+    wheel->run();
+  }, this);
+}
+#endif
@@ -0,0 +1,127 @@
+/****************************************************************************************************************************
+  AsyncHTTPTimerWheel.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+  
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+  
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+  
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+  
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+  
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License 
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.  
+ 
+  Version: 1.0.0
+  
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+ 
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+
+#if (ESP32 || ESP8266)
+  #include <Ticker.h>
+#endif
+
+#ifndef TIMER_WHEEL_TICK_MS
+  #define TIMER_WHEEL_TICK_MS     10              // Resolution of every deadline on the wheel
+#endif
+
+#ifndef TIMER_WHEEL_MAX_SLEEP_MS
+  #define TIMER_WHEEL_MAX_SLEEP_MS  3600000UL     // Longest the Ticker sleeps, inside ESP8266's os_timer limit
+#endif
+
+#define TIMER_WHEEL_BITS          6               // 64 slots per level
+#define TIMER_WHEEL_LEVELS        4               // 64^4 ticks, 46 hours at 10 ms
+#define TIMER_WHEEL_SLOTS         (1 << TIMER_WHEEL_BITS)
+
+class AsyncHTTPTimerWheel;
+
+//! A deadline registered with an AsyncHTTPTimerWheel, embedded in whatever it times out.
+//! Destroying an armed timer cancels it.
+class AsyncHTTPTimer
+{
+  public:
+    using timerCB = std::function<void(void*)>;
+
+    AsyncHTTPTimer() {}
+    AsyncHTTPTimer(const AsyncHTTPTimer&) = delete;
+    AsyncHTTPTimer& operator=(const AsyncHTTPTimer&) = delete;
+    ~AsyncHTTPTimer();
+
+    bool            armed() const     { return _pprev != nullptr; }
+
+  private:
+    AsyncHTTPTimer*   _next{nullptr};
+    AsyncHTTPTimer**  _pprev{nullptr};            // link pointing at this timer, nullptr when not armed
+    uint32_t          _expires{0};                // tick it fires on
+    timerCB           _callback{};
+    void*             _arg{nullptr};
+    AsyncHTTPTimerWheel* _wheel{nullptr};
+
+    friend class AsyncHTTPTimerWheel;
+};
+
+//! Hierarchical timing wheel shared by every request and pooled connection, so deadlines cost
+//! O(1) to arm and cancel however many are live, and one periodic tick drives them all.
+//! Level 0 holds the next 64 ticks one per slot; each level above covers 64 times the span of the
+//! one below and cascades its timers down as their time comes closer.
+//! On ESP8266/ESP32 the wheel runs itself from a one-shot Ticker, set for the next tick that has a
+//! slot to fire or cascade, so it sleeps through empty ticks and stops once nothing is armed.
+//! Elsewhere call run() from loop(); connection polls also run it, at their coarser interval, as a fallback.
+//! Callbacks are made without the wheel's lock held, they may arm and cancel timers.
+class AsyncHTTPTimerWheel
+{
+  public:
+    AsyncHTTPTimerWheel();
+    ~AsyncHTTPTimerWheel();
+
+    static AsyncHTTPTimerWheel& instance();                             // The shared wheel
+
+    void        arm(AsyncHTTPTimer& timer, uint32_t ms, AsyncHTTPTimer::timerCB cb, void* arg = nullptr); // (Re)arm to fire in ms
+    void        cancel(AsyncHTTPTimer& timer);
+    void        run();                                                  // Fire whatever is due
+
+    size_t      armed() const         { return _armed; }
+    uint32_t    fired() const         { return _fired; }
+    uint32_t    wakeups() const       { return _wakeups; }             // Times the Ticker ran the wheel
+
+  private:
+    AsyncHTTPTimer* _slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS]{};
+    AsyncHTTPTimer* _due{nullptr};                // expired, waiting for run() to fire them
+    uint32_t    _ticks{0};                        // ticks processed
+    uint32_t    _lastRun{0};                      // millis() of the last tick processed
+    size_t      _armed{0};
+    uint32_t    _fired{0};
+    uint32_t    _wakeups{0};
+
+#if (ESP32 || ESP8266)
+    Ticker      _ticker;
+    uint32_t    _wakeTick{0};                     // tick the Ticker is set for, while active
+#endif
+
+#ifdef ESP32
+    SemaphoreHandle_t threadLock{xSemaphoreCreateRecursiveMutex()};
+#endif
+
+    void        _insert(AsyncHTTPTimer* timer);
+    void        _link(AsyncHTTPTimer** slot, AsyncHTTPTimer* timer);
+    void        _unlink(AsyncHTTPTimer* timer);
+    void        _cascade(uint8_t level);
+    void        _tick();
+    uint32_t    _nextEvent();
+
+#if (ESP32 || ESP8266)
+    void        _schedule();
+#endif
+};
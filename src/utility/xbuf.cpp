@@ -362,12 +362,12 @@ void xbuf::addSeg()
 {
   if (_tail) 
   {
-    _tail->next = (xseg*) new uint32_t[_segSize / 4 + 1];
+    _tail->next = (xseg*) new uint32_t[(sizeof(xseg) + _segSize + 3) / 4];
     _tail = _tail->next;
   }
   else 
   {
-    _tail = _head = (xseg*) new uint32_t[_segSize / 4 + 1];
+    _tail = _head = (xseg*) new uint32_t[(sizeof(xseg) + _segSize + 3) / 4];
   }
   
   _tail->next = nullptr;
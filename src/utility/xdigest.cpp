@@ -0,0 +1,397 @@
+/****************************************************************************************************************************
+  xdigest.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  Version: 1.0.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+
+#include "utility/xdigest.h"
+
+namespace {
+
+const uint32_t crcNibble[16] PROGMEM =
+{
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+const uint32_t md5K[64] PROGMEM =
+{
+  0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+  0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+  0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+  0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+  0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+  0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+  0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+  0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+const uint8_t md5R[16] PROGMEM = { 7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21 };
+
+const uint32_t sha256K[64] PROGMEM =
+{
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32_t rotl(uint32_t x, uint8_t n)
+{
+  return (x << n) | (x >> (32 - n));
+}
+
+inline uint32_t rotr(uint32_t x, uint8_t n)
+{
+  return (x >> n) | (x << (32 - n));
+}
+
+}
+
+//*******************************************************************************************************************
+xdigest::xdigest(const DigestType type)
+{
+  begin(type);
+}
+
+//*******************************************************************************************************************
+void xdigest::begin(const DigestType type)
+{
+  _type = type;
+  _finished = false;
+  _count = 0;
+  memset(_digest, 0, sizeof(_digest));
+
+  switch (_type)
+  {
+  case DigestType::CRC32:
+    _state[0] = 0xFFFFFFFF;
+    break;
+
+  case DigestType::MD5:
+    _state[0] = 0x67452301;
+    _state[1] = 0xefcdab89;
+    _state[2] = 0x98badcfe;
+    _state[3] = 0x10325476;
+    break;
+
+  case DigestType::SHA256:
+    _state[0] = 0x6a09e667;
+    _state[1] = 0xbb67ae85;
+    _state[2] = 0x3c6ef372;
+    _state[3] = 0xa54ff53a;
+    _state[4] = 0x510e527f;
+    _state[5] = 0x9b05688c;
+    _state[6] = 0x1f83d9ab;
+    _state[7] = 0x5be0cd19;
+    break;
+
+  case DigestType::None:
+    break;
+  }
+}
+
+//*******************************************************************************************************************
+void xdigest::update(const uint8_t* data, size_t len)
+{
+  if (_finished || _type == DigestType::None)
+    return;
+
+  if (_type == DigestType::CRC32)
+  {
+    uint32_t crc = _state[0];
+    _count += len;
+
+    while (len--)
+    {
+      crc ^= *data++;
+      crc = (crc >> 4) ^ pgm_read_dword(&crcNibble[crc & 0x0F]);
+      crc = (crc >> 4) ^ pgm_read_dword(&crcNibble[crc & 0x0F]);
+    }
+
+    _state[0] = crc;
+
+    return;
+  }
+
+  size_t used = _count % 64;
+  _count += len;
+
+  while (len)
+  {
+    size_t chunk = 64 - used < len ? 64 - used : len;
+    memcpy(_block + used, data, chunk);
+    used += chunk;
+    data += chunk;
+    len  -= chunk;
+
+    if (used == 64)
+    {
+      if (_type == DigestType::MD5)
+        md5Transform(_block);
+      else
+        sha256Transform(_block);
+
+      used = 0;
+    }
+  }
+}
+
+//*******************************************************************************************************************
+void xdigest::finish()
+{
+  if (_finished)
+    return;
+
+  switch (_type)
+  {
+  case DigestType::CRC32:
+    {
+      uint32_t crc = ~_state[0];
+
+      for (int i = 0; i < 4; i++)
+        _digest[i] = crc >> (24 - 8 * i);
+    }
+    break;
+
+  case DigestType::MD5:
+    pad(false);
+
+    for (int i = 0; i < 16; i++)
+      _digest[i] = _state[i / 4] >> (8 * (i % 4));
+    break;
+
+  case DigestType::SHA256:
+    pad(true);
+
+    for (int i = 0; i < 32; i++)
+      _digest[i] = _state[i / 4] >> (24 - 8 * (i % 4));
+    break;
+
+  case DigestType::None:
+    break;
+  }
+
+  _finished = true;
+}
+
+//*******************************************************************************************************************
+size_t xdigest::length() const
+{
+  switch (_type)
+  {
+  case DigestType::CRC32:   return 4;
+  case DigestType::MD5:     return 16;
+  case DigestType::SHA256:  return 32;
+  case DigestType::None:    break;
+  }
+
+  return 0;
+}
+
+//*******************************************************************************************************************
+String xdigest::hex() const
+{
+  static const char digits[] = "0123456789abcdef";
+  String result;
+  result.reserve(length() * 2);
+
+  for (size_t i = 0; i < length(); i++)
+  {
+    result += digits[_digest[i] >> 4];
+    result += digits[_digest[i] & 0x0F];
+  }
+
+  return result;
+}
+
+//*******************************************************************************************************************
+String xdigest::base64() const
+{
+  static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  String result;
+  size_t len = length();
+  result.reserve((len + 2) / 3 * 4);
+
+  for (size_t i = 0; i < len; i += 3)
+  {
+    uint32_t triple = (uint32_t) _digest[i] << 16;
+
+    if (i + 1 < len)
+      triple |= (uint32_t) _digest[i + 1] << 8;
+
+    if (i + 2 < len)
+      triple |= _digest[i + 2];
+
+    result += alphabet[(triple >> 18) & 0x3F];
+    result += alphabet[(triple >> 12) & 0x3F];
+    result += i + 1 < len ? alphabet[(triple >> 6) & 0x3F] : '=';
+    result += i + 2 < len ? alphabet[triple & 0x3F] : '=';
+  }
+
+  return result;
+}
+
+//*******************************************************************************************************************
+bool xdigest::matches(const String& expected) const
+{
+  if ( ! _finished || _type == DigestType::None)
+    return false;
+
+  if (expected.length() == length() * 2)
+    return expected.equalsIgnoreCase(hex());
+
+  return expected == base64();
+}
+
+//*******************************************************************************************************************
+void xdigest::pad(bool bigEndian)
+{
+  uint64_t bits = _count * 8;
+  uint8_t  length[8];
+
+  for (int i = 0; i < 8; i++)
+    length[i] = bigEndian ? bits >> (56 - 8 * i) : bits >> (8 * i);
+
+  static const uint8_t padding[64] = { 0x80 };
+  size_t used = _count % 64;
+  size_t padLen = used < 56 ? 56 - used : 120 - used;
+
+  update(padding, padLen);
+  update(length, 8);
+}
+
+//*******************************************************************************************************************
+void xdigest::md5Transform(const uint8_t* block)
+{
+  uint32_t m[16];
+
+  for (int i = 0; i < 16; i++)
+  {
+    m[i] = (uint32_t) block[i * 4] | ((uint32_t) block[i * 4 + 1] << 8) |
+           ((uint32_t) block[i * 4 + 2] << 16) | ((uint32_t) block[i * 4 + 3] << 24);
+  }
+
+  uint32_t a = _state[0];
+  uint32_t b = _state[1];
+  uint32_t c = _state[2];
+  uint32_t d = _state[3];
+
+  for (int i = 0; i < 64; i++)
+  {
+    uint32_t f;
+    int      g;
+
+    if (i < 16)
+    {
+      f = (b & c) | (~b & d);
+      g = i;
+    }
+    else if (i < 32)
+    {
+      f = (d & b) | (~d & c);
+      g = (5 * i + 1) % 16;
+    }
+    else if (i < 48)
+    {
+      f = b ^ c ^ d;
+      g = (3 * i + 5) % 16;
+    }
+    else
+    {
+      f = c ^ (b | ~d);
+      g = (7 * i) % 16;
+    }
+
+    uint32_t temp = d;
+    d = c;
+    c = b;
+    b = b + rotl(a + f + pgm_read_dword(&md5K[i]) + m[g], pgm_read_byte(&md5R[(i / 16) * 4 + i % 4]));
+    a = temp;
+  }
+
+  _state[0] += a;
+  _state[1] += b;
+  _state[2] += c;
+  _state[3] += d;
+}
+
+//*******************************************************************************************************************
+void xdigest::sha256Transform(const uint8_t* block)
+{
+  uint32_t w[64];
+
+  for (int i = 0; i < 16; i++)
+  {
+    w[i] = ((uint32_t) block[i * 4] << 24) | ((uint32_t) block[i * 4 + 1] << 16) |
+           ((uint32_t) block[i * 4 + 2] << 8) | (uint32_t) block[i * 4 + 3];
+  }
+
+  for (int i = 16; i < 64; i++)
+  {
+    uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  uint32_t a = _state[0];
+  uint32_t b = _state[1];
+  uint32_t c = _state[2];
+  uint32_t d = _state[3];
+  uint32_t e = _state[4];
+  uint32_t f = _state[5];
+  uint32_t g = _state[6];
+  uint32_t h = _state[7];
+
+  for (int i = 0; i < 64; i++)
+  {
+    uint32_t S1    = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+    uint32_t ch    = (e & f) ^ (~e & g);
+    uint32_t temp1 = h + S1 + ch + pgm_read_dword(&sha256K[i]) + w[i];
+    uint32_t S0    = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+    uint32_t maj   = (a & b) ^ (a & c) ^ (b & c);
+    uint32_t temp2 = S0 + maj;
+
+    h = g;
+    g = f;
+    f = e;
+    e = d + temp1;
+    d = c;
+    c = b;
+    b = a;
+    a = temp1 + temp2;
+  }
+
+  _state[0] += a;
+  _state[1] += b;
+  _state[2] += c;
+  _state[3] += d;
+  _state[4] += e;
+  _state[5] += f;
+  _state[6] += g;
+  _state[7] += h;
+}
@@ -0,0 +1,84 @@
+/****************************************************************************************************************************
+  xdigest.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  Version: 1.0.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+
+/********************************************************************************************
+  xdigest is an incremental message digest (CRC32, MD5 or SHA-256) that is fed with
+  data as it streams past, so a response body can be verified without buffering it
+  or making a second pass over it.
+  The context is a fixed 100 or so bytes regardless of the amount of data hashed.
+  Call begin(), update() any number of times, then finish(). The digest can then be
+  retrieved as raw bytes, lower case hex or base64 (the form used by Content-MD5).
+********************************************************************************************/
+#pragma once
+
+#ifndef xdigest_h
+#define xdigest_h
+
+#include <Arduino.h>
+
+enum class DigestType
+{
+  None,
+  CRC32,
+  MD5,
+  SHA256
+};
+
+class xdigest
+{
+  public:
+
+    xdigest(const DigestType type = DigestType::None);
+
+    void            begin(const DigestType type);
+    void            update(const uint8_t* data, size_t len);
+    void            finish();
+
+    DigestType      type() const      { return _type; }
+    bool            finished() const  { return _finished; }
+    size_t          length() const;
+    const uint8_t*  digest() const    { return _digest; }
+    String          hex() const;
+    String          base64() const;
+
+    // Compare against an expected value given either as hex (any case) or base64
+    bool            matches(const String& expected) const;
+
+  protected:
+
+    DigestType  _type;
+    bool        _finished;
+    uint32_t    _state[8];
+    uint64_t    _count;
+    uint8_t     _block[64];
+    uint8_t     _digest[32];
+
+    void        md5Transform(const uint8_t* block);
+    void        sha256Transform(const uint8_t* block);
+    void        pad(bool bigEndian);
+};
+
+#endif    // xdigest_h
@@ -0,0 +1,444 @@
+/****************************************************************************************************************************
+  xjson.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  Version: 1.0.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+
+#include "utility/xjson.h"
+
+xjson::xjson(const uint8_t maxDepth, const uint16_t maxValue) : _maxDepth(maxDepth), _maxValue(maxValue)
+{
+  _stack = new frame[maxDepth];
+}
+
+//*******************************************************************************************************************
+xjson::~xjson()
+{
+  delete[] _stack;
+  delete _watched;
+}
+
+//*******************************************************************************************************************
+void xjson::onValue(valueCB cb, void* arg)
+{
+  _valueCB = cb;
+  _valueCBarg = arg;
+}
+
+//*******************************************************************************************************************
+void xjson::watch(const char* pointer)
+{
+  watched* w = (watched*) &_watched;
+
+  while (w->next)
+    w = w->next;
+
+  w->next = new watched;
+  w->next->pointer = pointer;
+}
+
+//*******************************************************************************************************************
+bool xjson::found(const char* pointer) const
+{
+  for (watched* w = _watched; w; w = w->next)
+  {
+    if (w->pointer == pointer)
+      return w->found;
+  }
+
+  return false;
+}
+
+//*******************************************************************************************************************
+String xjson::value(const char* pointer) const
+{
+  for (watched* w = _watched; w; w = w->next)
+  {
+    if (w->pointer == pointer)
+      return w->value;
+  }
+
+  return String();
+}
+
+//*******************************************************************************************************************
+void xjson::reset()
+{
+  _state      = State::Value;
+  _depth      = 0;
+  _escape     = 0;
+  _surrogate  = 0;
+  _path       = String();
+  _key        = String();
+  _token      = String();
+
+  for (watched* w = _watched; w; w = w->next)
+  {
+    w->found = false;
+    w->value = String();
+  }
+}
+
+//*******************************************************************************************************************
+size_t xjson::parse(const uint8_t* data, size_t len)
+{
+  size_t used = 0;
+
+  while (used < len && _state != State::Error)
+  {
+    if ( ! _char(data[used++]))
+      _state = State::Error;
+  }
+
+  return used;
+}
+
+//*******************************************************************************************************************
+bool xjson::_char(char c)
+{
+  switch (_state)
+  {
+  case State::String:
+    return _stringChar(c, _token);
+
+  case State::KeyString:
+    return _stringChar(c, _key);
+
+  case State::Literal:
+    if (isalnum(c) || c == '-' || c == '+' || c == '.')
+    {
+      if (_token.length() < _maxValue)
+        _token += c;
+
+      return true;
+    }
+
+    if (_token == "true" || _token == "false")
+      _emit(JsonType::Bool);
+    else if (_token == "null")
+      _emit(JsonType::Null);
+    else if (_token[0] == '-' || isdigit(_token[0]))
+      _emit(JsonType::Number);
+    else
+      return false;
+
+    _endValue();
+
+    // The delimiter that ended the literal still has to be handled
+    return _state == State::Done ? isspace(c) : _char(c);
+
+  default:
+    break;
+  }
+
+  if (isspace(c))
+    return true;
+
+  switch (_state)
+  {
+  case State::Value:
+    return _beginValue(c);
+
+  case State::AfterValue:
+    if (c == ',')
+    {
+      frame& top = _stack[_depth - 1];
+
+      top.index++;
+      _state = top.array ? State::Value : State::Key;
+
+      return true;
+    }
+
+    if (c == '}')
+      return _pop(false);
+
+    if (c == ']')
+      return _pop(true);
+
+    return false;
+
+  case State::Key:
+    if (c == '"')
+    {
+      _key = String();
+      _state = State::KeyString;
+
+      return true;
+    }
+
+    // "{}", a '}' after a ',' would be a trailing comma
+    return c == '}' && _stack[_depth - 1].index == 0 && _pop(false);
+
+  case State::Colon:
+    if (c != ':')
+      return false;
+
+    _state = State::Value;
+
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+//*******************************************************************************************************************
+bool xjson::_beginValue(char c)
+{
+  if (c == '{')
+    return _push(false);
+
+  if (c == '[')
+    return _push(true);
+
+  if (c == '"')
+  {
+    _token = String();
+    _state = State::String;
+
+    return true;
+  }
+
+  // "[]", the only place a ']' can stand where a value is expected
+  if (c == ']' && _depth && _stack[_depth - 1].array && _stack[_depth - 1].index == 0)
+    return _pop(true);
+
+  if (c == '-' || isdigit(c) || c == 't' || c == 'f' || c == 'n')
+  {
+    _token = String(c);
+    _state = State::Literal;
+
+    return true;
+  }
+
+  return false;
+}
+
+//*******************************************************************************************************************
+bool xjson::_stringChar(char c, String& target)
+{
+  if (_escape == 1)
+  {
+    _escape = 0;
+
+    switch (c)
+    {
+    case '"':
+    case '\\':
+    case '/':
+      break;
+
+    case 'b': c = '\b'; break;
+    case 'f': c = '\f'; break;
+    case 'n': c = '\n'; break;
+    case 'r': c = '\r'; break;
+    case 't': c = '\t'; break;
+
+    case 'u':
+      _escape = 2;
+      _unicode = 0;
+      return true;
+
+    default:
+      return false;
+    }
+  }
+  else if (_escape)
+  {
+    if ( ! isxdigit(c))
+      return false;
+
+    _unicode = (_unicode << 4) | (isdigit(c) ? c - '0' : (tolower(c) - 'a' + 10));
+
+    if (++_escape < 6)
+      return true;
+
+    _escape = 0;
+
+    if (_unicode >= 0xD800 && _unicode < 0xDC00)
+    {
+      _surrogate = _unicode;
+    }
+    else if (_unicode >= 0xDC00 && _unicode < 0xE000 && _surrogate)
+    {
+      _append(target, 0x10000 + (((uint32_t) _surrogate - 0xD800) << 10) + (_unicode - 0xDC00));
+      _surrogate = 0;
+    }
+    else
+    {
+      _append(target, _unicode);
+    }
+
+    return true;
+  }
+  else if (c == '\\')
+  {
+    _escape = 1;
+
+    return true;
+  }
+  else if (c == '"')
+  {
+    if (&target == &_key)
+    {
+      _state = State::Colon;
+    }
+    else
+    {
+      _emit(JsonType::String);
+      _endValue();
+    }
+
+    return true;
+  }
+  else if ((uint8_t) c < 0x20)
+  {
+    return false;
+  }
+
+  if (target.length() < _maxValue)
+    target += c;
+
+  return true;
+}
+
+//*******************************************************************************************************************
+void xjson::_append(String& target, uint32_t codepoint)
+{
+  char    utf8[4];
+  uint8_t len;
+
+  if (codepoint < 0x80)
+  {
+    utf8[0] = codepoint;
+    len = 1;
+  }
+  else if (codepoint < 0x800)
+  {
+    utf8[0] = 0xC0 | (codepoint >> 6);
+    utf8[1] = 0x80 | (codepoint & 0x3F);
+    len = 2;
+  }
+  else if (codepoint < 0x10000)
+  {
+    utf8[0] = 0xE0 | (codepoint >> 12);
+    utf8[1] = 0x80 | ((codepoint >> 6) & 0x3F);
+    utf8[2] = 0x80 | (codepoint & 0x3F);
+    len = 3;
+  }
+  else
+  {
+    utf8[0] = 0xF0 | (codepoint >> 18);
+    utf8[1] = 0x80 | ((codepoint >> 12) & 0x3F);
+    utf8[2] = 0x80 | ((codepoint >> 6) & 0x3F);
+    utf8[3] = 0x80 | (codepoint & 0x3F);
+    len = 4;
+  }
+
+  if (target.length() + len <= _maxValue)
+    target.concat(utf8, len);
+}
+
+//*******************************************************************************************************************
+bool xjson::_push(bool array)
+{
+  if (_depth >= _maxDepth)
+    return false;
+
+  String path = _depth ? _path + '/' + _segment() : String();
+
+  frame& top  = _stack[_depth++];
+  top.array   = array;
+  top.index   = 0;
+  top.pathLen = _path.length();
+
+  _path  = path;
+  _state = array ? State::Value : State::Key;
+
+  return true;
+}
+
+//*******************************************************************************************************************
+bool xjson::_pop(bool array)
+{
+  if ( ! _depth || _stack[_depth - 1].array != array)
+    return false;
+
+  _path = _path.substring(0, _stack[--_depth].pathLen);
+  _endValue();
+
+  return true;
+}
+
+//*******************************************************************************************************************
+void xjson::_endValue()
+{
+  _state = _depth ? State::AfterValue : State::Done;
+}
+
+//*******************************************************************************************************************
+void xjson::_emit(JsonType type)
+{
+  if ( ! _watched && ! _valueCB)
+    return;
+
+  String pointer = _depth ? _path + '/' + _segment() : String();
+
+  for (watched* w = _watched; w; w = w->next)
+  {
+    if (w->pointer == pointer)
+    {
+      w->value = _token;
+      w->found = true;
+    }
+  }
+
+  if (_valueCB)
+    _valueCB(_valueCBarg, pointer, type, _token);
+}
+
+//*******************************************************************************************************************
+String xjson::_segment() const
+{
+  const frame& top = _stack[_depth - 1];
+
+  if (top.array)
+    return String(top.index);
+
+  // JSON pointer escaping: '~' -> "~0", '/' -> "~1"
+  String segment;
+  segment.reserve(_key.length());
+
+  for (unsigned i = 0; i < _key.length(); i++)
+  {
+    if (_key[i] == '~')
+      segment += "~0";
+    else if (_key[i] == '/')
+      segment += "~1";
+    else
+      segment += _key[i];
+  }
+
+  return segment;
+}
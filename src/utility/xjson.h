@@ -0,0 +1,137 @@
+/****************************************************************************************************************************
+  xjson.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  Version: 1.0.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+
+/********************************************************************************************
+  xjson is a streaming (SAX style) JSON tokenizer. Data is pushed in as it arrives, in
+  pieces of any size, and every scalar value is reported together with its location as a
+  JSON pointer (RFC 6901), e.g. "/sensors/2/temp".
+  Memory use depends only on the configured nesting depth and value length, never on the
+  size of the document, so a few fields can be pulled out of a large response without
+  holding the response in RAM.
+  Values can be delivered to a callback, or the pointers of interest registered with
+  watch() and read back with value() once parsed.
+  Strings and numbers longer than the maximum value length are truncated (parsing carries
+  on); documents nested deeper than the maximum depth put the parser in the error state.
+********************************************************************************************/
+#pragma once
+
+#ifndef xjson_h
+#define xjson_h
+
+#include <Arduino.h>
+#include <functional>
+
+enum class JsonType
+{
+  String,
+  Number,
+  Bool,
+  Null
+};
+
+class xjson
+{
+    using valueCB = std::function<void(void* arg, const String& pointer, JsonType type, const String& value)>;
+
+  public:
+
+    xjson(const uint8_t maxDepth = 8, const uint16_t maxValue = 64);
+    virtual ~xjson();
+
+    void        onValue(valueCB cb, void* arg = nullptr);   // Called for every scalar value
+    void        watch(const char* pointer);                 // Remember the value at this JSON pointer
+    bool        found(const char* pointer) const;
+    String      value(const char* pointer) const;
+
+    void        reset();                                    // Ready for a new document, watched values cleared
+    size_t      parse(const uint8_t* data, size_t len);     // Feed the next piece of the document
+    size_t      parse(const char* data)       { return parse((const uint8_t*) data, strlen(data)); }
+
+    bool        error() const     { return _state == State::Error; }
+    bool        complete() const  { return _state == State::Done; }
+
+  protected:
+
+    enum class State : uint8_t
+    {
+      Value,            // expecting a value
+      String,           // inside a string value
+      Literal,          // inside a number, true, false or null
+      AfterValue,       // expecting ',' or the end of the container
+      Key,              // expecting a key or the end of the object
+      KeyString,        // inside a key
+      Colon,            // expecting ':' after a key
+      Done,             // root value complete
+      Error
+    };
+
+    struct frame
+    {
+      bool      array;
+      uint16_t  index;
+      uint16_t  pathLen;
+    };
+
+    struct watched
+    {
+      watched*  next{};
+      String    pointer;
+      String    value;
+      bool      found{false};
+
+      ~watched()
+      {
+        delete next;
+      }
+    };
+
+    State       _state{State::Value};
+    frame*      _stack;
+    uint8_t     _maxDepth;
+    uint8_t     _depth{0};
+    uint16_t    _maxValue;
+    uint8_t     _escape{0};                 // 0 none, 1 after '\', 2..5 collecting \u hex digits
+    uint16_t    _unicode{0};
+    uint16_t    _surrogate{0};
+    String      _path;                      // pointer of the innermost open container
+    String      _key;                       // last key seen in the innermost object
+    String      _token;                     // value being collected
+    watched*    _watched{nullptr};
+    valueCB     _valueCB{};
+    void*       _valueCBarg{nullptr};
+
+    bool        _char(char c);
+    bool        _stringChar(char c, String& target);
+    void        _append(String& target, uint32_t codepoint);
+    bool        _beginValue(char c);
+    bool        _push(bool array);
+    bool        _pop(bool array);
+    void        _endValue();
+    void        _emit(JsonType type);
+    String      _segment() const;
+};
+
+#endif    // xjson_h
@@ -0,0 +1,184 @@
+/****************************************************************************************************************************
+  xsse.cpp - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  Version: 1.0.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+
+#include "utility/xsse.h"
+
+xsse::xsse(const uint16_t maxLength) : _maxLength(maxLength)
+{
+}
+
+//*******************************************************************************************************************
+void xsse::onEvent(eventCB cb, void* arg)
+{
+  _eventCB = cb;
+  _eventCBarg = arg;
+}
+
+//*******************************************************************************************************************
+void xsse::reset()
+{
+  resume();
+
+  _id     = String();
+  _lastId = String();
+  _retry  = 0;
+  _events = 0;
+}
+
+//*******************************************************************************************************************
+void xsse::resume()
+{
+  // Whatever the old connection left unfinished never happened, the id buffer goes back to the last whole event
+  _line     = String();
+  _event    = String();
+  _data     = String();
+  _id       = _lastId;
+  _cr       = false;
+  _first    = true;
+  _overflow = false;
+}
+
+//*******************************************************************************************************************
+size_t xsse::parse(const uint8_t* data, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    char c = data[i];
+
+    // CRLF is one line end, not two
+    if (_cr)
+    {
+      _cr = false;
+
+      if (c == '\n')
+        continue;
+    }
+
+    if (c == '\r' || c == '\n')
+    {
+      _cr = c == '\r';
+      _endLine();
+    }
+    else if (_line.length() < _maxLength)
+    {
+      _line += c;
+    }
+    else
+    {
+      _overflow = true;
+    }
+  }
+
+  return len;
+}
+
+//*******************************************************************************************************************
+void xsse::_endLine()
+{
+  if (_first && _line.startsWith("\xEF\xBB\xBF"))
+    _line.remove(0, 3);
+
+  _first = false;
+
+  // Empty line ends the event
+  if ( ! _line.length())
+  {
+    _dispatch();
+
+    return;
+  }
+
+  // ": ..." is a comment, servers send them to keep the connection alive
+  if (_line[0] == ':')
+  {
+    _line = String();
+
+    return;
+  }
+
+  // "field: value", the one space after the colon isn't part of the value; a line without a colon is a field alone
+  int colon = _line.indexOf(':');
+  String field = colon < 0 ? _line : _line.substring(0, colon);
+  String value;
+
+  if (colon >= 0)
+    value = _line.substring(_line[colon + 1] == ' ' ? colon + 2 : colon + 1);
+
+  _line = String();
+
+  if (field == "event")
+  {
+    _event = value;
+  }
+  else if (field == "data")
+  {
+    if (_data.length() + value.length() + 1 > _maxLength)
+    {
+      _overflow = true;
+    }
+    else
+    {
+      _data += value;
+      _data += '\n';
+    }
+  }
+  else if (field == "id")
+  {
+    _id = value;
+  }
+  else if (field == "retry")
+  {
+    bool digits = value.length() > 0;
+
+    for (unsigned i = 0; i < value.length(); i++)
+      digits = digits && value[i] >= '0' && value[i] <= '9';
+
+    if (digits)
+      _retry = value.toInt();
+  }
+
+  // Unknown fields are ignored
+}
+
+//*******************************************************************************************************************
+void xsse::_dispatch()
+{
+  _lastId = _id;
+
+  // An event without data, or one too long to keep, isn't delivered
+  if (_data.length() && ! _overflow)
+  {
+    _data.remove(_data.length() - 1);
+    _events++;
+
+    if (_eventCB)
+      _eventCB(_eventCBarg, _event.length() ? _event : String("message"), _data, _lastId);
+  }
+
+  _event    = String();
+  _data     = String();
+  _overflow = false;
+}
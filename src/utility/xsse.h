@@ -0,0 +1,83 @@
+/****************************************************************************************************************************
+  xsse.h - Dead simple AsyncHTTPRequest for ESP8266, ESP32 and currently STM32 with built-in LAN8742A Ethernet
+
+  For ESP8266, ESP32 and STM32 with built-in LAN8742A Ethernet (Nucleo-144, DISCOVERY, etc)
+
+  AsyncHTTPRequest_STM32 is a library for the ESP8266, ESP32 and currently STM32 run built-in Ethernet WebServer
+
+  Based on and modified from asyncHTTPrequest Library (https://github.com/boblemaire/asyncHTTPrequest)
+
+  Built by Khoi Hoang https://github.com/khoih-prog/AsyncHTTPRequest_Generic
+  Licensed under MIT license
+
+  Copyright (C) <2018>  <Bob Lemaire, IoTaWatt, Inc.>
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+  as published bythe Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  Version: 1.0.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.0.0    K Hoang     14/09/2020 Initial coding to add support to STM32 using built-in Ethernet (Nucleo-144, DISCOVERY, etc).
+ *****************************************************************************************************************************/
+
+/********************************************************************************************
+  xsse is a streaming parser for Server-Sent Events (text/event-stream). The response body
+  is pushed in as it arrives, in pieces of any size, and every complete event is handed to
+  a callback with its type, data and id.
+  Lines may end in CR, LF or CRLF, comment lines (usually keep-alives) are skipped, and the
+  last event id and server requested reconnection time are kept across connections so a
+  dropped stream can be resumed with Last-Event-ID.
+  Memory use is bounded by the maximum length: longer lines or events are dropped whole,
+  parsing carries on with the next event.
+********************************************************************************************/
+#pragma once
+
+#ifndef xsse_h
+#define xsse_h
+
+#include <Arduino.h>
+#include <functional>
+
+class xsse
+{
+    using eventCB = std::function<void(void* arg, const String& event, const String& data, const String& id)>;
+
+  public:
+
+    xsse(const uint16_t maxLength = 1024);
+
+    void          onEvent(eventCB cb, void* arg = nullptr);   // Called for every complete event
+    void          reset();                                    // New stream, last event id and retry forgotten
+    void          resume();                                   // Same stream on a new connection, partial event dropped
+    size_t        parse(const uint8_t* data, size_t len);     // Feed the next piece of the stream
+    size_t        parse(const char* data)   { return parse((const uint8_t*) data, strlen(data)); }
+
+    const String& lastEventId() const       { return _lastId; }
+    uint32_t      retry() const             { return _retry; }    // Reconnection time asked for (ms), 0 if none
+    uint32_t      events() const            { return _events; }   // Events dispatched since reset()
+
+  protected:
+
+    uint16_t    _maxLength;
+    String      _line;                      // line being collected
+    String      _event;                     // event type of the event being collected
+    String      _data;                      // its data lines, each ending in '\n'
+    String      _id;                        // id buffer, becomes the last event id when the event ends
+    String      _lastId;
+    uint32_t    _retry{0};
+    uint32_t    _events{0};
+    bool        _cr{false};                 // last character was CR, a following LF belongs to it
+    bool        _first{true};               // first line of the stream, may start with a BOM
+    bool        _overflow{false};           // line or event too long, dropped at its end
+    eventCB     _eventCB{};
+    void*       _eventCBarg{nullptr};
+
+    void        _endLine();
+    void        _dispatch();
+};
+
+#endif    // xsse_h
@@ -0,0 +1,350 @@
+#include "FakeClient.h"
+
+#include <map>
+#include <set>
+#include <Ticker.h>
+#include <lwip/dns.h>
+
+HardwareSerial Serial;
+
+namespace
+{
+  struct state
+  {
+    AcConnectHandler  onConnect, onDisconnect, onPoll;
+    AcAckHandler      onAck;
+    AcErrorHandler    onError;
+    AcDataHandler     onData;
+    void*             connectArg{}, *disconnectArg{}, *pollArg{}, *ackArg{}, *errorArg{}, *dataArg{};
+    bool              connecting{false};
+    bool              connected{false};
+    std::string       host;
+    uint16_t          port{0};
+    std::string       sent;
+  };
+
+  unsigned long                       now = 1000;
+  std::vector<AsyncClient*>           clients;
+  std::map<const AsyncClient*, state> states;
+  std::set<Ticker*>                   tickers;
+  std::string                         deletedSent;
+
+  dns_found_callback                  lookupCB{nullptr};
+  void*                               lookupArg{nullptr};
+  std::string                         lookupName;
+
+  state& of(const AsyncClient* client)
+  {
+    return states[client];
+  }
+}
+
+//**************************************************************************************************************
+// Arduino core
+
+unsigned long millis()                { return now; }
+long random(long max)                 { return max > 0 ? rand() % max : 0; }
+long random(long min, long max)       { return min + random(max - min); }
+void delay(unsigned long ms)          { now += ms; }
+
+//**************************************************************************************************************
+// AsyncClient
+
+AsyncClient::AsyncClient()
+{
+  clients.push_back(this);
+  states[this];
+}
+
+AsyncClient::~AsyncClient()
+{
+  for (auto it = clients.begin(); it != clients.end(); ++it)
+  {
+    if (*it == this)
+    {
+      clients.erase(it);
+      break;
+    }
+  }
+
+  deletedSent = states[this].sent;
+  states.erase(this);
+}
+
+bool AsyncClient::connect(IPAddress ip, uint16_t port)
+{
+  return connect(ip.toString().c_str(), port);
+}
+
+bool AsyncClient::connect(const char* host, uint16_t port)
+{
+  state& s = of(this);
+
+  s.host        = host;
+  s.port        = port;
+  s.connecting  = true;
+
+  return true;
+}
+
+void AsyncClient::close(bool)
+{
+  state& s = of(this);
+
+  if ( ! s.connected && ! s.connecting)
+    return;
+
+  s.connected = s.connecting = false;
+
+  // Last thing: the handler may delete the client
+  if (s.onDisconnect)
+    s.onDisconnect(s.disconnectArg, this);
+}
+
+int8_t    AsyncClient::abort()                  { close(true); return 0; }
+bool      AsyncClient::canSend()                { return of(this).connected; }
+size_t    AsyncClient::space()                  { return of(this).connected ? 5744 : 0; }
+bool      AsyncClient::send()                   { return of(this).connected; }
+size_t    AsyncClient::write(const char* data)  { return write(data, strlen(data)); }
+bool      AsyncClient::connected()              { return of(this).connected; }
+bool      AsyncClient::connecting()             { return of(this).connecting; }
+bool      AsyncClient::disconnected()           { return ! connected() && ! connecting(); }
+IPAddress AsyncClient::remoteIP()               { IPAddress ip; ip.fromString(of(this).host.c_str()); return ip; }
+uint16_t  AsyncClient::remotePort()             { return of(this).port; }
+void      AsyncClient::setRxTimeout(uint32_t)   {}
+void      AsyncClient::setAckTimeout(uint32_t)  {}
+void      AsyncClient::setNoDelay(bool)         {}
+void      AsyncClient::ackLater()               {}
+size_t    AsyncClient::ack(size_t len)          { return len; }
+
+size_t AsyncClient::add(const char* data, size_t size, uint8_t)
+{
+  if ( ! of(this).connected)
+    return 0;
+
+  of(this).sent.append(data, size);
+
+  return size;
+}
+
+size_t AsyncClient::write(const char* data, size_t size, uint8_t apiflags)
+{
+  size_t added = add(data, size, apiflags);
+  send();
+
+  return added;
+}
+
+void AsyncClient::onConnect(AcConnectHandler cb, void* arg)     { of(this).onConnect = cb;    of(this).connectArg = arg; }
+void AsyncClient::onDisconnect(AcConnectHandler cb, void* arg)  { of(this).onDisconnect = cb; of(this).disconnectArg = arg; }
+void AsyncClient::onAck(AcAckHandler cb, void* arg)             { of(this).onAck = cb;        of(this).ackArg = arg; }
+void AsyncClient::onError(AcErrorHandler cb, void* arg)         { of(this).onError = cb;      of(this).errorArg = arg; }
+void AsyncClient::onData(AcDataHandler cb, void* arg)           { of(this).onData = cb;       of(this).dataArg = arg; }
+void AsyncClient::onPoll(AcConnectHandler cb, void* arg)        { of(this).onPoll = cb;       of(this).pollArg = arg; }
+void AsyncClient::onTimeout(AcTimeoutHandler, void*)            {}
+
+//**************************************************************************************************************
+// Ticker
+
+void Ticker::detach()
+{
+  _active = false;
+  tickers.erase(this);
+}
+
+void Ticker::_arm(uint32_t ms, uint32_t period, std::function<void()> fn)
+{
+  _active = true;
+  _due    = now + ms;
+  _period = period;
+  _fn     = fn;
+
+  tickers.insert(this);
+}
+
+//**************************************************************************************************************
+// lwIP resolver
+
+err_t dns_gethostbyname(const char* hostname, ip_addr_t*, dns_found_callback found, void* callback_arg)
+{
+  lookupCB   = found;
+  lookupArg  = callback_arg;
+  lookupName = hostname;
+
+  return ERR_INPROGRESS;
+}
+
+//**************************************************************************************************************
+// Driving it all from the test
+
+std::vector<AsyncClient*>& fakeClients()          { return clients; }
+AsyncClient*  fakeLast()                          { return clients.empty() ? nullptr : clients.back(); }
+bool          fakeConnecting(AsyncClient* client) { return of(client).connecting; }
+bool          fakeConnected(AsyncClient* client)  { return of(client).connected; }
+uint16_t      fakePort(AsyncClient* client)       { return of(client).port; }
+std::string   fakeHost(AsyncClient* client)       { return of(client).host; }
+unsigned long fakeNow()                           { return now; }
+std::string   fakeLookup()                        { return lookupCB ? lookupName : std::string(); }
+
+void fakeAccept(AsyncClient* client)
+{
+  state& s = of(client);
+
+  if ( ! s.connecting)
+    return;
+
+  s.connecting  = false;
+  s.connected   = true;
+
+  if (s.onConnect)
+    s.onConnect(s.connectArg, client);
+}
+
+void fakeRefuse(AsyncClient* client)
+{
+  state& s = of(client);
+
+  if ( ! s.connecting)
+    return;
+
+  if (s.onError)
+    s.onError(s.errorArg, client, -14);
+
+  client->close();
+}
+
+std::string fakeSent(AsyncClient* client)
+{
+  std::string sent;
+
+  sent.swap(of(client).sent);
+
+  // Everything written is acknowledged at once
+  if (sent.size() && of(client).onAck)
+    of(client).onAck(of(client).ackArg, client, sent.size(), 1);
+
+  return sent;
+}
+
+std::string fakeSentDeleted()
+{
+  std::string sent;
+
+  sent.swap(deletedSent);
+
+  return sent;
+}
+
+void fakeReply(AsyncClient* client, const std::string& data)
+{
+  state& s = of(client);
+
+  if ( ! s.connected || ! s.onData)
+    return;
+
+  std::string copy = data;
+  s.onData(s.dataArg, client, &copy[0], copy.size());
+}
+
+void fakeDrop(AsyncClient* client)
+{
+  client->close();
+}
+
+void fakeError(AsyncClient* client, int8_t error)
+{
+  state& s = of(client);
+
+  if ( ! s.connected && ! s.connecting)
+    return;
+
+  // As AsyncTCP does: the error first, then the disconnect
+  if (s.onError)
+    s.onError(s.errorArg, client, error);
+
+  client->close();
+}
+
+void fakeTimers()
+{
+  // A ticker may arm or detach others, start over after each one fired
+  for (bool fired = true; fired; )
+  {
+    fired = false;
+
+    for (Ticker* t : tickers)
+    {
+      if ( ! t->_active || (long) (now - t->_due) < 0)
+        continue;
+
+      std::function<void()> fn = t->_fn;
+
+      if (t->_period)
+        t->_due += t->_period;
+      else
+        t->detach();
+
+      fn();
+      fired = true;
+
+      break;
+    }
+  }
+}
+
+void fakeAdvance(unsigned long ms)
+{
+  // In steps, the way the TCP stack polls every half second or so
+  while (ms)
+  {
+    unsigned long step = ms < 100 ? ms : 100;
+
+    now += step;
+    ms  -= step;
+
+    std::vector<AsyncClient*> polled = clients;
+
+    for (AsyncClient* client : polled)
+    {
+      auto it = states.find(client);
+
+      if (it != states.end() && it->second.connected && it->second.onPoll)
+        it->second.onPoll(it->second.pollArg, client);
+    }
+
+    fakeTimers();
+  }
+}
+
+void fakeResolve(const char* name, const IPAddress& ip)
+{
+  if ( ! lookupCB || lookupName != name)
+    return;
+
+  dns_found_callback cb  = lookupCB;
+  void*              arg = lookupArg;
+  ip_addr_t          addr{};
+
+  lookupCB = nullptr;
+  addr.type = IPADDR_TYPE_V4;
+  addr.u_addr.ip4.addr = (uint32_t) ip;
+
+  cb(name, (uint32_t) ip ? &addr : nullptr, arg);
+}
+
+void fakeResolve6(const char* name)
+{
+  if ( ! lookupCB || lookupName != name)
+    return;
+
+  dns_found_callback cb  = lookupCB;
+  void*              arg = lookupArg;
+  ip_addr_t          addr{};
+
+  lookupCB = nullptr;
+  addr.type = IPADDR_TYPE_V6;
+  addr.u_addr.ip6.addr[0] = 0x20010db8;
+  addr.u_addr.ip6.addr[3] = 1;
+
+  cb(name, &addr, arg);
+}
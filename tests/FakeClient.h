@@ -0,0 +1,35 @@
+// The network and the clock for host tests.
+// Every AsyncClient the library creates is recorded here. A test plays the server: it completes or refuses
+// the connect, reads what the client sent, pushes response bytes back and closes the connection whenever it
+// likes. Time only moves when the test says so, firing tickers and client polls on the way.
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ESPAsyncTCP.h>
+#include <IPAddress.h>
+
+std::vector<AsyncClient*>& fakeClients();           // Live clients, oldest first
+AsyncClient*  fakeLast();                           // Newest live client, nullptr if none
+
+bool          fakeConnecting(AsyncClient* client);
+bool          fakeConnected(AsyncClient* client);
+uint16_t      fakePort(AsyncClient* client);
+std::string   fakeHost(AsyncClient* client);        // Name or address it connected to
+
+void          fakeAccept(AsyncClient* client);      // Complete the connect
+void          fakeRefuse(AsyncClient* client);      // Fail the connect
+std::string   fakeSent(AsyncClient* client);        // What the client wrote since the last call
+std::string   fakeSentDeleted();                    // ... and what the last client deleted wrote since, as it closed
+void          fakeReply(AsyncClient* client, const std::string& data);
+void          fakeDrop(AsyncClient* client);        // The server closes the connection
+void          fakeError(AsyncClient* client, int8_t error); // lwIP fails it (-14 ERR_RST, -13 ERR_ABRT), then closes it
+
+unsigned long fakeNow();
+void          fakeAdvance(unsigned long ms);        // Move the clock on, polling clients and firing tickers
+void          fakeTimers();                         // Fire the tickers that are due
+
+// Answer the lookup in flight for name; an address that isn't set fails it
+void          fakeResolve(const char* name, const IPAddress& ip);
+void          fakeResolve6(const char* name);       // Answer it with an IPv6 address
+std::string   fakeLookup();                         // Name of the lookup in flight, "" if none
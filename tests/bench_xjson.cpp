@@ -0,0 +1,132 @@
+// Pulling three fields out of a JSON response: streamed through xjson as it arrives, against buffering the
+// body, taking responseText() and parsing that String. Reports time per response and peak heap.
+#include "FakeClient.h"
+#include <AsyncHTTPRequest.h>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  size_t heapNow  = 0;
+  size_t heapPeak = 0;
+}
+
+// Every allocation counted, with its size kept in front of the block
+void* operator new(size_t size)
+{
+  size_t* p = (size_t*) malloc(size + sizeof(max_align_t));
+
+  if ( ! p)
+    throw std::bad_alloc();
+
+  *p = size;
+  heapNow += size;
+
+  if (heapNow > heapPeak)
+    heapPeak = heapNow;
+
+  return (char*) p + sizeof(max_align_t);
+}
+
+void  operator delete(void* ptr) noexcept
+{
+  if ( ! ptr)
+    return;
+
+  size_t* p = (size_t*) ((char*) ptr - sizeof(max_align_t));
+
+  heapNow -= *p;
+  free(p);
+}
+
+void* operator new[](size_t size)                 { return operator new(size); }
+void  operator delete[](void* ptr) noexcept       { operator delete(ptr); }
+void  operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+void  operator delete[](void* ptr, size_t) noexcept { operator delete(ptr); }
+
+namespace
+{
+  const char* fields[] = { "/meta/count", "/items/0/name", "/items/40/price" };
+
+  std::string document(size_t items)
+  {
+    std::string doc = "{\"meta\":{\"count\":" + std::to_string(items) + ",\"source\":\"bench\"},\"items\":[";
+
+    for (size_t i = 0; i < items; i++)
+      doc += std::string(i ? "," : "") + "{\"id\":" + std::to_string(i) + ",\"name\":\"item number " + std::to_string(i) +
+             "\",\"price\":" + std::to_string(i * 7 % 1000) + ".25,\"tags\":[\"a\",\"b\",\"c\"],\"stock\":true}";
+
+    return doc + "]}";
+  }
+
+  // One request over the fake network, the response in 1460 byte segments
+  void fetch(const std::string& response, bool stream, std::string& found)
+  {
+    AsyncHTTPRequest request;
+    xjson            json;
+
+    for (const char* field : fields)
+      json.watch(field);
+
+    if (stream)
+      request.setJsonParser(&json);
+
+    request.open(*parseURL("http://10.0.0.1/items"));
+    request.send();
+
+    AsyncClient* client = fakeLast();
+    fakeAccept(client);
+    fakeSent(client);
+
+    for (size_t at = 0; at < response.size(); at += 1460)
+      fakeReply(client, response.substr(at, 1460));
+
+    if ( ! stream)
+    {
+      String text = request.responseText();
+      json.parse((const uint8_t*) text.c_str(), text.length());
+    }
+
+    found.clear();
+
+    for (const char* field : fields)
+      found += std::string(json.value(field).c_str()) + " ";
+  }
+
+  void measure(const char* name, const std::string& body, bool stream)
+  {
+    const int   rounds = 50;
+    std::string found;
+    std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                           std::to_string(body.size()) + "\r\n\r\n" + body;
+
+    found.reserve(256);
+
+    heapPeak = heapNow;
+    size_t base = heapNow;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < rounds; i++)
+      fetch(response, stream, found);
+
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+
+    printf("  %-12s %9.1f us/response  peak heap %7zu bytes  -> %s\n", name, us, heapPeak - base, found.c_str());
+  }
+}
+
+int main()
+{
+  for (size_t items : { 50, 200, 500 })
+  {
+    std::string body = document(items);
+
+    printf("%zu byte document\n", body.size());
+    measure("xjson stream", body, true);
+    measure("full String", body, false);
+  }
+
+  return 0;
+}
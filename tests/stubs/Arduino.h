@@ -0,0 +1,47 @@
+// Host stand-in for the Arduino core: only what the library uses. Time is simulated, see FakeClient.h
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include "WString.h"
+#include "pgmspace.h"
+#include "IPAddress.h"
+
+#define HEX 16
+#define DEC 10
+
+unsigned long millis();
+long          random(long max);
+long          random(long min, long max);
+void          delay(unsigned long ms);
+
+class Print
+{
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t len)  { size_t n = 0; while (len--) n += write(*buf++); return n; }
+
+    size_t print(const String& s)   { return write((const uint8_t*) s.c_str(), s.length()); }
+    size_t print(const char* s)     { return write((const uint8_t*) s, strlen(s)); }
+    size_t print(char c)            { return write((uint8_t) c); }
+    size_t print(int v)             { return print(String(v)); }
+    size_t print(unsigned v)        { return print(String(v)); }
+    size_t print(long v)            { return print(String(v)); }
+    size_t print(unsigned long v)   { return print(String(v)); }
+    size_t print(double v)          { return print(String(std::to_string(v))); }
+    size_t println()                { return print("\r\n"); }
+
+    template<typename T> size_t println(const T& v)   { return print(v) + println(); }
+};
+
+// Debug output goes to stderr when _ASYNC_HTTP_LOGLEVEL_ is raised
+class HardwareSerial : public Print
+{
+  public:
+    size_t write(uint8_t c) override  { return fputc(c, stderr) == EOF ? 0 : 1; }
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,43 @@
+// Host stand-in for the Arduino file system, rooted in a directory of the host
+#pragma once
+#include "Arduino.h"
+#include <cstdio>
+#include <memory>
+#include <string>
+namespace fs {
+class File : public Print {
+public:
+  File() {}
+  File(FILE* f) : _f(f, [](FILE* p){ if (p) fclose(p); }) {}
+  size_t write(uint8_t c) override { return _f ? fwrite(&c, 1, 1, _f.get()) : 0; }
+  size_t write(const uint8_t* b, size_t n) override { return _f ? fwrite(b, 1, n, _f.get()) : 0; }
+  int available() { if (!_f) return 0; long p = ftell(_f.get()); fseek(_f.get(), 0, SEEK_END); long e = ftell(_f.get()); fseek(_f.get(), p, SEEK_SET); return e - p; }
+  int read() { uint8_t c; return read(&c, 1) == 1 ? c : -1; }
+  size_t read(uint8_t* b, size_t n) { return _f ? fread(b, 1, n, _f.get()) : 0; }
+  size_t readBytes(char* b, size_t n) { return read((uint8_t*)b, n); }
+  size_t size() const { return 0; }
+  void close() { _f.reset(); }
+  void flush() { if (_f) fflush(_f.get()); }
+  String readStringUntil(char t) { std::string s; int c; while ((c = read()) >= 0 && c != t) s += (char)c; return String(s.c_str()); }
+  explicit operator bool() const { return (bool)_f; }
+private:
+  std::shared_ptr<FILE> _f;
+};
+class FS {
+public:
+  FS(const char* root) : _root(root) {}
+  File open(const char* path, const char* mode = "r") { std::string m = mode; if (m == "w") m = "wb"; else if (m == "r") m = "rb"; return File(fopen((_root + path).c_str(), m.c_str())); }
+  File open(const String& path, const char* mode = "r") { return open(path.c_str(), mode); }
+  bool exists(const char* path) { FILE* f = fopen((_root + path).c_str(), "rb"); if (f) fclose(f); return f; }
+  bool exists(const String& path) { return exists(path.c_str()); }
+  bool remove(const char* path) { return ::remove((_root + path).c_str()) == 0; }
+  bool remove(const String& path) { return remove(path.c_str()); }
+  bool rename(const char* a, const char* b) { return ::rename((_root + a).c_str(), (_root + b).c_str()) == 0; }
+  bool rename(const String& a, const String& b) { return rename(a.c_str(), b.c_str()); }
+  bool mkdir(const char* p) { return ::system(("mkdir -p " + _root + p).c_str()) == 0; }
+  bool mkdir(const String& p) { return mkdir(p.c_str()); }
+private:
+  std::string _root;
+};
+}
+using fs::FS; using fs::File;
@@ -0,0 +1,42 @@
+// Host stand-in for the Arduino IPAddress
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include "WString.h"
+
+class IPAddress
+{
+  public:
+    IPAddress() {}
+    IPAddress(uint32_t a)                                 { _b[0] = a; _b[1] = a >> 8; _b[2] = a >> 16; _b[3] = a >> 24; }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { _b[0] = a; _b[1] = b; _b[2] = c; _b[3] = d; }
+
+    operator uint32_t() const         { return _b[0] | (_b[1] << 8) | (_b[2] << 16) | ((uint32_t) _b[3] << 24); }
+    uint8_t operator[](int i) const   { return _b[i]; }
+
+    bool fromString(const char* s)
+    {
+      unsigned a, b, c, d;
+      char     x;
+
+      if (sscanf(s, "%u.%u.%u.%u%c", &a, &b, &c, &d, &x) != 4 || a > 255 || b > 255 || c > 255 || d > 255)
+        return false;
+
+      _b[0] = a; _b[1] = b; _b[2] = c; _b[3] = d;
+
+      return true;
+    }
+
+    bool fromString(const String& s)  { return fromString(s.c_str()); }
+
+    String toString() const
+    {
+      char buf[16];
+      snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _b[0], _b[1], _b[2], _b[3]);
+
+      return String(buf);
+    }
+
+  private:
+    uint8_t _b[4]{};
+};
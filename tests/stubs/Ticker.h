@@ -0,0 +1,31 @@
+// Host stand-in for the ESP Ticker, fired by fakeTimers() against the simulated clock
+#pragma once
+#include <cstdint>
+#include <functional>
+
+class Ticker
+{
+  public:
+    typedef void (*callback_t)(void);
+
+    ~Ticker()                                                             { detach(); }
+
+    void attach_ms(uint32_t ms, callback_t cb)                            { _arm(ms, ms, [cb] { cb(); }); }
+    void once_ms(uint32_t ms, callback_t cb)                              { _arm(ms, 0, [cb] { cb(); }); }
+
+    template<typename T> void attach_ms(uint32_t ms, void (*cb)(T), T arg) { _arm(ms, ms, [cb, arg] { cb(arg); }); }
+    template<typename T> void once_ms(uint32_t ms, void (*cb)(T), T arg)   { _arm(ms, 0, [cb, arg] { cb(arg); }); }
+
+    void detach();
+    bool active() const                                                   { return _active; }
+
+  private:
+    friend void fakeTimers();
+
+    bool                  _active{false};
+    unsigned long         _due{0};
+    uint32_t              _period{0};
+    std::function<void()> _fn;
+
+    void _arm(uint32_t ms, uint32_t period, std::function<void()> fn);
+};
@@ -0,0 +1,71 @@
+// Host stand-in for the Arduino String, backed by std::string
+#pragma once
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+class __FlashStringHelper;
+class String {
+public:
+  std::string s;
+  String() {}
+  String(const char* c) : s(c ? c : "") {}
+  String(const std::string& x) : s(x) {}
+  String(char c) : s(1, c) {}
+  String(int v) : s(std::to_string(v)) {}
+  String(unsigned v) : s(std::to_string(v)) {}
+  String(long v) : s(std::to_string(v)) {}
+  String(unsigned long v) : s(std::to_string(v)) {}
+  String(unsigned long v, unsigned char base) { char b[40]; char* e = b + 39; *e = 0; do { *--e = "0123456789abcdef"[v % base]; v /= base; } while (v); s = e; }
+  String(unsigned v, unsigned char base) : String((unsigned long) v, base) {}
+  String(const __FlashStringHelper* f) : s((const char*)f) {}
+  unsigned length() const { return s.size(); }
+  const char* c_str() const { return s.c_str(); }
+  bool reserve(unsigned n) { s.reserve(n); return true; }
+  String substring(unsigned b) const { return b >= s.size() ? String() : String(s.substr(b)); }
+  String substring(unsigned b, unsigned e) const { if (b > e) std::swap(b, e); if (b >= s.size()) return String(); return String(s.substr(b, e - b)); }
+  int indexOf(char c, unsigned from = 0) const { auto p = s.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+  int indexOf(const String& c, unsigned from = 0) const { auto p = s.find(c.s, from); return p == std::string::npos ? -1 : (int)p; }
+  int indexOf(const char* c, unsigned from = 0) const { auto p = s.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+  int lastIndexOf(char c) const { auto p = s.rfind(c); return p == std::string::npos ? -1 : (int)p; }
+  bool equalsIgnoreCase(const String& o) const { if (o.s.size() != s.size()) return false; for (size_t i = 0; i < s.size(); i++) if (tolower(s[i]) != tolower(o.s[i])) return false; return true; }
+  bool equals(const String& o) const { return s == o.s; }
+  bool startsWith(const String& o) const { return s.compare(0, o.s.size(), o.s) == 0; }
+  bool endsWith(const String& o) const { return s.size() >= o.s.size() && s.compare(s.size() - o.s.size(), o.s.size(), o.s) == 0; }
+  long toInt() const { return atol(s.c_str()); }
+  void trim() { size_t b = s.find_first_not_of(" \t\r\n"); if (b == std::string::npos) { s.clear(); return; } size_t e = s.find_last_not_of(" \t\r\n"); s = s.substr(b, e - b + 1); }
+  void toLowerCase() { for (auto& c : s) c = tolower(c); }
+  void toUpperCase() { for (auto& c : s) c = toupper(c); }
+  char charAt(unsigned i) const { return i < s.size() ? s[i] : 0; }
+  char operator[](unsigned i) const { return charAt(i); }
+  char& operator[](unsigned i) { return s[i]; }
+  void setCharAt(unsigned i, char c) { if (i < s.size()) s[i] = c; }
+  void remove(unsigned i) { if (i < s.size()) s.erase(i); }
+  void remove(unsigned i, unsigned n) { if (i < s.size()) s.erase(i, n); }
+  bool concat(const String& o) { s += o.s; return true; }
+  bool concat(char c) { s += c; return true; }
+  bool concat(const char* c, unsigned n) { s.append(c, n); return true; }
+  bool isEmpty() const { return s.empty(); }
+  String& operator+=(const String& o) { s += o.s; return *this; }
+  String& operator+=(const char* o) { s += o; return *this; }
+  String& operator+=(char o) { s += o; return *this; }
+  String& operator+=(int o) { s += std::to_string(o); return *this; }
+  String& operator+=(unsigned o) { s += std::to_string(o); return *this; }
+  String& operator+=(long o) { s += std::to_string(o); return *this; }
+  String& operator+=(unsigned long o) { s += std::to_string(o); return *this; }
+  explicit operator bool() const { return !s.empty(); }
+  bool operator==(const String& o) const { return s == o.s; }
+  bool operator==(const char* o) const { return s == o; }
+  bool operator!=(const String& o) const { return s != o.s; }
+  bool operator!=(const char* o) const { return s != o; }
+  bool operator<(const String& o) const { return s < o.s; }
+};
+inline String operator+(String a, const String& b) { a += b; return a; }
+inline String operator+(String a, const char* b) { a += b; return a; }
+inline String operator+(String a, char b) { a += b; return a; }
+inline String operator+(String a, int b) { a += b; return a; }
+inline String operator+(String a, unsigned b) { a += b; return a; }
+inline String operator+(String a, long b) { a += b; return a; }
+inline String operator+(String a, unsigned long b) { a += b; return a; }
+inline String operator+(const char* a, const String& b) { return String(a) + b; }
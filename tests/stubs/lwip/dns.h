@@ -0,0 +1,36 @@
+// Host stand-in for lwIP 2's resolver, dual stack. Lookups are answered by fakeResolve(), see FakeClient.h
+#pragma once
+#include <cstdint>
+
+#define LWIP_VERSION_MAJOR  2
+#define LWIP_IPV6           1
+
+typedef int8_t err_t;
+
+#define ERR_OK          0
+#define ERR_INPROGRESS  -5
+#define ERR_ARG         -16
+
+#define IPADDR_TYPE_V4  0U
+#define IPADDR_TYPE_V6  6U
+
+struct ip4_addr_t { uint32_t addr; };
+struct ip6_addr_t { uint32_t addr[4]; };
+
+struct ip_addr_t
+{
+  union
+  {
+    ip6_addr_t ip6;
+    ip4_addr_t ip4;
+  } u_addr;
+  uint8_t type;
+};
+
+#define IP_IS_V4(ipaddr)          ((ipaddr)->type == IPADDR_TYPE_V4)
+#define ip_2_ip4(ipaddr)          (&((ipaddr)->u_addr.ip4))
+#define ip4_addr_get_u32(src_ipaddr) ((src_ipaddr)->addr)
+
+typedef void (*dns_found_callback)(const char* name, const ip_addr_t* ipaddr, void* callback_arg);
+
+err_t dns_gethostbyname(const char* hostname, ip_addr_t* addr, dns_found_callback found, void* callback_arg);
@@ -0,0 +1,12 @@
+// Host stand-in for pgmspace: flash is ordinary memory
+#pragma once
+#define PSTR(x) (x)
+#define PGM_P const char*
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define memcpy_P memcpy
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+#define PROGMEM
+#define F(x) ((const __FlashStringHelper*)(x))
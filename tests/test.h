@@ -0,0 +1,33 @@
+// Checks for the host tests. A failed check is reported and counted, the test carries on;
+// main() returns testResult() so make sees the failure.
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <WString.h>
+
+inline int& testFailures()
+{
+  static int failures = 0;
+
+  return failures;
+}
+
+#define CHECK(cond) \
+  do { if ( ! (cond)) { testFailures()++; printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); } } while (0)
+
+#define CHECK_EQ(a, b) \
+  do { auto _a = (a); auto _b = (b); if ( ! (_a == _b)) { testFailures()++; \
+    printf("%s:%d: CHECK_EQ(%s, %s) failed: %s != %s\n", __FILE__, __LINE__, #a, #b, testShow(_a).c_str(), testShow(_b).c_str()); } } while (0)
+
+inline std::string testShow(const std::string& s)   { return "'" + (s.size() > 60 ? s.substr(0, 60) + "..." : s) + "'"; }
+inline std::string testShow(const char* s)          { return testShow(std::string(s)); }
+inline std::string testShow(const String& s)        { return testShow(std::string(s.c_str())); }
+template<typename T> std::string testShow(T v)      { return std::to_string(v); }
+
+inline int testResult(const char* name)
+{
+  printf("%s: %s\n", name, testFailures() ? "FAILED" : "passed");
+
+  return testFailures() ? 1 : 0;
+}
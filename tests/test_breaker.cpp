@@ -0,0 +1,78 @@
+// Circuit breaker: transport errors count against the origin, and only an open circuit reports CIRCUIT_OPEN
+#include "test.h"
+#include "FakeClient.h"
+#include <AsyncHTTPRequest.h>
+
+namespace
+{
+  // One GET to the origin; the server answers part of it and the connection is reset, or the connect is refused
+  int attempt(AsyncHTTPCircuitBreaker& breaker, bool refuse)
+  {
+    AsyncHTTPRequest request;
+
+    request.setCircuitBreaker(&breaker);
+    request.open(*parseURL("http://10.0.0.1/status"));
+    request.send();
+
+    AsyncClient* client = fakeLast();
+
+    if (request.readyState() != ReadyState::Done && client && fakeConnecting(client))
+    {
+      if (refuse)
+      {
+        fakeRefuse(client);
+      }
+      else
+      {
+        fakeAccept(client);
+        fakeSent(client);
+        fakeReply(client, "HTTP/1.1 200 OK\r\nContent-Length: 100\r\n\r\npartial");
+        fakeError(client, -14);
+      }
+    }
+
+    CHECK(request.readyState() == ReadyState::Done);
+
+    return request.responseHTTPcode();
+  }
+
+  void resetMidBody()
+  {
+    // ERR_RST is -14, the same number as CIRCUIT_OPEN: it must still be a failure of the origin
+    AsyncHTTPCircuitBreaker breaker;
+
+    breaker.setFailureThreshold(2);
+
+    CHECK_EQ(attempt(breaker, false), (int) HttpCode::CONNECTION_LOST);
+    CHECK_EQ(breaker.trips(), (uint32_t) 0);
+
+    CHECK_EQ(attempt(breaker, false), (int) HttpCode::CONNECTION_LOST);
+    CHECK_EQ(breaker.trips(), (uint32_t) 1);
+
+    // Now it is open for real, and the request doesn't go out
+    size_t clients = fakeClients().size();
+
+    CHECK_EQ(attempt(breaker, false), (int) HttpCode::CIRCUIT_OPEN);
+    CHECK_EQ(fakeClients().size(), clients);
+    CHECK_EQ(breaker.rejected(), (uint32_t) 1);
+  }
+
+  void refused()
+  {
+    AsyncHTTPCircuitBreaker breaker;
+
+    breaker.setFailureThreshold(2);
+
+    CHECK_EQ(attempt(breaker, true), (int) HttpCode::NOT_CONNECTED);
+    CHECK_EQ(attempt(breaker, true), (int) HttpCode::NOT_CONNECTED);
+    CHECK_EQ(breaker.trips(), (uint32_t) 1);
+  }
+}
+
+int main()
+{
+  resetMidBody();
+  refused();
+
+  return testResult("test_breaker");
+}
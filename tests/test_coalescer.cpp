@@ -0,0 +1,116 @@
+// Coalescing: requests sharing another's response when that one drops part way and is retried
+#include "test.h"
+#include "FakeClient.h"
+#include <AsyncHTTPRequest.h>
+
+namespace
+{
+  const std::string head = "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n";
+
+  struct Shared
+  {
+    AsyncHTTPCoalescer    coalescer;
+    AsyncHTTPRetryPolicy  retry;
+    AsyncHTTPRequest      leader;
+    AsyncHTTPRequest      follower;
+
+    Shared()
+    {
+      retry.setBackoff(10, 10);
+
+      leader.setCoalescer(&coalescer);
+      leader.setRetryPolicy(&retry);
+      follower.setCoalescer(&coalescer);
+
+      leader.open(*parseURL("http://10.0.0.1/shared"));
+      leader.send();
+      follower.open(*parseURL("http://10.0.0.1/shared"));
+      follower.send();
+    }
+  };
+
+  // The first attempt gets the headers and part of the body through, then the connection drops
+  void dropPartWay()
+  {
+    AsyncClient* client = fakeLast();
+
+    fakeAccept(client);
+    fakeSent(client);
+    fakeReply(client, head + "AAAA");
+    fakeDrop(client);
+  }
+
+  void answerRetry()
+  {
+    fakeAdvance(100);
+
+    AsyncClient* client = fakeLast();
+
+    CHECK(client && fakeConnecting(client));
+
+    if ( ! client)
+      return;
+
+    fakeAccept(client);
+    fakeSent(client);
+    fakeReply(client, head + "0123456789");
+  }
+
+  void followerRestarts()
+  {
+    // Nothing of the dropped attempt was read: the follower gets the retried response, and only that
+    Shared shared;
+
+    CHECK_EQ(fakeClients().size(), (size_t) 1);
+    CHECK_EQ(shared.coalescer.coalesced(), (uint32_t) 1);
+
+    dropPartWay();
+
+    CHECK(shared.follower.readyState() != ReadyState::Done);
+
+    answerRetry();
+
+    CHECK(shared.leader.readyState() == ReadyState::Done);
+    CHECK(shared.follower.readyState() == ReadyState::Done);
+    CHECK_EQ(shared.leader.responseHTTPcode(), 200);
+    CHECK_EQ(shared.follower.responseHTTPcode(), 200);
+    CHECK_EQ(std::string(shared.leader.responseText().c_str()), std::string("0123456789"));
+    CHECK_EQ(std::string(shared.follower.responseText().c_str()), std::string("0123456789"));
+  }
+
+  void followerReadPart()
+  {
+    // The follower's application already has "AAAA": it can't be given the retried response from the start
+    Shared  shared;
+    uint8_t buffer[16];
+
+    CHECK_EQ(fakeClients().size(), (size_t) 1);
+
+    AsyncClient* client = fakeLast();
+
+    fakeAccept(client);
+    fakeSent(client);
+    fakeReply(client, head + "AAAA");
+
+    CHECK_EQ(shared.follower.responseRead(buffer, sizeof(buffer)), (size_t) 4);
+
+    fakeDrop(client);
+
+    CHECK(shared.follower.readyState() == ReadyState::Done);
+    CHECK_EQ(shared.follower.responseHTTPcode(), (int) HttpCode::CONNECTION_LOST);
+
+    answerRetry();
+
+    CHECK(shared.leader.readyState() == ReadyState::Done);
+    CHECK_EQ(std::string(shared.leader.responseText().c_str()), std::string("0123456789"));
+    CHECK_EQ(shared.follower.available(), (size_t) 0);
+  }
+}
+
+int main()
+{
+  followerRestarts();
+  followerReadPart();
+
+  return testResult("test_coalescer");
+}
@@ -0,0 +1,218 @@
+// Dispatcher: options a job's prepare callback sets must not carry over to the next job on the same slot, and
+// jobs submitted from a done callback wait for it to return
+#include "test.h"
+#include "FakeClient.h"
+#include <AsyncHTTPDispatcher.h>
+#include <AsyncHTTPPipeline.h>
+#include <algorithm>
+
+namespace
+{
+  using responder = std::function<std::string(const std::string& request)>;
+
+  bool live(AsyncClient* client)
+  {
+    return std::find(fakeClients().begin(), fakeClients().end(), client) != fakeClients().end();
+  }
+
+  // Play the server until nothing moves: accept connects, answer every request that was written
+  void serve(responder respond, std::vector<std::string>* requests = nullptr)
+  {
+    for (bool moved = true; moved; )
+    {
+      moved = false;
+
+      for (AsyncClient* client : std::vector<AsyncClient*>(fakeClients()))
+      {
+        if ( ! live(client))
+          continue;
+
+        if (fakeConnecting(client))
+        {
+          fakeAccept(client);
+          moved = true;
+        }
+
+        if ( ! live(client) || ! fakeConnected(client))
+          continue;
+
+        std::string request = fakeSent(client);
+
+        if (request.empty())
+          continue;
+
+        if (requests)
+          requests->push_back(request);
+
+        fakeReply(client, respond(request));
+        moved = true;
+      }
+    }
+  }
+
+  std::string ok(const std::string&)
+  {
+    return "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+  }
+
+  std::string noContent(const std::string&)
+  {
+    return "HTTP/1.1 204 No Content\r\n\r\n";
+  }
+
+  // Shared by a job's prepare and done callbacks
+  struct Job
+  {
+    int                 count{0};
+    std::string         text;
+    AsyncHTTPPipeline*  pipeline{nullptr};
+    xsse*               events{nullptr};
+    AsyncHTTPDispatcher* dispatcher{nullptr};
+    Job*                follow{nullptr};
+  };
+
+  void done(void* arg, AsyncHTTPRequest* request)
+  {
+    ((Job*) arg)->count++;
+    ((Job*) arg)->text = request->responseText().c_str();
+  }
+
+  void pipelineReset()
+  {
+    AsyncHTTPDispatcher dispatcher;
+    AsyncHTTPPipeline   pipeline;
+    Job                 first, second;
+
+    dispatcher.setMaxConcurrent(1);
+    pipeline.begin("10.0.0.1", 80);
+    first.pipeline = &pipeline;
+
+    dispatcher.submit(*parseURL("http://10.0.0.1/a"), done, &first, [](void* arg, AsyncHTTPRequest* request)
+    {
+      request->setPipeline(((Job*) arg)->pipeline);
+    });
+
+    serve(ok);
+    CHECK_EQ(first.count, 1);
+
+    // The second job, on the same request object, goes over the pool and not the first job's pipeline
+    dispatcher.submit(*parseURL("http://10.0.0.1/b"), done, &second);
+
+    CHECK_EQ(pipeline.queued(), (size_t) 0);
+
+    serve(ok);
+    CHECK_EQ(second.count, 1);
+    CHECK_EQ(second.text, std::string("ok"));
+  }
+
+  void eventStreamReset()
+  {
+    AsyncHTTPDispatcher       dispatcher;
+    xsse                      events;
+    Job                       first, second;
+    std::vector<std::string>  requests;
+
+    dispatcher.setMaxConcurrent(1);
+    first.events = &events;
+
+    dispatcher.submit(*parseURL("http://10.0.0.1/events"), done, &first, [](void* arg, AsyncHTTPRequest* request)
+    {
+      request->setEventStream(((Job*) arg)->events);
+    });
+
+    // Not a stream after all, the job ends there
+    serve(noContent);
+    CHECK_EQ(first.count, 1);
+
+    // The next job on the request is an ordinary GET, not a stream with reconnects
+    dispatcher.submit(*parseURL("http://10.0.0.1/b"), done, &second);
+
+    serve(ok, &requests);
+    CHECK_EQ(second.count, 1);
+    CHECK_EQ(second.text, std::string("ok"));
+    CHECK_EQ(requests.size(), (size_t) 1);
+    CHECK(requests[0].find("text/event-stream") == std::string::npos);
+  }
+
+  void streamingReset()
+  {
+    AsyncHTTPDispatcher dispatcher;
+    Job                 first, second;
+
+    dispatcher.setMaxConcurrent(1);
+
+    dispatcher.submit(*parseURL("http://10.0.0.1/feed"), done, &first, [](void*, AsyncHTTPRequest* request)
+    {
+      request->setStreaming(true);
+      request->setHeartbeat(100);
+    });
+
+    serve(noContent);
+    CHECK_EQ(first.count, 1);
+
+    // The next job's body stalls longer than the first one's heartbeat; it's an ordinary response, kept whole
+    dispatcher.submit(*parseURL("http://10.0.0.1/b"), done, &second);
+
+    AsyncClient* client = fakeLast();
+
+    CHECK(client != nullptr);
+
+    if ( ! client)
+      return;
+
+    if (fakeConnecting(client))
+      fakeAccept(client);
+
+    fakeSent(client);
+    fakeReply(client, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nhello");
+    fakeAdvance(500);
+
+    CHECK_EQ(second.count, 0);
+
+    fakeReply(client, "world");
+
+    CHECK_EQ(second.count, 1);
+    CHECK_EQ(second.text, std::string("helloworld"));
+  }
+
+  void submitFromDone()
+  {
+    // A done callback that submits: the new job waits for the callback to return instead of reopening its request
+    AsyncHTTPDispatcher dispatcher;
+    Job                 first, second;
+
+    dispatcher.setMaxConcurrent(1);
+    first.dispatcher = &dispatcher;
+    first.follow     = &second;
+
+    dispatcher.submit(*parseURL("http://10.0.0.1/a"), [](void* arg, AsyncHTTPRequest* request)
+    {
+      Job* job = (Job*) arg;
+
+      done(arg, request);
+      job->dispatcher->submit(*parseURL("http://10.0.0.1/b"), done, job->follow);
+
+      CHECK(request->readyState() == ReadyState::Done);
+      CHECK_EQ(job->dispatcher->queued(), (size_t) 1);
+    }, &first);
+
+    serve(ok);
+
+    CHECK_EQ(first.count, 1);
+    CHECK_EQ(first.text, std::string("ok"));
+    CHECK_EQ(second.count, 1);
+    CHECK_EQ(second.text, std::string("ok"));
+    CHECK_EQ(dispatcher.queued(), (size_t) 0);
+    CHECK_EQ(dispatcher.active(), (size_t) 0);
+  }
+}
+
+int main()
+{
+  pipelineReset();
+  eventStreamReset();
+  streamingReset();
+  submitFromDone();
+
+  return testResult("test_dispatcher");
+}
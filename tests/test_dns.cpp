@@ -0,0 +1,44 @@
+// DNS cache: background resolves and what a dual stack resolver may answer
+#include "test.h"
+#include "FakeClient.h"
+#include <AsyncHTTPRequest.h>
+
+namespace
+{
+  void resolves()
+  {
+    AsyncHTTPDNSCache cache;
+    IPAddress         ip;
+
+    CHECK( ! cache.resolve("example.com"));
+    CHECK_EQ(fakeLookup(), std::string("example.com"));
+
+    fakeResolve("example.com", IPAddress(10, 0, 0, 7));
+
+    CHECK(cache.lookup("example.com", ip));
+    CHECK(ip == IPAddress(10, 0, 0, 7));
+    CHECK(cache.resolve("example.com"));
+  }
+
+  void ipv6Answer()
+  {
+    // An IPv6 address can't be kept in an IPAddress: the host is unusable, not 0.0.0.0 or a mangled v4
+    AsyncHTTPDNSCache cache;
+    IPAddress         ip;
+
+    CHECK( ! cache.resolve("v6only.example.com"));
+
+    fakeResolve6("v6only.example.com");
+
+    CHECK( ! cache.lookup("v6only.example.com", ip));
+    CHECK(cache.failed("v6only.example.com"));
+  }
+}
+
+int main()
+{
+  resolves();
+  ipv6Answer();
+
+  return testResult("test_dns");
+}
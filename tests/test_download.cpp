@@ -0,0 +1,333 @@
+// Resumable downloads over connections that drop at random offsets
+#include "test.h"
+#include "FakeClient.h"
+#include <AsyncHTTPDownload.h>
+
+namespace
+{
+  const size_t ALL = SIZE_MAX;
+
+  // The origin: one resource, served whole or from a Range start, with Content-Length or chunked
+  struct Origin
+  {
+    std::string resource;
+    bool        chunked{false};
+    size_t      chunkSize{100};
+    bool        ranges{true};
+    long        rangeSkew{0};                   // added to the start the server claims in Content-Range
+    size_t      bodyLimit{SIZE_MAX};            // body bytes sent before the connection drops
+    int         requests{0};
+
+    std::string response(const std::string& request)
+    {
+      size_t start = 0;
+      size_t at    = request.find("bytes=");
+
+      if (ranges && at != std::string::npos)
+        start = strtoul(request.c_str() + at + 6, nullptr, 10);
+
+      std::string body = resource.substr(start);
+      std::string head = start ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+
+      head += "ETag: \"v1\"\r\n";
+
+      if (start)
+        head += "Content-Range: bytes " + std::to_string(start + rangeSkew) + "-" + std::to_string(resource.size() - 1) +
+                "/" + std::to_string(resource.size()) + "\r\n";
+
+      if ( ! chunked)
+        return head + "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+
+      std::string out = head + "Transfer-Encoding: chunked\r\n\r\n";
+      char        size[16];
+
+      for (size_t i = 0; i < body.size(); i += chunkSize)
+      {
+        std::string chunk = body.substr(i, chunkSize);
+
+        snprintf(size, sizeof(size), "%zx\r\n", chunk.size());
+        out += size + chunk + "\r\n";
+      }
+
+      return out + "0\r\n\r\n";
+    }
+  };
+
+  struct Run
+  {
+    AsyncHTTPDownload download;
+    std::string       got;
+    int               done{0};
+    int               doneCode{0};
+    int               restarts{0};
+  };
+
+  void start(Run& run, size_t offset = 0)
+  {
+    run.download.onDone([](void* arg, AsyncHTTPDownload*, int code)
+    {
+      ((Run*) arg)->done++;
+      ((Run*) arg)->doneCode = code;
+    }, &run);
+
+    run.download.begin(*parseURL("http://10.0.0.1/image.bin"), [](void* arg, const uint8_t* data, size_t len, size_t offset)
+    {
+      Run* run = (Run*) arg;
+
+      // Offsets either carry on where the sink is or go back to 0 when the server sends it all again
+      if (offset != run->got.size())
+      {
+        run->restarts++;
+        run->got.resize(offset);
+      }
+
+      run->got.append((const char*) data, len);
+
+      return true;
+    }, &run, offset);
+  }
+
+  // Serve the next attempt, dropping the connection once cut bytes of the response are out
+  bool serve(Origin& origin, size_t cut)
+  {
+    AsyncClient* client = fakeLast();
+
+    if ( ! client || ! fakeConnecting(client))
+      return false;
+
+    fakeAccept(client);
+
+    std::string request  = fakeSent(client);
+    std::string response = origin.response(request);
+
+    origin.requests++;
+
+    if (origin.bodyLimit != ALL && cut > response.find("\r\n\r\n") + 4 + origin.bodyLimit)
+      cut = response.find("\r\n\r\n") + 4 + origin.bodyLimit;
+
+    if (cut > response.size())
+      cut = response.size();
+
+    // In uneven pieces, the way segments arrive
+    for (size_t at = 0; at < cut; )
+    {
+      size_t len = 1 + random(1460);
+
+      if (len > cut - at)
+        len = cut - at;
+
+      fakeReply(client, response.substr(at, len));
+      at += len;
+    }
+
+    if (cut < response.size() && fakeConnected(client))
+      fakeDrop(client);
+
+    return true;
+  }
+
+  std::string resource(size_t len)
+  {
+    std::string s;
+
+    for (size_t i = 0; i < len; i++)
+      s += (char) random(256);
+
+    return s;
+  }
+
+  void randomDrops(bool chunked)
+  {
+    for (int round = 0; round < 200; round++)
+    {
+      Origin origin;
+      Run    run;
+
+      origin.resource = resource(1 + random(20000));
+      origin.chunked  = chunked;
+      origin.ranges   = random(4) != 0;
+
+      start(run);
+
+      // Each attempt drops at a random point of its response, or is let through
+      for (int attempt = 0; run.done == 0 && attempt < 100; attempt++)
+      {
+        size_t cut = random(3) ? (size_t) random(origin.resource.size() + 200) : ALL;
+
+        if ( ! serve(origin, cut))
+          break;
+      }
+
+      CHECK_EQ(run.done, 1);
+      CHECK(run.doneCode == 200 || run.doneCode == 206);
+      CHECK(run.got == origin.resource);
+      CHECK_EQ(run.download.offset(), origin.resource.size());
+
+      // Without range support every attempt starts over, with it none does
+      if (origin.ranges)
+        CHECK_EQ(run.restarts, 0);
+    }
+  }
+
+  void chunkBoundary()
+  {
+    // Cut right after a whole chunk: the body looks complete but its last chunk never came
+    Origin origin;
+    Run    run;
+
+    origin.resource = "hello world!";
+    origin.chunked  = true;
+    origin.chunkSize = 5;
+
+    start(run);
+
+    std::string first = origin.response("");
+    serve(origin, first.find("5\r\nhello\r\n") + 10);
+
+    CHECK_EQ(run.done, 0);
+    CHECK_EQ(run.got, std::string("hello"));
+
+    serve(origin, ALL);
+
+    CHECK_EQ(run.done, 1);
+    CHECK_EQ(run.doneCode, 206);
+    CHECK_EQ(run.got, origin.resource);
+    CHECK_EQ(origin.requests, 2);
+  }
+
+  void lengthBoundary()
+  {
+    // The same with a length: all the headers and no body
+    Origin origin;
+    Run    run;
+
+    origin.resource = "0123456789";
+
+    start(run);
+
+    std::string first = origin.response("");
+    serve(origin, first.find("\r\n\r\n") + 4);
+    serve(origin, ALL);
+
+    CHECK_EQ(run.done, 1);
+    CHECK_EQ(run.doneCode, 200);
+    CHECK_EQ(run.got, origin.resource);
+  }
+
+  void errorMidBody(int8_t error)
+  {
+    // lwIP reports a reset (-14) or an abort (-13) part way through the body: resumed from where it got to
+    Origin origin;
+    Run    run;
+
+    origin.resource = resource(1000);
+
+    start(run);
+
+    AsyncClient* client = fakeLast();
+    std::string  response = origin.response("");
+
+    fakeAccept(client);
+    fakeSent(client);
+    origin.requests++;
+    fakeReply(client, response.substr(0, response.find("\r\n\r\n") + 4 + 400));
+    fakeError(client, error);
+
+    CHECK_EQ(run.done, 0);
+    CHECK_EQ(run.got.size(), (size_t) 400);
+
+    client = fakeLast();
+    CHECK(client && fakeConnecting(client));
+
+    if ( ! client)
+      return;
+
+    fakeAccept(client);
+
+    std::string request = fakeSent(client);
+
+    CHECK(request.find("Range:") != std::string::npos && request.find("bytes=400-") != std::string::npos);
+
+    fakeReply(client, origin.response(request));
+
+    CHECK_EQ(run.done, 1);
+    CHECK_EQ(run.doneCode, 206);
+    CHECK(run.got == origin.resource);
+    CHECK_EQ(run.restarts, 0);
+  }
+
+  void givesUp()
+  {
+    // Drops that deliver nothing use up the resumes, then the download fails
+    Origin origin;
+    Run    run;
+
+    origin.resource = "0123456789";
+    run.download.setMaxResumes(3);
+
+    start(run);
+
+    for (int attempt = 0; attempt < 10 && serve(origin, 0); attempt++);
+
+    CHECK_EQ(run.done, 1);
+    CHECK_EQ(run.doneCode, (int) HttpCode::CONNECTION_LOST);
+    CHECK_EQ(origin.requests, 4);
+  }
+
+  void progressResets()
+  {
+    // Drops that each get some of it through don't count against the limit
+    Origin origin;
+    Run    run;
+
+    origin.resource  = resource(2000);
+    origin.bodyLimit = 100;
+    run.download.setMaxResumes(2);
+
+    start(run);
+
+    for (int attempt = 0; run.done == 0 && attempt < 100; attempt++)
+      serve(origin, ALL);
+
+    CHECK_EQ(run.done, 1);
+    CHECK(run.doneCode == 200 || run.doneCode == 206);
+    CHECK(run.got == origin.resource);
+    CHECK_EQ(origin.requests, 20);
+  }
+
+  void rangeMismatch()
+  {
+    // A 206 for some other range can't be spliced on, and isn't reported as an HTTP status
+    Origin origin;
+    Run    run;
+
+    origin.resource  = "0123456789";
+    origin.rangeSkew = 1;
+
+    start(run, 4);
+    serve(origin, ALL);
+
+    CHECK_EQ(run.done, 1);
+    CHECK_EQ(run.doneCode, (int) HttpCode::RANGE_MISMATCH);
+    CHECK_EQ(run.got, std::string());
+  }
+}
+
+int main()
+{
+  srand(1);
+
+  randomDrops(false);
+  randomDrops(true);
+  chunkBoundary();
+  lengthBoundary();
+  errorMidBody(-14);
+  errorMidBody(-13);
+  givesUp();
+  progressResets();
+  rangeMismatch();
+
+  CHECK(fakeClients().empty());
+
+  return testResult("test_download");
+}
@@ -0,0 +1,127 @@
+// Filesystem cache tier: stores wait for run(), and come back after a "restart" to be revalidated
+#include "test.h"
+#include "FakeClient.h"
+#include <AsyncHTTPRequest.h>
+#include <cstdlib>
+
+namespace
+{
+  const std::string body = "{\"temp\":21.5}";
+
+  std::string response(const char* etag)
+  {
+    return std::string("HTTP/1.1 200 OK\r\nETag: \"") + etag + "\"\r\nCache-Control: max-age=60\r\n"
+           "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+  }
+
+  // One GET through the cache; reply is what the server answers, if it is asked at all
+  std::string fetch(AsyncHTTPResponseCache& cache, const char* path, const std::string& reply, std::string* sent = nullptr)
+  {
+    AsyncHTTPRequest request;
+
+    request.setResponseCache(&cache);
+    request.open(*parseURL(String("http://10.0.0.1") + path));
+    request.send();
+
+    AsyncClient* client = fakeLast();
+
+    if (request.readyState() != ReadyState::Done && client)
+    {
+      fakeAccept(client);
+
+      if (sent)
+        *sent = fakeSent(client);
+      else
+        fakeSent(client);
+
+      fakeReply(client, reply);
+    }
+
+    CHECK(request.readyState() == ReadyState::Done);
+
+    return request.responseText().c_str();
+  }
+
+  void queuedUntilRun(fs::FS& fs)
+  {
+    AsyncHTTPFileCache     files(fs);
+    AsyncHTTPResponseCache cache;
+
+    cache.setFileCache(&files);
+
+    fetch(cache, "/a", response("a1"));
+    fetch(cache, "/b", response("b1"));
+
+    // Nothing touches the filesystem from the network callbacks
+    CHECK_EQ(files.queued(), (size_t) 2);
+    CHECK( ! fs.exists("/httpcache/index"));
+    CHECK_EQ(files.writes(), (uint32_t) 0);
+
+    files.run();
+
+    CHECK_EQ(files.queued(), (size_t) 0);
+    CHECK(fs.exists("/httpcache/index"));
+    CHECK_EQ(files.entries(), (size_t) 2);
+    CHECK_EQ(files.writes(), (uint32_t) 2);
+  }
+
+  void afterRestart(fs::FS& fs)
+  {
+    // New caches over the same files, as after a reboot: the stored copy is revalidated and a 304 completes it
+    AsyncHTTPFileCache     files(fs);
+    AsyncHTTPResponseCache cache;
+    std::string            sent;
+
+    cache.setFileCache(&files);
+
+    CHECK_EQ(files.entries(), (size_t) 2);
+
+    std::string text = fetch(cache, "/a", "HTTP/1.1 304 Not Modified\r\nETag: \"a1\"\r\n\r\n", &sent);
+
+    CHECK(sent.find("If-None-Match:") != std::string::npos && sent.find("\"a1\"") != std::string::npos);
+    CHECK_EQ(text, body);
+    CHECK_EQ(files.loads(), (uint32_t) 1);
+  }
+
+  void removalQueued(fs::FS& fs)
+  {
+    // A removal replaces the store still waiting for the same key, nothing is written
+    AsyncHTTPFileCache     files(fs);
+    AsyncHTTPResponseCache cache;
+
+    cache.setFileCache(&files);
+    files.flush();
+
+    fetch(cache, "/c", response("c1"));
+    CHECK_EQ(files.queued(), (size_t) 1);
+
+    cache.flush();
+    fetch(cache, "/c", "HTTP/1.1 200 OK\r\nCache-Control: no-store\r\nContent-Length: 2\r\n\r\nok");
+
+    CHECK_EQ(files.queued(), (size_t) 1);
+
+    files.run();
+
+    CHECK_EQ(files.entries(), (size_t) 0);
+    CHECK_EQ(files.writes(), (uint32_t) 0);
+  }
+}
+
+int main()
+{
+  char root[] = "/tmp/filecacheXXXXXX";
+
+  CHECK(mkdtemp(root));
+
+  {
+    fs::FS fs(root);
+
+    queuedUntilRun(fs);
+    afterRestart(fs);
+    removalQueued(fs);
+  }
+
+  system((std::string("rm -rf ") + root).c_str());
+
+  return testResult("test_filecache");
+}
@@ -0,0 +1,403 @@
+// HTTP/2 session: connection setup, header blocks, HPACK, flow control, GOAWAY and the header list limit
+#include "test.h"
+#include "FakeClient.h"
+#include <AsyncHTTPRequest.h>
+
+namespace
+{
+  enum : uint8_t { DATA = 0x0, HEADERS = 0x1, SETTINGS = 0x4, GOAWAY = 0x7, WINDOW_UPDATE = 0x8, CONTINUATION = 0x9 };
+  enum : uint8_t { END_STREAM = 0x01, ACK = 0x01, END_HEADERS = 0x04 };
+
+  const std::string preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+  struct Frame
+  {
+    uint8_t     type;
+    uint8_t     flags;
+    uint32_t    id;
+    std::string payload;
+  };
+
+  // "8286 84be" and the like, as RFC 7541 writes its examples
+  std::string hex(const char* text)
+  {
+    std::string bytes;
+
+    for (const char* p = text; *p; )
+    {
+      if (*p == ' ')
+      {
+        p++;
+        continue;
+      }
+
+      bytes += (char) std::stoi(std::string(p, 2), nullptr, 16);
+      p += 2;
+    }
+
+    return bytes;
+  }
+
+  std::string uint32(uint32_t value)
+  {
+    return std::string{ (char) (value >> 24), (char) (value >> 16), (char) (value >> 8), (char) value };
+  }
+
+  std::string frame(uint8_t type, uint8_t flags, uint32_t id, const std::string& payload)
+  {
+    size_t len = payload.size();
+
+    return std::string{ (char) (len >> 16), (char) (len >> 8), (char) len, (char) type, (char) flags } + uint32(id) +
+           payload;
+  }
+
+  // The frames in what the client wrote, after the connection preface if it is there
+  std::vector<Frame> frames(std::string wire)
+  {
+    std::vector<Frame> out;
+
+    if ( ! wire.compare(0, preface.size(), preface))
+      wire.erase(0, preface.size());
+
+    while (wire.size() >= 9)
+    {
+      const uint8_t* p = (const uint8_t*) wire.data();
+      size_t         len = ((size_t) p[0] << 16) | ((size_t) p[1] << 8) | p[2];
+
+      out.push_back({ p[3], p[4], (((uint32_t) p[5] & 0x7F) << 24) | ((uint32_t) p[6] << 16) | ((uint32_t) p[7] << 8) | p[8],
+                      wire.substr(9, len) });
+      wire.erase(0, 9 + len);
+    }
+
+    return out;
+  }
+
+  // Whether there is a frame of that type on that stream, and its payload
+  bool find(const std::vector<Frame>& out, uint8_t type, uint32_t id, std::string* payload = nullptr)
+  {
+    for (const Frame& f : out)
+    {
+      if (f.type != type || f.id != id)
+        continue;
+
+      if (payload)
+        *payload = f.payload;
+
+      return true;
+    }
+
+    return false;
+  }
+
+  void get(AsyncHTTP2Session& h2, AsyncHTTPRequest& request, const char* path)
+  {
+    request.setHTTP2(&h2);
+    request.open(*parseURL(String("http://10.0.0.1") + path));
+    request.send();
+  }
+
+  // Completes the connect and answers the client's SETTINGS with the server's own
+  void handshake(AsyncClient* client)
+  {
+    fakeAccept(client);
+    fakeReply(client, frame(SETTINGS, 0, 0, ""));
+  }
+
+  void settings()
+  {
+    AsyncHTTP2Session h2;
+    AsyncHTTPRequest  request;
+
+    h2.begin("10.0.0.1");
+    get(h2, request, "/status");
+
+    AsyncClient* client = fakeLast();
+
+    CHECK(client && fakeConnecting(client));
+
+    if ( ! client)
+      return;
+
+    fakeAccept(client);
+
+    std::string sent = fakeSent(client);
+    auto        out  = frames(sent);
+
+    CHECK_EQ(sent.substr(0, preface.size()), preface);
+    CHECK(out.size() >= 2);
+
+    if (out.size() < 2)
+      return;
+
+    // Header table, push off, the window each stream starts with, and the largest header list taken
+    CHECK_EQ((int) out[0].type, (int) SETTINGS);
+    CHECK(out[0].payload == hex("0001 00000200 0002 00000000 0004 00001000 0006 00002000"));
+
+    // The request goes out at once, a GET is a single HEADERS frame that ends the stream
+    CHECK_EQ((int) out[1].type, (int) HEADERS);
+    CHECK_EQ(out[1].id, (uint32_t) 1);
+    CHECK_EQ((int) out[1].flags, END_STREAM | END_HEADERS);
+
+    // The server's SETTINGS are acknowledged, with nothing in the frame
+    fakeReply(client, frame(SETTINGS, 0, 0, hex("0003 00000064")));
+
+    out = frames(fakeSent(client));
+
+    CHECK(out.size() == 1 && out[0].type == SETTINGS && out[0].flags == ACK && out[0].payload.empty());
+
+    // 204, in a HEADERS frame that ends the stream
+    fakeReply(client, frame(HEADERS, END_HEADERS | END_STREAM, 1, hex("89")));
+
+    CHECK(request.readyState() == ReadyState::Done);
+    CHECK_EQ(request.responseHTTPcode(), 204);
+  }
+
+  void continuation()
+  {
+    // The header block split over HEADERS and CONTINUATION, mid-field, and all of it fed a byte at a time
+    AsyncHTTP2Session h2;
+    AsyncHTTPRequest  request;
+
+    h2.begin("10.0.0.1");
+    get(h2, request, "/split");
+
+    AsyncClient* client = fakeLast();
+
+    handshake(client);
+    fakeSent(client);
+
+    // :status 200, content-length 5 against the static table's name, x-test: yes as a new name
+    std::string block = hex("88 0f0d 01") + "5" + hex("00 06") + "x-test" + hex("03") + "yes";
+    std::string wire  = frame(HEADERS, 0, 1, block.substr(0, 6)) + frame(CONTINUATION, END_HEADERS, 1, block.substr(6)) +
+                        frame(DATA, END_STREAM, 1, "hello");
+
+    for (char c : wire)
+      fakeReply(client, std::string(1, c));
+
+    CHECK(request.readyState() == ReadyState::Done);
+    CHECK_EQ(request.responseHTTPcode(), 200);
+    CHECK_EQ(std::string(request.respHeaderValue("x-test").c_str()), std::string("yes"));
+    CHECK_EQ(std::string(request.responseText().c_str()), std::string("hello"));
+  }
+
+  void huffman()
+  {
+    // RFC 7541 C.4, request examples with Huffman coding, each behind a :status: the dynamic table carries over
+    // from one response to the next on the same connection
+    static const char* const blocks[] =
+    {
+      "8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff",
+      "8286 84be 5886 a8eb 1064 9cbf",
+      "8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf"
+    };
+
+    static const size_t tables[] = { 57, 110, 164 };
+
+    AsyncHTTP2Session h2;
+    AsyncClient*      client = nullptr;
+
+    h2.begin("10.0.0.1");
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+      AsyncHTTPRequest request;
+
+      get(h2, request, "/");
+
+      if ( ! client)
+        handshake(client = fakeLast());
+
+      fakeSent(client);
+      fakeReply(client, frame(HEADERS, END_HEADERS | END_STREAM, 1 + 2 * i, hex("88") + hex(blocks[i])));
+
+      CHECK(request.readyState() == ReadyState::Done);
+      CHECK_EQ(request.responseHTTPcode(), 200);
+      CHECK_EQ(h2.tableSize(), tables[i]);
+
+      if (i == 1)
+        CHECK_EQ(std::string(request.respHeaderValue("cache-control").c_str()), std::string("no-cache"));
+
+      if (i == 2)
+        CHECK_EQ(std::string(request.respHeaderValue("custom-key").c_str()), std::string("custom-value"));
+    }
+
+    CHECK_EQ(h2.opened(), (uint32_t) 3);
+  }
+
+  void windowUpdates()
+  {
+    // The stream's window opens again as the application reads, not before
+    {
+      AsyncHTTP2Session h2;
+      AsyncHTTPRequest  request;
+      uint8_t           buffer[H2_STREAM_WINDOW];
+
+      h2.begin("10.0.0.1");
+      get(h2, request, "/stream");
+
+      AsyncClient* client = fakeLast();
+
+      handshake(client);
+      fakeSent(client);
+
+      fakeReply(client, frame(HEADERS, END_HEADERS, 1, hex("88 0f0d 04") + "8000") +
+                        frame(DATA, 0, 1, std::string(H2_STREAM_WINDOW, 'a')));
+
+      CHECK( ! find(frames(fakeSent(client)), WINDOW_UPDATE, 1));
+      CHECK_EQ(request.responseRead(buffer, sizeof(buffer)), (size_t) H2_STREAM_WINDOW);
+
+      std::string update;
+
+      CHECK(find(frames(fakeSent(client)), WINDOW_UPDATE, 1, &update) && update == uint32(H2_STREAM_WINDOW));
+
+      fakeReply(client, frame(DATA, END_STREAM, 1, std::string(8000 - H2_STREAM_WINDOW, 'b')));
+
+      CHECK(request.readyState() == ReadyState::Done);
+      CHECK_EQ(request.responseRead(buffer, sizeof(buffer)), (size_t) (8000 - H2_STREAM_WINDOW));
+    }
+
+    // The connection's window, given back once half of it has come in
+    {
+      AsyncHTTP2Session h2;
+      AsyncHTTPRequest  request;
+
+      h2.begin("10.0.0.1");
+      request.setMaxResponseLength(40000);
+      get(h2, request, "/large");
+
+      AsyncClient* client = fakeLast();
+
+      handshake(client);
+
+      // A budget over the initial window is granted with the request
+      std::string update;
+
+      CHECK(find(frames(fakeSent(client)), WINDOW_UPDATE, 1, &update) && update == uint32(40000 - H2_STREAM_WINDOW));
+
+      fakeReply(client, frame(HEADERS, END_HEADERS, 1, hex("88 0f0d 05") + "36000"));
+
+      for (int i = 0; i < 3; i++)
+        fakeReply(client, frame(DATA, i == 2 ? END_STREAM : 0, 1, std::string(12000, 'c')));
+
+      CHECK(find(frames(fakeSent(client)), WINDOW_UPDATE, 0, &update) && update == uint32(36000));
+      CHECK(request.readyState() == ReadyState::Done);
+      CHECK_EQ(request.responseHTTPcode(), 200);
+      CHECK_EQ(request.available(), (size_t) 36000);
+    }
+  }
+
+  void goAway()
+  {
+    // GOAWAY with stream 1 as the last: stream 3 was never looked at and goes again on a new connection
+    AsyncHTTP2Session h2;
+    AsyncHTTPRequest  a, b;
+
+    h2.begin("10.0.0.1");
+    get(h2, a, "/a");
+    get(h2, b, "/b");
+
+    AsyncClient* client = fakeLast();
+
+    handshake(client);
+
+    auto out = frames(fakeSent(client));
+
+    CHECK(find(out, HEADERS, 1) && find(out, HEADERS, 3));
+
+    fakeReply(client, frame(GOAWAY, 0, 0, uint32(1) + uint32(0)));
+
+    CHECK(b.readyState() != ReadyState::Done);
+    CHECK_EQ(h2.replays(), (uint32_t) 1);
+
+    // Once stream 1 is done the connection goes
+    fakeReply(client, frame(HEADERS, END_HEADERS | END_STREAM, 1, hex("88")));
+
+    CHECK(a.readyState() == ReadyState::Done);
+    CHECK_EQ(a.responseHTTPcode(), 200);
+    CHECK_EQ(fakeClients().size(), (size_t) 1);
+
+    client = fakeLast();
+
+    CHECK(client && fakeConnecting(client));
+
+    if ( ! client)
+      return;
+
+    handshake(client);
+
+    std::string headers;
+
+    CHECK(find(frames(fakeSent(client)), HEADERS, 1, &headers) && headers.find("/b") != std::string::npos);
+
+    fakeReply(client, frame(HEADERS, END_HEADERS, 1, hex("88 0f0d 01") + "2") + frame(DATA, END_STREAM, 1, "ok"));
+
+    CHECK(b.readyState() == ReadyState::Done);
+    CHECK_EQ(b.responseHTTPcode(), 200);
+    CHECK_EQ(std::string(b.responseText().c_str()), std::string("ok"));
+    CHECK_EQ(h2.opened(), (uint32_t) 3);
+  }
+
+  // Answers a request with a header block too large to take: the connection fails with ENHANCE_YOUR_CALM, and the
+  // request, with nothing of its response, goes again on a new connection where it gets a proper answer
+  void tooLarge(const std::string& wire)
+  {
+    AsyncHTTP2Session h2;
+    AsyncHTTPRequest  request;
+
+    h2.begin("10.0.0.1");
+    get(h2, request, "/large");
+
+    AsyncClient* client = fakeLast();
+
+    handshake(client);
+    fakeSent(client);
+    fakeReply(client, wire);
+
+    CHECK(fakeLast() != client);
+
+    std::string goaway;
+
+    CHECK(find(frames(fakeSentDeleted()), GOAWAY, 0, &goaway) && goaway == uint32(0) + uint32(0xb));
+    CHECK(request.readyState() != ReadyState::Done);
+    CHECK_EQ(h2.replays(), (uint32_t) 1);
+
+    client = fakeLast();
+
+    CHECK(client && fakeConnecting(client));
+
+    if ( ! client)
+      return;
+
+    handshake(client);
+    fakeSent(client);
+    fakeReply(client, frame(HEADERS, END_HEADERS | END_STREAM, 1, hex("88")));
+
+    CHECK(request.readyState() == ReadyState::Done);
+    CHECK_EQ(request.responseHTTPcode(), 200);
+  }
+
+  void headerLimit()
+  {
+    // Over the limit only once CONTINUATION frames add up, each one well under the frame size
+    tooLarge(frame(HEADERS, 0, 1, std::string(5000, 'x')) + frame(CONTINUATION, 0, 1, std::string(5000, 'x')));
+
+    // A small block that decodes to a large list: one 400 byte field into the table, then indexed 20 times over
+    std::string block = hex("88 40 05") + "x-big" + hex("7f 9102") + std::string(400, 'v') + std::string(20, '\xbe');
+
+    tooLarge(frame(HEADERS, END_HEADERS | END_STREAM, 1, block));
+  }
+}
+
+int main()
+{
+  settings();
+  continuation();
+  huffman();
+  windowUpdates();
+  goAway();
+  headerLimit();
+
+  CHECK(fakeClients().empty());
+
+  return testResult("test_h2");
+}
@@ -0,0 +1,79 @@
+// Retry policy against transport errors and the response size limit
+#include "test.h"
+#include "FakeClient.h"
+#include <AsyncHTTPRequest.h>
+
+namespace
+{
+  void abortRetried()
+  {
+    // ERR_ABRT is -13, the same number as RESPONSE_TOO_LARGE: it's a lost connection and is retried
+    AsyncHTTPRetryPolicy retry;
+    AsyncHTTPRequest     request;
+
+    retry.setBackoff(10, 10);
+    request.setRetryPolicy(&retry);
+    request.setMaxResponseLength(1000);
+    request.open(*parseURL("http://10.0.0.1/data"));
+    request.send();
+
+    AsyncClient* client = fakeLast();
+
+    fakeAccept(client);
+    fakeSent(client);
+    fakeReply(client, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n01234");
+    fakeError(client, -13);
+
+    CHECK(request.readyState() != ReadyState::Done);
+
+    fakeAdvance(100);
+
+    client = fakeLast();
+    CHECK(client && fakeConnecting(client));
+
+    if ( ! client)
+      return;
+
+    fakeAccept(client);
+    fakeSent(client);
+    fakeReply(client, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n0123456789");
+
+    CHECK(request.readyState() == ReadyState::Done);
+    CHECK_EQ(request.responseHTTPcode(), 200);
+    CHECK_EQ(retry.retries(), (uint32_t) 1);
+    CHECK_EQ(std::string(request.responseText().c_str()), std::string("0123456789"));
+  }
+
+  void tooLarge()
+  {
+    // Over the limit for real: reported as such, and not retried
+    AsyncHTTPRetryPolicy retry;
+    AsyncHTTPRequest     request;
+
+    request.setRetryPolicy(&retry);
+    request.setMaxResponseLength(100);
+    request.open(*parseURL("http://10.0.0.1/big"));
+    request.send();
+
+    AsyncClient* client = fakeLast();
+
+    fakeAccept(client);
+    fakeSent(client);
+    fakeReply(client, "HTTP/1.1 200 OK\r\nContent-Length: 5000\r\n\r\n");
+
+    CHECK(request.readyState() == ReadyState::Done);
+    CHECK_EQ(request.responseHTTPcode(), (int) HttpCode::RESPONSE_TOO_LARGE);
+    CHECK_EQ(retry.retries(), (uint32_t) 0);
+  }
+}
+
+int main()
+{
+  abortRetried();
+  tooLarge();
+
+  fakeAdvance(100);
+  CHECK(fakeClients().empty());
+
+  return testResult("test_retry");
+}
@@ -0,0 +1,149 @@
+// Timer wheel: deadlines, callbacks that arm, cancel or destroy timers while others are firing, and sleeping
+// through empty ticks
+#include "test.h"
+#include "FakeClient.h"
+#include <AsyncHTTPRequest.h>
+
+namespace
+{
+  struct Probe
+  {
+    AsyncHTTPTimerWheel*  wheel{nullptr};
+    AsyncHTTPTimer*       other{nullptr};
+    int                   fired{0};
+  };
+
+  void count(void* arg)
+  {
+    ((Probe*) arg)->fired++;
+  }
+
+  void deadline()
+  {
+    AsyncHTTPTimerWheel wheel;
+    AsyncHTTPTimer      timer;
+    Probe               probe;
+
+    wheel.arm(timer, 50, count, &probe);
+
+    fakeAdvance(40);
+    CHECK_EQ(probe.fired, 0);
+
+    fakeAdvance(20);
+    CHECK_EQ(probe.fired, 1);
+    CHECK( ! timer.armed());
+    CHECK_EQ(wheel.armed(), (size_t) 0);
+  }
+
+  void cancelDue()
+  {
+    // Both expire on the same tick; whichever fires first cancels the other, which then must not fire
+    AsyncHTTPTimerWheel wheel;
+    AsyncHTTPTimer      a, b;
+    Probe               pa, pb;
+
+    auto cancelOther = [](void* arg)
+    {
+      Probe* probe = (Probe*) arg;
+
+      probe->fired++;
+      probe->wheel->cancel(*probe->other);
+    };
+
+    pa.wheel = pb.wheel = &wheel;
+    pa.other = &b;
+    pb.other = &a;
+
+    wheel.arm(a, 30, cancelOther, &pa);
+    wheel.arm(b, 30, cancelOther, &pb);
+
+    fakeAdvance(100);
+
+    CHECK_EQ(pa.fired + pb.fired, 1);
+    CHECK_EQ(wheel.armed(), (size_t) 0);
+    CHECK_EQ(wheel.fired(), (uint32_t) 1);
+  }
+
+  void again(void* arg)
+  {
+    Probe* probe = (Probe*) arg;
+
+    if (++probe->fired < 3)
+      probe->wheel->arm(*probe->other, 20, again, probe);
+  }
+
+  void rearm()
+  {
+    // A callback re-arming its own timer, and a timer destroyed while armed
+    AsyncHTTPTimerWheel wheel;
+    AsyncHTTPTimer      timer;
+    AsyncHTTPTimer*     doomed = new AsyncHTTPTimer;
+    Probe               probe, gone;
+
+    probe.wheel = &wheel;
+    probe.other = &timer;
+
+    wheel.arm(timer, 20, again, &probe);
+    wheel.arm(*doomed, 20, count, &gone);
+
+    delete doomed;
+    CHECK_EQ(wheel.armed(), (size_t) 1);
+
+    // A timer re-armed from its callback is due on a later run, not the one that fired it
+    for (int i = 0; i < 10; i++)
+      fakeAdvance(30);
+
+    CHECK_EQ(probe.fired, 3);
+    CHECK_EQ(gone.fired, 0);
+    CHECK_EQ(wheel.armed(), (size_t) 0);
+  }
+
+  void sleeps()
+  {
+    // Only long timers armed: the Ticker goes off for the slots they sit in, not every tick on the way
+    AsyncHTTPTimerWheel wheel;
+    AsyncHTTPTimer      soon, later, far;
+    Probe               ps, pl, pf;
+
+    wheel.arm(later, 600000, count, &pl);
+    wheel.arm(far, 2 * 3600000UL, count, &pf);
+
+    fakeAdvance(5000);
+    CHECK(wheel.wakeups() <= 1);
+
+    // Sooner than the Ticker was set for, it is brought forward
+    uint32_t wakeups = wheel.wakeups();
+
+    wheel.arm(soon, 50, count, &ps);
+
+    fakeAdvance(100);
+    CHECK_EQ(ps.fired, 1);
+    CHECK(wheel.wakeups() - wakeups <= 2);
+
+    fakeAdvance(600000 - 5100 - 100);
+    CHECK_EQ(pl.fired, 0);
+
+    fakeAdvance(200);
+    CHECK_EQ(pl.fired, 1);
+
+    fakeAdvance(2 * 3600000UL - 600100 - 100);
+    CHECK_EQ(pf.fired, 0);
+
+    fakeAdvance(200);
+    CHECK_EQ(pf.fired, 1);
+    CHECK_EQ(wheel.armed(), (size_t) 0);
+
+    // Two hours of wheel in a handful of wakeups, not 720000 of them
+    CHECK(wheel.wakeups() < 20);
+  }
+}
+
+int main()
+{
+  deadline();
+  cancelDue();
+  rearm();
+  sleeps();
+
+  return testResult("test_timers");
+}
@@ -0,0 +1,141 @@
+// Streaming JSON extraction: pointers, escapes, malformed documents and feeding from a response
+#include "test.h"
+#include "FakeClient.h"
+#include <AsyncHTTPRequest.h>
+
+namespace
+{
+  bool valid(const char* doc)
+  {
+    xjson json;
+
+    json.parse(doc);
+
+    return json.complete() && ! json.error();
+  }
+
+  void pointers()
+  {
+    xjson json(8, 32);
+
+    json.watch("/a/b/1");
+    json.watch("/name");
+    json.watch("/x~1y");
+    json.watch("/e");
+    json.watch("/missing");
+
+    const char* doc = "{\"a\": {\"b\": [1, 2.5e3, true], \"c\": []}, \"name\":\"h\\u00e9llo \\ud83d\\ude00\\n\", "
+                      "\"x/y\": null, \"e\": {}, \"z\": -1}";
+
+    // One byte at a time, the worst a response can be split
+    for (const char* p = doc; *p; p++)
+      json.parse((const uint8_t*) p, 1);
+
+    CHECK(json.complete());
+    CHECK_EQ(json.value("/a/b/1"), String("2.5e3"));
+    CHECK_EQ(json.value("/name"), String("h\xc3\xa9llo \xf0\x9f\x98\x80\n"));
+    CHECK(json.found("/x~1y"));
+    CHECK( ! json.found("/e"));
+    CHECK( ! json.found("/missing"));
+  }
+
+  void callback()
+  {
+    xjson       json;
+    std::string seen;
+
+    json.onValue([](void* arg, const String& pointer, JsonType type, const String& value)
+    {
+      *(std::string*) arg += std::string(pointer.c_str()) + "=" + value.c_str() + ";";
+    }, &seen);
+
+    json.parse("[{\"k\":\"v\"},[false,null],3]");
+
+    CHECK(json.complete());
+    CHECK_EQ(seen, std::string("/0/k=v;/1/0=false;/1/1=null;/2=3;"));
+  }
+
+  void trailingCommas()
+  {
+    CHECK(valid("{}"));
+    CHECK(valid("[]"));
+    CHECK(valid("{\"a\":{},\"b\":[]}"));
+    CHECK(valid("{\"a\":1,\"b\":2}"));
+
+    CHECK( ! valid("{\"a\":1,}"));
+    CHECK( ! valid("{\"a\":{\"b\":1,},\"c\":2}"));
+    CHECK( ! valid("[1,]"));
+    CHECK( ! valid("[1,2,]"));
+    CHECK( ! valid("{,}"));
+    CHECK( ! valid("[,]"));
+    CHECK( ! valid("{\"a\":1,,\"b\":2}"));
+  }
+
+  void malformed()
+  {
+    CHECK( ! valid("{\"a\" 1}"));
+    CHECK( ! valid("{\"a\":1]"));
+    CHECK( ! valid("[1}"));
+    CHECK( ! valid("{a:1}"));
+    CHECK( ! valid("\"\\x\""));
+
+    // Deeper than the parser was made for
+    xjson shallow(2);
+
+    shallow.parse("[[[1]]]");
+    CHECK(shallow.error());
+  }
+
+  void fromResponse()
+  {
+    // Fed from the response as it arrives, nothing buffered unless asked for
+    AsyncHTTPRequest request;
+    xjson            json;
+
+    json.watch("/data/2/temp");
+    request.setJsonParser(&json);
+    request.open(*parseURL("http://10.0.0.1/sensors"));
+    request.send();
+
+    AsyncClient* client = fakeLast();
+    fakeAccept(client);
+    fakeSent(client);
+
+    std::string body = "{\"data\":[";
+
+    for (int i = 0; i < 200; i++)
+      body += std::string(i ? "," : "") + "{\"id\":" + std::to_string(i) + ",\"temp\":" + std::to_string(20 + i % 7) + ".5}";
+
+    body += "]}";
+
+    fakeReply(client, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n");
+
+    for (size_t at = 0; at < body.size(); at += 333)
+    {
+      std::string chunk = body.substr(at, 333);
+      char        size[16];
+
+      snprintf(size, sizeof(size), "%zx\r\n", chunk.size());
+      fakeReply(client, size + chunk + "\r\n");
+    }
+
+    fakeReply(client, "0\r\n\r\n");
+
+    CHECK(request.readyState() == ReadyState::Done);
+    CHECK_EQ(request.responseHTTPcode(), 200);
+    CHECK(json.complete());
+    CHECK_EQ(json.value("/data/2/temp"), String("22.5"));
+    CHECK_EQ(request.available(), (size_t) 0);
+  }
+}
+
+int main()
+{
+  pointers();
+  callback();
+  trailingCommas();
+  malformed();
+  fromResponse();
+
+  return testResult("test_xjson");
+}